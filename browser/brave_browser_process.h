@@ -36,6 +36,7 @@ class AdBlockService;
 class AdBlockCustomFiltersService;
 class AdBlockRegionalServiceManager;
 class HTTPSEverywhereService;
+class QueryStringTrackersService;
 }  // namespace brave_shields
 
 namespace brave_stats {
@@ -89,6 +90,8 @@ class BraveBrowserProcess {
   virtual brave_shields::HTTPSEverywhereService* https_everywhere_service() = 0;
   virtual brave_component_updater::LocalDataFilesService*
   local_data_files_service() = 0;
+  virtual brave_shields::QueryStringTrackersService*
+  query_string_trackers_service() = 0;
 #if BUILDFLAG(ENABLE_TOR)
   virtual tor::BraveTorClientUpdater* tor_client_updater() = 0;
 #endif
@@ -27,6 +27,7 @@
 #include "brave/components/brave_shields/browser/ad_block_regional_service_manager.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
 #include "brave/components/brave_shields/browser/https_everywhere_service.h"
+#include "brave/components/brave_shields/browser/query_string_trackers_service.h"
 #include "brave/components/brave_sync/buildflags/buildflags.h"
 #include "brave/components/brave_sync/network_time_helper.h"
 #include "brave/components/ntp_background_images/browser/features.h"
@@ -179,6 +180,7 @@ void BraveBrowserProcessImpl::StartBraveServices() {
 
   ad_block_service()->Start();
   https_everywhere_service()->Start();
+  query_string_trackers_service();
 
 #if BUILDFLAG(ENABLE_EXTENSIONS)
   extension_whitelist_service();
@@ -275,6 +277,15 @@ BraveBrowserProcessImpl::local_data_files_service() {
   return local_data_files_service_.get();
 }
 
+brave_shields::QueryStringTrackersService*
+BraveBrowserProcessImpl::query_string_trackers_service() {
+  if (!query_string_trackers_service_)
+    query_string_trackers_service_ =
+        brave_shields::QueryStringTrackersServiceFactory(
+            local_data_files_service());
+  return query_string_trackers_service_.get();
+}
+
 void BraveBrowserProcessImpl::UpdateBraveDarkMode() {
   // Update with proper system theme to make brave theme and base ui components
   // theme use same theme.
@@ -37,6 +37,7 @@ class AdBlockService;
 class AdBlockCustomFiltersService;
 class AdBlockRegionalServiceManager;
 class HTTPSEverywhereService;
+class QueryStringTrackersService;
 }  // namespace brave_shields
 
 namespace brave_stats {
@@ -98,6 +99,8 @@ class BraveBrowserProcessImpl : public BraveBrowserProcess,
   brave_shields::HTTPSEverywhereService* https_everywhere_service() override;
   brave_component_updater::LocalDataFilesService* local_data_files_service()
       override;
+  brave_shields::QueryStringTrackersService* query_string_trackers_service()
+      override;
 #if BUILDFLAG(ENABLE_TOR)
   tor::BraveTorClientUpdater* tor_client_updater() override;
 #endif
@@ -151,6 +154,8 @@ class BraveBrowserProcessImpl : public BraveBrowserProcess,
 #endif
   std::unique_ptr<brave_shields::HTTPSEverywhereService>
       https_everywhere_service_;
+  std::unique_ptr<brave_shields::QueryStringTrackersService>
+      query_string_trackers_service_;
   std::unique_ptr<brave_stats::BraveStatsUpdater> brave_stats_updater_;
 #if BUILDFLAG(ENABLE_BRAVE_REFERRALS)
   std::unique_ptr<brave::BraveReferralsService> brave_referrals_service_;
@@ -35,6 +35,7 @@
 #include "brave/components/brave_search/common/brave_search_fallback.mojom.h"
 #include "brave/components/brave_search/common/brave_search_utils.h"
 #include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "brave/components/brave_shields/browser/cosmetic_resources_prefetch_throttle.h"
 #include "brave/components/brave_shields/browser/domain_block_navigation_throttle.h"
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
 #include "brave/components/brave_wallet/common/buildflags/buildflags.h"
@@ -681,6 +682,14 @@ BraveContentBrowserClient::CreateThrottlesForNavigation(
               g_browser_process->GetApplicationLocale()))
     throttles.push_back(std::move(domain_block_navigation_throttle));
 
+  if (std::unique_ptr<content::NavigationThrottle>
+          cosmetic_resources_prefetch_throttle = brave_shields::
+              CosmeticResourcesPrefetchThrottle::MaybeCreateThrottleFor(
+                  handle, g_brave_browser_process->ad_block_service(),
+                  HostContentSettingsMapFactory::GetForProfile(
+                      Profile::FromBrowserContext(context))))
+    throttles.push_back(std::move(cosmetic_resources_prefetch_throttle));
+
   return throttles;
 }
 
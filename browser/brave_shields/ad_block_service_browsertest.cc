@@ -11,12 +11,16 @@
 
 #include "base/base64.h"
 #include "base/path_service.h"
+#include "base/run_loop.h"
 #include "base/task/post_task.h"
+#include "base/test/bind.h"
+#include "base/test/metrics/histogram_tester.h"
 #include "base/test/thread_test_helper.h"
 #include "brave/browser/brave_browser_process.h"
 #include "brave/browser/net/brave_ad_block_tp_network_delegate_helper.h"
 #include "brave/common/brave_paths.h"
 #include "brave/common/pref_names.h"
+#include "brave/components/adblock_rust_ffi/src/wrapper.h"
 #include "brave/components/brave_component_updater/browser/local_data_files_service.h"
 #include "brave/components/brave_shields/browser/ad_block_custom_filters_service.h"
 #include "brave/components/brave_shields/browser/ad_block_regional_service.h"
@@ -40,6 +44,7 @@
 #include "extensions/test/extension_test_message_listener.h"
 #include "net/dns/mock_host_resolver.h"
 #include "services/network/host_resolver.h"
+#include "testing/perf/perf_result_reporter.h"
 
 const char kAdBlockTestPage[] = "/blocking.html";
 
@@ -68,8 +73,11 @@ const char kRegionalAdBlockComponentTest64PublicKey[] =
     "ieMF3JB9CZPr+qDKIap+RZUfsraV47QebRi/JA17nbDMlXOmK7mILfFU7Jhjx04F"
     "LwIDAQAB";
 
+using brave_shields::features::kBraveAdblockBatchMatching;
 using brave_shields::features::kBraveAdblockCnameUncloaking;
 using brave_shields::features::kBraveAdblockCosmeticFiltering;
+using brave_shields::features::kBraveAdblockCosmeticFilteringNative;
+using brave_shields::features::kBraveRequestHandlerOffUIThread;
 using content::BrowserThread;
 
 void AdBlockServiceTest::SetUpOnMainThread() {
@@ -227,6 +235,27 @@ void AdBlockServiceTest::ShieldsDown(const GURL& url) {
   brave_shields::SetBraveShieldsEnabled(content_settings(), false, url);
 }
 
+bool AdBlockServiceTest::ShouldBlockRequest(const GURL& url,
+                                            const std::string& tab_host) {
+  brave_shields::AdBlockService* service =
+      g_brave_browser_process->ad_block_service();
+  bool did_match_rule = false;
+  bool did_match_exception = false;
+  bool did_match_important = false;
+  std::string mock_data_url;
+  base::RunLoop run_loop;
+  service->GetTaskRunner()->PostTaskAndReply(
+      FROM_HERE, base::BindLambdaForTesting([&]() {
+        service->ShouldStartRequest(url, blink::mojom::ResourceType::kImage,
+                                    tab_host, &did_match_rule,
+                                    &did_match_exception, &did_match_important,
+                                    &mock_data_url);
+      }),
+      run_loop.QuitClosure());
+  run_loop.Run();
+  return did_match_important || (did_match_rule && !did_match_exception);
+}
+
 // Load a page with an ad image, and make sure it is blocked.
 IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, AdsGetBlockedByDefaultBlocker) {
   ASSERT_TRUE(InstallDefaultAdBlockExtension());
@@ -895,6 +924,145 @@ IN_PROC_BROWSER_TEST_F(CnameUncloakingFlagDisabledTest, NoDnsQueriesIssued) {
   brave::SetAdblockCnameHostResolverForTesting(nullptr);
 }
 
+class RequestHandlerOffUIThreadTest : public AdBlockServiceTest {
+ public:
+  RequestHandlerOffUIThreadTest() {
+    feature_list_.InitAndEnableFeature(kBraveRequestHandlerOffUIThread);
+  }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// Blocking decisions must not change when part of the request pipeline runs
+// off the UI thread.
+IN_PROC_BROWSER_TEST_F(RequestHandlerOffUIThreadTest,
+                       AdsGetBlockedByDefaultBlocker) {
+  ASSERT_TRUE(InstallDefaultAdBlockExtension());
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 0ULL);
+
+  GURL url = embedded_test_server()->GetURL(kAdBlockTestPage);
+  ui_test_utils::NavigateToURL(browser(), url);
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  ASSERT_EQ(true, EvalJs(contents,
+                         "setExpectations(0, 1, 0, 0);"
+                         "addImage('ad_banner.png')"));
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 1ULL);
+}
+
+IN_PROC_BROWSER_TEST_F(RequestHandlerOffUIThreadTest,
+                       DefaultBlockCustomException) {
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 0ULL);
+  UpdateAdBlockInstanceWithRules("*ad_banner.png");
+  ASSERT_TRUE(g_brave_browser_process->ad_block_custom_filters_service()
+                  ->UpdateCustomFilters("@@ad_banner.png"));
+
+  GURL url = embedded_test_server()->GetURL(kAdBlockTestPage);
+  ui_test_utils::NavigateToURL(browser(), url);
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  ASSERT_EQ(true, EvalJs(contents,
+                         "setExpectations(1, 0, 0, 0);"
+                         "addImage('ad_banner.png')"));
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 0ULL);
+}
+
+// The ad block stage runs after the off-thread stages hand the request back
+// to the UI thread, and still blocks, redirects and counts.
+IN_PROC_BROWSER_TEST_F(RequestHandlerOffUIThreadTest,
+                       RedirectRulesAreRespected) {
+  UpdateAdBlockInstanceWithRules("js_mock_me.js$redirect=noopjs\n"
+                                 "adbanner.js",
+                                 R"(
+      [
+        {
+          "name": "noop.js",
+          "aliases": ["noopjs"],
+          "kind": {
+            "mime":"application/javascript"
+          },
+          "content": "KGZ1bmN0aW9uKCkgewogICAgJ3VzZSBzdHJpY3QnOwp9KSgpOwo="
+        }
+      ])");
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 0ULL);
+
+  const GURL url =
+      embedded_test_server()->GetURL("example.com", kAdBlockTestPage);
+  ui_test_utils::NavigateToURL(browser(), url);
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  const std::string noopjs = "(function() {\\n    \\'use strict\\';\\n})();\\n";
+  const GURL resource_url =
+      embedded_test_server()->GetURL("example.com", "/js_mock_me.js");
+  ASSERT_EQ(true,
+            EvalJs(contents, base::StringPrintf(
+                                 "setExpectations(0, 0, 1, 0);"
+                                 "xhr_expect_content('%s', '%s');",
+                                 resource_url.spec().c_str(), noopjs.c_str())));
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 1ULL);
+
+  ASSERT_EQ(true, EvalJs(contents,
+                         "setExpectations(0, 0, 1, 1);"
+                         "xhr('adbanner.js')"));
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 2ULL);
+}
+
+IN_PROC_BROWSER_TEST_F(RequestHandlerOffUIThreadTest, SubFrameShieldsOff) {
+  ASSERT_TRUE(InstallDefaultAdBlockExtension());
+
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 0ULL);
+  GURL url = embedded_test_server()->GetURL("a.com", "/iframe_blocking.html");
+
+  brave_shields::SetBraveShieldsEnabled(content_settings(), false, url);
+
+  ui_test_utils::NavigateToURL(browser(), url);
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  EXPECT_EQ(true, EvalJs(contents->GetAllFrames()[1],
+                         "setExpectations(0, 0, 1, 0);"
+                         "xhr('adbanner.js?1')"));
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 0ULL);
+  brave_shields::ResetBraveShieldsEnabled(content_settings(), url);
+}
+
+class AdBlockBatchMatchingTest : public AdBlockServiceTest {
+ public:
+  AdBlockBatchMatchingTest() {
+    feature_list_.InitAndEnableFeature(kBraveAdblockBatchMatching);
+  }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// Requests matched in a batch are blocked, and each block is still reported
+// to the shields panel.
+IN_PROC_BROWSER_TEST_F(AdBlockBatchMatchingTest, TwoDiffAdsGetCountedAsTwo) {
+  ASSERT_TRUE(InstallDefaultAdBlockExtension());
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 0ULL);
+
+  GURL url = embedded_test_server()->GetURL(kAdBlockTestPage);
+  ui_test_utils::NavigateToURL(browser(), url);
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  ASSERT_EQ(true, EvalJs(contents,
+                         "setExpectations(0, 0, 0, 1);"
+                         "xhr('adbanner.js?1')"));
+  ASSERT_EQ(true, EvalJs(contents,
+                         "setExpectations(0, 0, 1, 1);"
+                         "xhr('normal.js')"));
+  ASSERT_EQ(true, EvalJs(contents,
+                         "setExpectations(0, 0, 1, 2);"
+                         "xhr('adbanner.js?2')"));
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 2ULL);
+}
+
 // Load an image from a specific subdomain, and make sure it is blocked.
 IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, BlockNYP) {
   UpdateAdBlockInstanceWithRules("||sp1.nypost.com$third-party");
@@ -988,6 +1156,67 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, ResetPreservesTags) {
   AssertTagExists(brave_shields::kFacebookEmbeds, true);
 }
 
+// Cached verdicts are dropped when the default engine is replaced.
+IN_PROC_BROWSER_TEST_F(AdBlockServiceTest,
+                       VerdictCacheInvalidatedOnUpdateAdBlockClient) {
+  const GURL url("https://example.com/ad_banner.png");
+  UpdateAdBlockInstanceWithRules("");
+  EXPECT_FALSE(ShouldBlockRequest(url, "b.com"));
+  EXPECT_FALSE(ShouldBlockRequest(url, "b.com"));
+
+  brave_shields::AdBlockService* service =
+      g_brave_browser_process->ad_block_service();
+  base::RunLoop run_loop;
+  service->GetTaskRunner()->PostTaskAndReply(
+      FROM_HERE, base::BindLambdaForTesting([service]() {
+        service->UpdateAdBlockClient(
+            std::make_unique<adblock::Engine>("*ad_banner.png"));
+      }),
+      run_loop.QuitClosure());
+  run_loop.Run();
+  EXPECT_TRUE(ShouldBlockRequest(url, "b.com"));
+}
+
+// Cached verdicts are dropped when a tag is enabled or disabled.
+IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, VerdictCacheInvalidatedOnEnableTag) {
+  const GURL url("https://example.com/logo.png");
+  UpdateAdBlockInstanceWithRules(base::StringPrintf(
+      "||example.com^$tag=%s", brave_shields::kFacebookEmbeds));
+  EXPECT_FALSE(ShouldBlockRequest(url, "b.com"));
+  EXPECT_FALSE(ShouldBlockRequest(url, "b.com"));
+
+  g_brave_browser_process->ad_block_service()->EnableTag(
+      brave_shields::kFacebookEmbeds, true);
+  WaitForAdBlockServiceThreads();
+  EXPECT_TRUE(ShouldBlockRequest(url, "b.com"));
+  EXPECT_TRUE(ShouldBlockRequest(url, "b.com"));
+
+  g_brave_browser_process->ad_block_service()->EnableTag(
+      brave_shields::kFacebookEmbeds, false);
+  WaitForAdBlockServiceThreads();
+  EXPECT_FALSE(ShouldBlockRequest(url, "b.com"));
+}
+
+// Cached verdicts are dropped when the custom filters change.
+IN_PROC_BROWSER_TEST_F(AdBlockServiceTest,
+                       VerdictCacheInvalidatedOnCustomFilters) {
+  const GURL url("https://example.com/ad_banner.png");
+  UpdateAdBlockInstanceWithRules("");
+  EXPECT_FALSE(ShouldBlockRequest(url, "b.com"));
+  EXPECT_FALSE(ShouldBlockRequest(url, "b.com"));
+
+  ASSERT_TRUE(g_brave_browser_process->ad_block_custom_filters_service()
+                  ->UpdateCustomFilters("*ad_banner.png"));
+  WaitForAdBlockServiceThreads();
+  EXPECT_TRUE(ShouldBlockRequest(url, "b.com"));
+  EXPECT_TRUE(ShouldBlockRequest(url, "b.com"));
+
+  ASSERT_TRUE(g_brave_browser_process->ad_block_custom_filters_service()
+                  ->UpdateCustomFilters("*ad_banner.png\n@@ad_banner.png"));
+  WaitForAdBlockServiceThreads();
+  EXPECT_FALSE(ShouldBlockRequest(url, "b.com"));
+}
+
 // Setting prefs sets the right tags
 IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, TagPrefsControlTags) {
   auto* prefs = browser()->profile()->GetPrefs();
@@ -1265,6 +1494,43 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, CosmeticFilteringSimple) {
   EXPECT_EQ(base::Value(true), result_third.value);
 }
 
+// The cosmetic resources for a navigation are computed when its request
+// starts, so the frame's own lookup after commit is a cache hit.
+IN_PROC_BROWSER_TEST_F(AdBlockServiceTest,
+                       CosmeticResourcesWarmedAtNavigationStart) {
+  UpdateAdBlockInstanceWithRules("b.com##.ad");
+
+  WaitForBraveExtensionShieldsDataReady();
+
+  base::HistogramTester histogram_tester;
+  GURL tab_url =
+      embedded_test_server()->GetURL("b.com", "/cosmetic_filtering.html");
+  ui_test_utils::NavigateToURL(browser(), tab_url);
+
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  auto result = EvalJsWithManualReply(contents,
+                                      R"(function waitCSSSelector() {
+          if (checkSelector('.ad', 'display', 'none')) {
+            window.domAutomationController.send(true);
+          } else {
+            console.log('still waiting for css selector');
+            setTimeout(waitCSSSelector, 200);
+          }
+        } waitCSSSelector())");
+  ASSERT_TRUE(result.error.empty());
+  EXPECT_EQ(base::Value(true), result.value);
+
+  // Only lookups from frames are recorded, and the warm-up reached the
+  // adblock task runner before any of them.
+  histogram_tester.ExpectBucketCount(
+      "Brave.Adblock.CosmeticResourcesCache.Hit", false, 0);
+  EXPECT_GE(histogram_tester.GetBucketCount(
+                "Brave.Adblock.CosmeticResourcesCache.Hit", true),
+            1);
+}
+
 // Test cosmetic filtering ignores content determined to be 1st party
 // This is disabled due to https://github.com/brave/brave-browser/issues/13882
 #define MAYBE_CosmeticFilteringProtect1p DISABLED_CosmeticFilteringProtect1p
@@ -1378,6 +1644,120 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, CosmeticFilteringGenerichide) {
                    "'display', 'inline')"));
 }
 
+class CosmeticFilteringNativeTest : public AdBlockServiceTest {
+ public:
+  CosmeticFilteringNativeTest() {
+    feature_list_.InitAndEnableFeature(kBraveAdblockCosmeticFilteringNative);
+  }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// Time from inserting 10k elements with distinct classes until the one
+// matching a generic rule is hidden, covering the renderer to browser round
+// trip for class selectors.
+IN_PROC_BROWSER_TEST_F(CosmeticFilteringNativeTest, ManyClassesLatency) {
+  UpdateAdBlockInstanceWithRules("##.cf-target-9999");
+
+  WaitForBraveExtensionShieldsDataReady();
+
+  GURL tab_url =
+      embedded_test_server()->GetURL("b.com", "/cosmetic_filtering.html");
+  ui_test_utils::NavigateToURL(browser(), tab_url);
+
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  auto result = EvalJsWithManualReply(contents,
+                                      R"((function() {
+          const start = performance.now();
+          const fragment = document.createDocumentFragment();
+          for (let i = 0; i < 10000; i++) {
+            const div = document.createElement('div');
+            div.className = 'cf-target-' + i;
+            div.innerText = i;
+            fragment.appendChild(div);
+          }
+          document.body.appendChild(fragment);
+          function waitCSSSelector() {
+            if (checkSelector('.cf-target-9999', 'display', 'none')) {
+              window.domAutomationController.send(performance.now() - start);
+            } else {
+              setTimeout(waitCSSSelector, 10);
+            }
+          }
+          waitCSSSelector();
+        })())");
+  ASSERT_TRUE(result.error.empty());
+  ASSERT_TRUE(result.value.is_double() || result.value.is_int());
+  EXPECT_EQ(true, EvalJs(contents,
+                         "checkSelector('.cf-target-9998', 'display', "
+                         "'block')"));
+
+  perf_test::PerfResultReporter reporter("CosmeticFiltering", "10k_classes");
+  reporter.RegisterImportantMetric(".time_to_hide", "ms");
+  reporter.AddResult(".time_to_hide", result.value.GetDouble());
+}
+
+// Class names are only sent to the browser once per document, until the ad
+// block rules change and the next answer makes the page ask again.
+IN_PROC_BROWSER_TEST_F(CosmeticFilteringNativeTest,
+                       QueriedClassesResetWithRules) {
+  UpdateAdBlockInstanceWithRules("##.cf-ready");
+
+  WaitForBraveExtensionShieldsDataReady();
+
+  GURL tab_url =
+      embedded_test_server()->GetURL("b.com", "/cosmetic_filtering.html");
+  ui_test_utils::NavigateToURL(browser(), tab_url);
+
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  // Adds an image with the given class name and waits until the elements
+  // matching the given class are hidden.
+  const char kAddHiddenElementScript[] = R"((function() {
+          const e = document.createElement('img');
+          e.src = 'https://example.com/logo.png';
+          e.className = '%s';
+          document.documentElement.appendChild(e);
+        })();
+        function waitForHidden() {
+          if ([].slice.call(document.querySelectorAll('.%s')).every(
+                  e => window.getComputedStyle(e).display === 'none')) {
+            window.domAutomationController.send(true);
+          } else {
+            setTimeout(waitForHidden, 50);
+          }
+        } waitForHidden())";
+
+  // Once the element added after them is hidden, the names added by
+  // addElementsDynamically() were answered by the current rules.
+  ASSERT_TRUE(ExecJs(contents, "addElementsDynamically()"));
+  auto result_first = EvalJsWithManualReply(
+      contents,
+      base::StringPrintf(kAddHiddenElementScript, "cf-ready", "cf-ready"));
+  ASSERT_TRUE(result_first.error.empty());
+  EXPECT_EQ(base::Value(true), result_first.value);
+
+  UpdateAdBlockInstanceWithRules("##.cf-ready\n##.blockme");
+
+  // The same names again are not queried, so the new rule doesn't apply yet.
+  ASSERT_TRUE(ExecJs(contents, "addElementsDynamically()"));
+  EXPECT_EQ(true, EvalJs(contents, R"([].slice.call(
+        document.querySelectorAll('.blockme')).every(
+            e => window.getComputedStyle(e).display !== 'none'))"));
+
+  // The answer for a new name comes from the new rules, which makes the page
+  // query all of its names again.
+  auto result_second = EvalJsWithManualReply(
+      contents,
+      base::StringPrintf(kAddHiddenElementScript, "cf-trigger", "blockme"));
+  ASSERT_TRUE(result_second.error.empty());
+  EXPECT_EQ(base::Value(true), result_second.value);
+}
+
 // Test custom style rules
 IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, CosmeticFilteringCustomStyle) {
   UpdateAdBlockInstanceWithRules("b.com##.ad:style(padding-bottom: 10px)");
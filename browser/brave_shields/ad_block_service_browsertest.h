@@ -38,6 +38,9 @@ class AdBlockServiceTest : public extensions::ExtensionBrowserTest {
   void WaitForAdBlockServiceThreads();
   void WaitForBraveExtensionShieldsDataReady();
   void ShieldsDown(const GURL& url);
+  // Matches |url| against the adblock engines on their task runner, as a
+  // request from |tab_host| would be, and returns whether it gets blocked.
+  bool ShouldBlockRequest(const GURL& url, const std::string& tab_host);
 };
 
 #endif  // BRAVE_BROWSER_BRAVE_SHIELDS_AD_BLOCK_SERVICE_BROWSERTEST_H_
@@ -24,11 +24,33 @@
 #include "content/public/test/browser_test.h"
 #include "content/public/test/browser_test_utils.h"
 #include "net/dns/mock_host_resolver.h"
+#include "testing/perf/perf_result_reporter.h"
 
 using brave_shields::ControlType;
 
 const char kEmbeddedTestServerDirectory[] = "webaudio";
 const char kTitleScript[] = "domAutomationController.send(document.title);";
+// Average milliseconds per call of the WebAudio getters fingerprinting scripts
+// read, over a one second 48kHz buffer and a 32768 point analyser.
+const char kFarblingPerfScript[] = R"((function() {
+  const iterations = 100;
+  const sampleRate = 48000;
+  const ctx = new OfflineAudioContext(1, sampleRate, sampleRate);
+  const audioBuffer = ctx.createBuffer(1, sampleRate, sampleRate);
+  let start = performance.now();
+  for (let i = 0; i < iterations; i++)
+    audioBuffer.getChannelData(0);
+  const getChannelData = (performance.now() - start) / iterations;
+
+  const analyser = ctx.createAnalyser();
+  analyser.fftSize = 32768;
+  const frequencyData = new Float32Array(analyser.frequencyBinCount);
+  start = performance.now();
+  for (let i = 0; i < iterations; i++)
+    analyser.getFloatFrequencyData(frequencyData);
+  const getFloatFrequencyData = (performance.now() - start) / iterations;
+  return [getChannelData, getFloatFrequencyData];
+})())";
 
 class BraveWebAudioFarblingBrowserTest : public InProcessBrowserTest {
  public:
@@ -141,3 +163,29 @@ IN_PROC_BROWSER_TEST_F(BraveWebAudioFarblingBrowserTest, FarbleWebAudio) {
   NavigateToURLUntilLoadStop(farbling_url());
   EXPECT_EQ(ExecScriptGetStr(kTitleScript, contents()), "8000");
 }
+
+IN_PROC_BROWSER_TEST_F(BraveWebAudioFarblingBrowserTest, FarblingPerf) {
+  perf_test::PerfResultReporter reporter("WebAudioFarbling", "48kHz");
+  auto measure = [&](const std::string& level) {
+    NavigateToURLUntilLoadStop(farbling_url());
+    auto result = content::EvalJs(contents(), kFarblingPerfScript);
+    ASSERT_TRUE(result.error.empty());
+    const auto& timings = result.value.GetList();
+    ASSERT_EQ(2u, timings.size());
+
+    const std::string get_channel_data = ".getChannelData" + level;
+    const std::string get_float_frequency_data =
+        ".getFloatFrequencyData" + level;
+    reporter.RegisterImportantMetric(get_channel_data, "ms");
+    reporter.RegisterImportantMetric(get_float_frequency_data, "ms");
+    reporter.AddResult(get_channel_data, timings[0].GetDouble());
+    reporter.AddResult(get_float_frequency_data, timings[1].GetDouble());
+  };
+
+  AllowFingerprinting();
+  measure(".off");
+  SetFingerprintingDefault();
+  measure(".balanced");
+  BlockFingerprinting();
+  measure(".maximum");
+}
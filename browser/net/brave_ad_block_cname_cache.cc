@@ -0,0 +1,160 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/brave_ad_block_cname_cache.h"
+
+#include <memory>
+#include <utility>
+
+#include "base/time/default_tick_clock.h"
+#include "chrome/browser/net/proxy_service_factory.h"
+#include "chrome/browser/profiles/profile.h"
+#include "components/proxy_config/pref_proxy_config_tracker.h"
+#include "content/public/browser/browser_context.h"
+#include "content/public/browser/browser_thread.h"
+#include "net/proxy_resolution/proxy_config.h"
+#include "net/proxy_resolution/proxy_config_with_annotation.h"
+
+namespace brave {
+
+namespace {
+
+const char kAdBlockCnameCacheKey[] = "brave_ad_block_cname_cache";
+
+constexpr size_t kMaxCachedCnames = 256;
+
+// The network service already honours DNS TTLs in its own host cache, but
+// doesn't report them through ResolveHost, so results are kept here for a
+// short fixed time only.
+constexpr base::TimeDelta kCnameLifetime = base::TimeDelta::FromMinutes(1);
+
+}  // namespace
+
+AdBlockCnameCache::AdBlockCnameCache(Profile* profile)
+    : entries_(kMaxCachedCnames),
+      clock_(base::DefaultTickClock::GetInstance()) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  if (!profile)
+    return;
+  proxy_config_tracker_ =
+      ProxyServiceFactory::CreatePrefProxyConfigTrackerOfProfile(
+          profile->GetPrefs(), nullptr);
+  proxy_config_service_ =
+      ProxyServiceFactory::CreateProxyConfigService(proxy_config_tracker_.get());
+  proxy_config_service_->AddObserver(this);
+  profile_observation_.Observe(profile);
+  UpdateProxySettingsAllowUncloaking();
+}
+
+AdBlockCnameCache::~AdBlockCnameCache() {
+  ResetProxyConfigService();
+  // OnResolved() is bound to a WeakPtr, so lookups still in flight will never
+  // complete. Let the waiting requests continue without uncloaking rather
+  // than leaving them stalled.
+  std::map<Key, std::vector<CnameCallback>> pending_lookups;
+  pending_lookups.swap(pending_lookups_);
+  for (auto& pending_lookup : pending_lookups) {
+    for (auto& callback : pending_lookup.second)
+      std::move(callback).Run(base::nullopt);
+  }
+}
+
+// static
+AdBlockCnameCache* AdBlockCnameCache::GetForBrowserContext(
+    content::BrowserContext* browser_context) {
+  DCHECK(browser_context);
+  AdBlockCnameCache* cache = static_cast<AdBlockCnameCache*>(
+      browser_context->GetUserData(kAdBlockCnameCacheKey));
+  if (!cache) {
+    // Object cleanup is handled by SupportsUserData
+    auto new_cache = std::make_unique<AdBlockCnameCache>(
+        Profile::FromBrowserContext(browser_context));
+    cache = new_cache.get();
+    browser_context->SetUserData(kAdBlockCnameCacheKey, std::move(new_cache));
+  }
+  return cache;
+}
+
+bool AdBlockCnameCache::Lookup(const Key& key,
+                               base::Optional<std::string>* cname) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  auto it = entries_.Get(key);
+  if (it == entries_.end())
+    return false;
+  if (clock_->NowTicks() >= it->second.expiry) {
+    entries_.Erase(it);
+    return false;
+  }
+  *cname = it->second.cname;
+  return true;
+}
+
+bool AdBlockCnameCache::AddPendingLookup(const Key& key,
+                                         CnameCallback callback) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  auto& callbacks = pending_lookups_[key];
+  callbacks.push_back(std::move(callback));
+  return callbacks.size() == 1;
+}
+
+void AdBlockCnameCache::OnResolved(const Key& key,
+                                   base::Optional<std::string> cname) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  // Failures aren't cached, so the next request for the host tries again.
+  if (cname.has_value())
+    entries_.Put(key, Entry{cname, clock_->NowTicks() + kCnameLifetime});
+
+  auto it = pending_lookups_.find(key);
+  if (it == pending_lookups_.end())
+    return;
+  std::vector<CnameCallback> callbacks = std::move(it->second);
+  pending_lookups_.erase(it);
+  for (auto& callback : callbacks)
+    std::move(callback).Run(cname);
+}
+
+void AdBlockCnameCache::OnProxyConfigChanged(
+    const net::ProxyConfigWithAnnotation& config,
+    net::ProxyConfigService::ConfigAvailability availability) {
+  UpdateProxySettingsAllowUncloaking();
+}
+
+void AdBlockCnameCache::OnProfileWillBeDestroyed(Profile* profile) {
+  // User data outlives the profile's prefs, so detach while they still exist.
+  profile_observation_.Reset();
+  ResetProxyConfigService();
+}
+
+void AdBlockCnameCache::ResetProxyConfigService() {
+  if (!proxy_config_service_)
+    return;
+  proxy_config_service_->RemoveObserver(this);
+  proxy_config_service_.reset();
+  proxy_config_tracker_->DetachFromPrefService();
+  proxy_config_tracker_.reset();
+}
+
+void AdBlockCnameCache::UpdateProxySettingsAllowUncloaking() {
+  // Keep the last known setting once the profile's prefs have gone away.
+  if (!proxy_config_service_)
+    return;
+
+  proxy_settings_allow_uncloaking_ = true;
+
+  net::ProxyConfigWithAnnotation config;
+  net::ProxyConfigService::ConfigAvailability availability =
+      proxy_config_service_->GetLatestProxyConfig(&config);
+
+  if (availability ==
+      net::ProxyConfigService::ConfigAvailability::CONFIG_VALID) {
+    // PROXY_LIST corresponds to SingleProxy mode.
+    if (config.value().proxy_rules().type ==
+        net::ProxyConfig::ProxyRules::Type::PROXY_LIST) {
+      proxy_settings_allow_uncloaking_ = false;
+    }
+  }
+}
+
+}  // namespace brave
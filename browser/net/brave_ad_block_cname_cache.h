@@ -0,0 +1,116 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_BROWSER_NET_BRAVE_AD_BLOCK_CNAME_CACHE_H_
+#define BRAVE_BROWSER_NET_BRAVE_AD_BLOCK_CNAME_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/optional.h"
+#include "base/scoped_observation.h"
+#include "base/supports_user_data.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
+#include "chrome/browser/profiles/profile.h"
+#include "chrome/browser/profiles/profile_observer.h"
+#include "net/base/network_isolation_key.h"
+#include "net/proxy_resolution/proxy_config_service.h"
+
+class PrefProxyConfigTracker;
+
+namespace content {
+class BrowserContext;
+}  // namespace content
+
+namespace brave {
+
+// Per-profile state for CNAME uncloaking: recently resolved canonical names
+// keyed by (host, NetworkIsolationKey), the callbacks waiting on lookups that
+// are still in flight, and whether the profile's proxy settings allow making
+// DNS queries outside the proxy at all.
+class AdBlockCnameCache : public base::SupportsUserData::Data,
+                          public net::ProxyConfigService::Observer,
+                          public ProfileObserver {
+ public:
+  using Key = std::pair<std::string, net::NetworkIsolationKey>;
+  using CnameCallback =
+      base::OnceCallback<void(base::Optional<std::string> cname)>;
+
+  // |profile| may be null, in which case uncloaking is always allowed.
+  explicit AdBlockCnameCache(Profile* profile);
+  ~AdBlockCnameCache() override;
+
+  static AdBlockCnameCache* GetForBrowserContext(
+      content::BrowserContext* browser_context);
+
+  // Returns true and sets |cname| if |key| was resolved less than the cache
+  // lifetime ago.
+  bool Lookup(const Key& key, base::Optional<std::string>* cname);
+
+  // Queues |callback| until OnResolved() is called for |key|. Returns true if
+  // no lookup for |key| is in flight yet, meaning the caller must start one.
+  bool AddPendingLookup(const Key& key, CnameCallback callback);
+
+  // Caches a successful result and runs every callback waiting on |key|.
+  void OnResolved(const Key& key, base::Optional<std::string> cname);
+
+  // If only particular types of network traffic are being proxied, or if no
+  // proxy is configured, it should be safe to continue making unproxied DNS
+  // queries. However, in SingleProxy mode all types of network traffic should
+  // go through the proxy, so additional DNS queries should be avoided.
+  bool proxy_settings_allow_uncloaking() const {
+    return proxy_settings_allow_uncloaking_;
+  }
+
+  base::WeakPtr<AdBlockCnameCache> AsWeakPtr() {
+    return weak_factory_.GetWeakPtr();
+  }
+
+  void SetTickClockForTesting(const base::TickClock* clock) { clock_ = clock; }
+
+ private:
+  struct Entry {
+    base::Optional<std::string> cname;
+    base::TimeTicks expiry;
+  };
+
+  // net::ProxyConfigService::Observer:
+  void OnProxyConfigChanged(
+      const net::ProxyConfigWithAnnotation& config,
+      net::ProxyConfigService::ConfigAvailability availability) override;
+
+  // ProfileObserver:
+  void OnProfileWillBeDestroyed(Profile* profile) override;
+
+  void UpdateProxySettingsAllowUncloaking();
+  // Stops observing the proxy config service, which depends on profile prefs.
+  void ResetProxyConfigService();
+
+  base::MRUCache<Key, Entry> entries_;
+  std::map<Key, std::vector<CnameCallback>> pending_lookups_;
+
+  std::unique_ptr<PrefProxyConfigTracker> proxy_config_tracker_;
+  std::unique_ptr<net::ProxyConfigService> proxy_config_service_;
+  bool proxy_settings_allow_uncloaking_ = true;
+  base::ScopedObservation<Profile, ProfileObserver> profile_observation_{this};
+
+  const base::TickClock* clock_;
+
+  base::WeakPtrFactory<AdBlockCnameCache> weak_factory_{this};
+
+  DISALLOW_COPY_AND_ASSIGN(AdBlockCnameCache);
+};
+
+}  // namespace brave
+
+#endif  // BRAVE_BROWSER_NET_BRAVE_AD_BLOCK_CNAME_CACHE_H_
@@ -0,0 +1,122 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/brave_ad_block_cname_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "content/public/test/browser_task_environment.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+#include "url/origin.h"
+
+namespace brave {
+
+namespace {
+
+void AppendResult(std::vector<base::Optional<std::string>>* results,
+                  base::Optional<std::string> cname) {
+  results->push_back(std::move(cname));
+}
+
+}  // namespace
+
+class AdBlockCnameCacheTest : public testing::Test {
+ protected:
+  void SetUp() override { cache_.SetTickClockForTesting(&clock_); }
+
+  content::BrowserTaskEnvironment task_environment_;
+  base::SimpleTestTickClock clock_;
+  AdBlockCnameCache cache_{nullptr};
+};
+
+TEST_F(AdBlockCnameCacheTest, CoalescesPendingLookups) {
+  const AdBlockCnameCache::Key key("a.com", net::NetworkIsolationKey());
+  std::vector<base::Optional<std::string>> results;
+
+  EXPECT_TRUE(
+      cache_.AddPendingLookup(key, base::BindOnce(&AppendResult, &results)));
+  EXPECT_FALSE(
+      cache_.AddPendingLookup(key, base::BindOnce(&AppendResult, &results)));
+  EXPECT_TRUE(results.empty());
+
+  cache_.OnResolved(key, std::string("tracker.com"));
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ("tracker.com", *results[0]);
+  EXPECT_EQ("tracker.com", *results[1]);
+
+  base::Optional<std::string> cname;
+  EXPECT_TRUE(cache_.Lookup(key, &cname));
+  EXPECT_EQ("tracker.com", *cname);
+
+  // A finished lookup doesn't swallow the next one.
+  EXPECT_TRUE(
+      cache_.AddPendingLookup(key, base::BindOnce(&AppendResult, &results)));
+}
+
+TEST_F(AdBlockCnameCacheTest, KeyedByNetworkIsolationKey) {
+  const url::Origin origin_a = url::Origin::Create(GURL("https://a.com"));
+  const url::Origin origin_b = url::Origin::Create(GURL("https://b.com"));
+  const AdBlockCnameCache::Key key_a(
+      "cdn.com", net::NetworkIsolationKey(origin_a, origin_a));
+  const AdBlockCnameCache::Key key_b(
+      "cdn.com", net::NetworkIsolationKey(origin_b, origin_b));
+
+  cache_.OnResolved(key_a, std::string("tracker.com"));
+  base::Optional<std::string> cname;
+  EXPECT_TRUE(cache_.Lookup(key_a, &cname));
+  EXPECT_FALSE(cache_.Lookup(key_b, &cname));
+}
+
+TEST_F(AdBlockCnameCacheTest, EntriesExpire) {
+  const AdBlockCnameCache::Key key("a.com", net::NetworkIsolationKey());
+  cache_.OnResolved(key, std::string("a.com"));
+
+  base::Optional<std::string> cname;
+  clock_.Advance(base::TimeDelta::FromSeconds(30));
+  EXPECT_TRUE(cache_.Lookup(key, &cname));
+  clock_.Advance(base::TimeDelta::FromSeconds(30));
+  EXPECT_FALSE(cache_.Lookup(key, &cname));
+}
+
+TEST_F(AdBlockCnameCacheTest, FailuresAreNotCached) {
+  const AdBlockCnameCache::Key key("a.com", net::NetworkIsolationKey());
+  std::vector<base::Optional<std::string>> results;
+  cache_.AddPendingLookup(key, base::BindOnce(&AppendResult, &results));
+  cache_.OnResolved(key, base::nullopt);
+
+  ASSERT_EQ(1u, results.size());
+  EXPECT_FALSE(results[0].has_value());
+  base::Optional<std::string> cname;
+  EXPECT_FALSE(cache_.Lookup(key, &cname));
+}
+
+TEST_F(AdBlockCnameCacheTest, NoProfileAllowsUncloaking) {
+  EXPECT_TRUE(cache_.proxy_settings_allow_uncloaking());
+}
+
+TEST_F(AdBlockCnameCacheTest, PendingLookupsFailOpenOnDestruction) {
+  const AdBlockCnameCache::Key key("a.com", net::NetworkIsolationKey());
+  std::vector<base::Optional<std::string>> results;
+
+  auto cache = std::make_unique<AdBlockCnameCache>(nullptr);
+  EXPECT_TRUE(
+      cache->AddPendingLookup(key, base::BindOnce(&AppendResult, &results)));
+  EXPECT_FALSE(
+      cache->AddPendingLookup(key, base::BindOnce(&AppendResult, &results)));
+  EXPECT_TRUE(results.empty());
+
+  cache.reset();
+  ASSERT_EQ(2u, results.size());
+  EXPECT_FALSE(results[0].has_value());
+  EXPECT_FALSE(results[1].has_value());
+}
+
+}  // namespace brave
@@ -12,9 +12,12 @@
 
 #include "base/base64url.h"
 #include "base/feature_list.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/no_destructor.h"
 #include "base/strings/string_util.h"
 #include "brave/browser/brave_browser_process.h"
 #include "brave/browser/brave_shields/brave_shields_web_contents_observer.h"
+#include "brave/browser/net/brave_ad_block_cname_cache.h"
 #include "brave/browser/net/url_context.h"
 #include "brave/common/network_constants.h"
 #include "brave/common/url_constants.h"
@@ -22,23 +25,16 @@
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
 #include "brave/components/brave_shields/common/features.h"
 #include "brave/grit/brave_generated_resources.h"
-#include "chrome/browser/net/proxy_service_factory.h"
 #include "chrome/browser/net/secure_dns_config.h"
 #include "chrome/browser/net/system_network_context_manager.h"
-#include "chrome/browser/profiles/profile.h"
-#include "components/prefs/pref_service.h"
-#include "components/proxy_config/pref_proxy_config_tracker.h"
 #include "content/public/browser/browser_context.h"
+#include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/render_frame_host.h"
 #include "content/public/browser/storage_partition.h"
-#include "content/public/browser/web_contents.h"
 #include "content/public/common/url_constants.h"
 #include "extensions/common/url_pattern.h"
 #include "mojo/public/cpp/bindings/remote.h"
-#include "net/proxy_resolution/proxy_config.h"
-#include "net/proxy_resolution/proxy_config_service.h"
-#include "net/proxy_resolution/proxy_config_with_annotation.h"
 #include "services/network/host_resolver.h"
 #include "services/network/network_context.h"
 #include "ui/base/resource/resource_bundle.h"
@@ -70,20 +66,17 @@ void UseCnameResult(scoped_refptr<base::SequencedTaskRunner> task_runner,
 class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
  private:
   mojo::Receiver<network::mojom::ResolveHostClient> receiver_{this};
-  base::OnceCallback<void(base::Optional<std::string>)> cb_;
+  AdBlockCnameCache::CnameCallback cb_;
   base::TimeTicks start_time_;
 
  public:
   AdblockCnameResolveHostClient(
-      const ResponseCallback& next_callback,
-      scoped_refptr<base::SequencedTaskRunner> task_runner,
-      std::shared_ptr<BraveRequestInfo> ctx,
-      EngineFlags previous_result) {
+      const GURL& url,
+      const net::NetworkIsolationKey& network_isolation_key,
+      content::BrowserContext* browser_context,
+      AdBlockCnameCache::CnameCallback cb)
+      : cb_(std::move(cb)) {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-    cb_ = base::BindOnce(&UseCnameResult, task_runner, std::move(next_callback),
-                         ctx, previous_result);
-
-    const auto network_isolation_key = ctx->network_isolation_key;
 
     network::mojom::ResolveHostParametersPtr optional_parameters =
         network::mojom::ResolveHostParameters::New();
@@ -102,25 +95,17 @@ class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
 
     if (g_testing_host_resolver) {
       g_testing_host_resolver->ResolveHost(
-          net::HostPortPair::FromURL(ctx->request_url), network_isolation_key,
+          net::HostPortPair::FromURL(url), network_isolation_key,
           std::move(optional_parameters), receiver_.BindNewPipeAndPassRemote());
     } else {
-      auto* web_contents =
-          content::WebContents::FromFrameTreeNodeId(ctx->frame_tree_node_id);
-      if (!web_contents) {
-        start_time_ = base::TimeTicks::Now();
-        this->OnComplete(net::ERR_FAILED, net::ResolveErrorInfo(),
-                         base::nullopt);
-        return;
-      }
-
+      // The lookup may be shared by requests from several frames, so it
+      // resolves through the profile rather than through any one of them.
       network::mojom::NetworkContext* network_context =
-          content::BrowserContext::GetDefaultStoragePartition(
-              web_contents->GetBrowserContext())
+          content::BrowserContext::GetDefaultStoragePartition(browser_context)
               ->GetNetworkContext();
 
       network_context->ResolveHost(
-          net::HostPortPair::FromURL(ctx->request_url), network_isolation_key,
+          net::HostPortPair::FromURL(url), network_isolation_key,
           std::move(optional_parameters), receiver_.BindNewPipeAndPassRemote());
     }
 
@@ -158,6 +143,58 @@ class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
   }
 };
 
+void OnCnameLookupComplete(bool cache_hit,
+                           base::TimeTicks start_time,
+                           scoped_refptr<base::SequencedTaskRunner> task_runner,
+                           const ResponseCallback& next_callback,
+                           std::shared_ptr<BraveRequestInfo> ctx,
+                           EngineFlags previous_result,
+                           base::Optional<std::string> cname) {
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+  if (cache_hit) {
+    UMA_HISTOGRAM_TIMES(
+        "Brave.ShieldsCNAMEBlocking.TotalResolutionTime.CacheHit", elapsed);
+  } else {
+    UMA_HISTOGRAM_TIMES(
+        "Brave.ShieldsCNAMEBlocking.TotalResolutionTime.CacheMiss", elapsed);
+  }
+  UseCnameResult(task_runner, next_callback, ctx, previous_result,
+                 std::move(cname));
+}
+
+// Answers from the profile's CNAME cache when possible. Otherwise the request
+// waits on a lookup for its host, which is only started if no other request
+// already has one in flight.
+void LookupCname(scoped_refptr<base::SequencedTaskRunner> task_runner,
+                 const ResponseCallback& next_callback,
+                 std::shared_ptr<BraveRequestInfo> ctx,
+                 EngineFlags previous_result) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  AdBlockCnameCache* cache =
+      AdBlockCnameCache::GetForBrowserContext(ctx->browser_context);
+  const AdBlockCnameCache::Key key(ctx->request_url.host(),
+                                   ctx->network_isolation_key);
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+
+  base::Optional<std::string> cname;
+  if (cache->Lookup(key, &cname)) {
+    OnCnameLookupComplete(true, start_time, task_runner, next_callback, ctx,
+                          previous_result, std::move(cname));
+    return;
+  }
+
+  if (!cache->AddPendingLookup(
+          key, base::BindOnce(&OnCnameLookupComplete, false, start_time,
+                              task_runner, next_callback, ctx,
+                              previous_result))) {
+    return;
+  }
+  // This will be deleted by `AdblockCnameResolveHostClient::OnComplete`.
+  new AdblockCnameResolveHostClient(
+      ctx->request_url, ctx->network_isolation_key, ctx->browser_context,
+      base::BindOnce(&AdBlockCnameCache::OnResolved, cache->AsWeakPtr(), key));
+}
+
 // If `canonical_url` is specified, this will only check if the CNAME-uncloaked
 // response should be blocked. Otherwise, it will run the check for the
 // original request URL.
@@ -202,9 +239,7 @@ void OnShouldBlockRequestResult(
     brave_shields::BraveShieldsWebContentsObserver::DispatchBlockedEvent(
         ctx->request_url, ctx->frame_tree_node_id, brave_shields::kAds);
   } else if (then_check_uncloaked) {
-    // This will be deleted by `AdblockCnameResolveHostClient::OnComplete`.
-    new AdblockCnameResolveHostClient(std::move(next_callback), task_runner,
-                                      ctx, result);
+    LookupCname(task_runner, next_callback, ctx, result);
     return;
   }
   next_callback.Run();
@@ -235,40 +270,107 @@ void UseCnameResult(scoped_refptr<base::SequencedTaskRunner> task_runner,
   }
 }
 
-// If only particular types of network traffic are being proxied, or if no
-// proxy is configured, it should be safe to continue making unproxied DNS
-// queries. However, in SingleProxy mode all types of network traffic should go
-// through the proxy, so additional DNS queries should be avoided.
-bool ProxySettingsAllowUncloaking(content::BrowserContext* browser_context) {
-  DCHECK(browser_context);
-
-  bool can_uncloak = true;
-
-  Profile* profile = Profile::FromBrowserContext(browser_context);
-
-  std::unique_ptr<PrefProxyConfigTracker> config_tracker =
-      ProxyServiceFactory::CreatePrefProxyConfigTrackerOfProfile(
-          profile->GetPrefs(), nullptr);
-  std::unique_ptr<net::ProxyConfigService> proxy_config_service =
-      ProxyServiceFactory::CreateProxyConfigService(config_tracker.get());
-
-  net::ProxyConfigWithAnnotation config;
-  net::ProxyConfigService::ConfigAvailability availability =
-      proxy_config_service->GetLatestProxyConfig(&config);
-
-  if (availability ==
-      net::ProxyConfigService::ConfigAvailability::CONFIG_VALID) {
-    // PROXY_LIST corresponds to SingleProxy mode.
-    if (config.value().proxy_rules().type ==
-        net::ProxyConfig::ProxyRules::Type::PROXY_LIST) {
-      can_uncloak = false;
+// Collects the requests that arrive on the UI thread during one task and
+// matches all of them with a single task on the adblock task runner, rather
+// than bouncing one task per request to the task runner and back.
+class AdBlockRequestBatcher {
+ public:
+  static AdBlockRequestBatcher* GetInstance() {
+    static base::NoDestructor<AdBlockRequestBatcher> instance;
+    return instance.get();
+  }
+
+  void Add(const ResponseCallback& next_callback,
+           std::shared_ptr<BraveRequestInfo> ctx,
+           bool should_check_uncloaked) {
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+    pending_.push_back(PendingRequest{next_callback, std::move(ctx),
+                                      should_check_uncloaked,
+                                      base::TimeTicks::Now()});
+    if (pending_.size() > 1)
+      return;
+    // Everything added before this task runs goes into the same batch.
+    content::GetUIThreadTaskRunner({})->PostTask(
+        FROM_HERE, base::BindOnce(&AdBlockRequestBatcher::Flush,
+                                  base::Unretained(this)));
+  }
+
+ private:
+  friend class base::NoDestructor<AdBlockRequestBatcher>;
+
+  struct PendingRequest {
+    ResponseCallback next_callback;
+    std::shared_ptr<BraveRequestInfo> ctx;
+    bool should_check_uncloaked;
+    base::TimeTicks enqueue_time;
+    EngineFlags result;
+  };
+  using Batch = std::vector<PendingRequest>;
+
+  AdBlockRequestBatcher() = default;
+  ~AdBlockRequestBatcher() = default;
+
+  void Flush() {
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+    auto batch = std::make_unique<Batch>();
+    batch->swap(pending_);
+    UMA_HISTOGRAM_COUNTS_1000("Brave.Adblock.BatchSize", batch->size());
+
+    scoped_refptr<base::SequencedTaskRunner> task_runner =
+        g_brave_browser_process->ad_block_service()->GetTaskRunner();
+    Batch* batch_ptr = batch.get();
+    task_runner->PostTaskAndReply(
+        FROM_HERE, base::BindOnce(&MatchBatchOnTaskRunner, batch_ptr),
+        base::BindOnce(&OnBatchMatched, task_runner, std::move(batch)));
+  }
+
+  static void MatchBatchOnTaskRunner(Batch* batch) {
+    const base::TimeTicks now = base::TimeTicks::Now();
+    std::vector<brave_shields::AdBlockService::RequestQuery> queries;
+    std::vector<PendingRequest*> queried;
+    for (auto& request : *batch) {
+      UMA_HISTOGRAM_TIMES("Brave.Adblock.BatchQueueingDelay",
+                          now - request.enqueue_time);
+      if (!request.ctx->initiator_url.is_valid())
+        continue;
+      brave_shields::AdBlockService::RequestQuery query;
+      query.url = request.ctx->request_url;
+      query.resource_type = request.ctx->resource_type;
+      query.tab_host = request.ctx->initiator_url.host();
+      queries.push_back(std::move(query));
+      queried.push_back(&request);
+    }
+
+    g_brave_browser_process->ad_block_service()->ShouldStartRequests(queries);
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+      const auto& query = queries[i];
+      PendingRequest* request = queried[i];
+      request->result.did_match_rule = query.did_match_rule;
+      request->result.did_match_exception = query.did_match_exception;
+      request->result.did_match_important = query.did_match_important;
+      if (!query.mock_data_url.empty())
+        request->ctx->mock_data_url = query.mock_data_url;
+      if (query.did_match_important ||
+          (query.did_match_rule && !query.did_match_exception)) {
+        request->ctx->blocked_by = kAdBlocked;
+      }
     }
   }
 
-  config_tracker->DetachFromPrefService();
+  static void OnBatchMatched(
+      scoped_refptr<base::SequencedTaskRunner> task_runner,
+      std::unique_ptr<Batch> batch) {
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+    for (auto& request : *batch) {
+      OnShouldBlockRequestResult(request.should_check_uncloaked, task_runner,
+                                 request.next_callback, request.ctx,
+                                 request.result);
+    }
+  }
 
-  return can_uncloak;
-}
+  Batch pending_;
+};
 
 void OnBeforeURLRequestAdBlockTP(const ResponseCallback& next_callback,
                                  std::shared_ptr<BraveRequestInfo> ctx) {
@@ -287,7 +389,15 @@ void OnBeforeURLRequestAdBlockTP(const ResponseCallback& next_callback,
       base::FeatureList::IsEnabled(
           brave_shields::features::kBraveAdblockCnameUncloaking) &&
       ctx->browser_context && !ctx->browser_context->IsTor() &&
-      ProxySettingsAllowUncloaking(ctx->browser_context);
+      AdBlockCnameCache::GetForBrowserContext(ctx->browser_context)
+          ->proxy_settings_allow_uncloaking();
+
+  if (base::FeatureList::IsEnabled(
+          brave_shields::features::kBraveAdblockBatchMatching)) {
+    AdBlockRequestBatcher::GetInstance()->Add(next_callback, ctx,
+                                              should_check_uncloaked);
+    return;
+  }
 
   task_runner->PostTaskAndReplyWithResult(
       FROM_HERE,
@@ -8,12 +8,16 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "base/bind.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "brave/browser/brave_browser_process.h"
 #include "brave/browser/net/url_context.h"
 #include "brave/common/network_constants.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "brave/test/base/testing_brave_browser_process.h"
 #include "content/public/test/browser_task_environment.h"
 #include "net/base/net_errors.h"
@@ -113,6 +117,25 @@ class BraveAdBlockTPNetworkDelegateHelperTest : public testing::Test {
     return rc == net::ERR_IO_PENDING;
   }
 
+  // Starts every request in |request_infos| before running any task, so that
+  // they are all queued at once, and returns how many of them completed.
+  int CheckRequests(
+      const std::vector<std::shared_ptr<brave::BraveRequestInfo>>&
+          request_infos) {
+    int completed = 0;
+    uint64_t request_identifier = 1;
+    for (const auto& request_info : request_infos) {
+      request_info->request_identifier = request_identifier++;
+      int rc = OnBeforeURLRequest_AdBlockTPPreWork(
+          base::BindRepeating([](int* completed) { ++*completed; },
+                              &completed),
+          request_info);
+      EXPECT_EQ(net::ERR_IO_PENDING, rc);
+    }
+    task_environment_.RunUntilIdle();
+    return completed;
+  }
+
   std::unique_ptr<TestingBraveComponentUpdaterDelegate>
       brave_component_updater_delegate_;
 
@@ -173,3 +196,63 @@ TEST_F(BraveAdBlockTPNetworkDelegateHelperTest, SimpleBlocking) {
   // made (`browser_context` is `nullptr`).
   EXPECT_EQ(0ULL, host_resolver_->num_resolve());
 }
+
+TEST_F(BraveAdBlockTPNetworkDelegateHelperTest,
+       BatchedAndUnbatchedVerdictsMatch) {
+  ResetAdblockInstance(g_brave_browser_process->ad_block_service(),
+                       "||ads.example.com^\n"
+                       "||example.com/banner.png\n"
+                       "@@||example.com/banner.png$image\n"
+                       "||cdn.example.com/tracker.js$important\n"
+                       "@@||cdn.example.com^",
+                       "");
+
+  struct {
+    const char* url;
+    blink::mojom::ResourceType resource_type;
+  } requests[] = {
+      {"https://ads.example.com/ad.js", blink::mojom::ResourceType::kScript},
+      {"https://example.com/banner.png", blink::mojom::ResourceType::kImage},
+      {"https://example.com/banner.png", blink::mojom::ResourceType::kScript},
+      {"https://cdn.example.com/tracker.js",
+       blink::mojom::ResourceType::kScript},
+      {"https://cdn.example.com/app.js", blink::mojom::ResourceType::kScript},
+      {"https://ads.example.com/ad.js", blink::mojom::ResourceType::kScript},
+      {"https://example.com/logo.png", blink::mojom::ResourceType::kImage},
+  };
+
+  std::vector<brave::BlockedBy> verdicts[2];
+  for (bool batched : {false, true}) {
+    base::test::ScopedFeatureList feature_list;
+    if (batched) {
+      feature_list.InitAndEnableFeature(
+          brave_shields::features::kBraveAdblockBatchMatching);
+    } else {
+      feature_list.InitAndDisableFeature(
+          brave_shields::features::kBraveAdblockBatchMatching);
+    }
+
+    std::vector<std::shared_ptr<brave::BraveRequestInfo>> request_infos;
+    for (const auto& request : requests) {
+      auto request_info =
+          std::make_shared<brave::BraveRequestInfo>(GURL(request.url));
+      request_info->resource_type = request.resource_type;
+      request_info->initiator_url = GURL("https://example.com");
+      request_infos.push_back(request_info);
+    }
+
+    // Every request must be handed on to the next stage, blocked or not.
+    EXPECT_EQ(static_cast<int>(request_infos.size()),
+              CheckRequests(request_infos));
+    for (const auto& request_info : request_infos)
+      verdicts[batched].push_back(request_info->blocked_by);
+  }
+
+  EXPECT_EQ(verdicts[false], verdicts[true]);
+  const std::vector<brave::BlockedBy> expected = {
+      brave::kAdBlocked,  brave::kNotBlocked, brave::kAdBlocked,
+      brave::kAdBlocked,  brave::kNotBlocked, brave::kAdBlocked,
+      brave::kNotBlocked,
+  };
+  EXPECT_EQ(expected, verdicts[true]);
+}
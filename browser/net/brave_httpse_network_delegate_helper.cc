@@ -96,4 +96,11 @@ int OnBeforeURLRequest_HttpsePreFileWork(
   return net::OK;
 }
 
+void OnURLRequestDestroyed_Httpse(std::shared_ptr<BraveRequestInfo> ctx) {
+  auto* https_everywhere_service =
+      g_brave_browser_process->https_everywhere_service();
+  if (https_everywhere_service)
+    https_everywhere_service->OnURLRequestDestroyed(ctx->request_identifier);
+}
+
 }  // namespace brave
@@ -9,8 +9,12 @@
 #include <utility>
 
 #include "base/feature_list.h"
+#include "base/metrics/histogram.h"
 #include "base/metrics/histogram_macros.h"
+#include "base/strings/strcat.h"
 #include "base/task/post_task.h"
+#include "base/task/thread_pool.h"
+#include "base/trace_event/trace_event.h"
 #include "brave/browser/net/brave_ad_block_csp_network_delegate_helper.h"
 #include "brave/browser/net/brave_ad_block_tp_network_delegate_helper.h"
 #include "brave/browser/net/brave_common_static_redirect_network_delegate_helper.h"
@@ -67,8 +71,33 @@ static bool IsInternalScheme(std::shared_ptr<brave::BraveRequestInfo> ctx) {
          ctx->request_url.SchemeIs(content::kChromeUIScheme);
 }
 
-BraveRequestHandler::BraveRequestHandler() {
+namespace {
+
+const char* GetEventTypeName(brave::BraveNetworkDelegateEventType event_type) {
+  switch (event_type) {
+    case brave::kOnBeforeRequest:
+      return "OnBeforeURLRequest";
+    case brave::kOnBeforeStartTransaction:
+      return "OnBeforeStartTransaction";
+    case brave::kOnHeadersReceived:
+      return "OnHeadersReceived";
+    default:
+      NOTREACHED();
+      return "Unknown";
+  }
+}
+
+}  // namespace
+
+BraveRequestHandler::BraveRequestHandler()
+    : stages_(base::MakeRefCounted<StageList>()) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  if (base::FeatureList::IsEnabled(
+          ::brave_shields::features::kBraveRequestHandlerOffUIThread)) {
+    off_ui_task_runner_ = base::ThreadPool::CreateSequencedTaskRunner(
+        {base::TaskPriority::USER_BLOCKING,
+         base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
+  }
   SetupCallbacks();
   // Initialize the preference change registrar.
   InitPrefChangeRegistrar();
@@ -76,76 +105,169 @@ BraveRequestHandler::BraveRequestHandler() {
 
 BraveRequestHandler::~BraveRequestHandler() = default;
 
-void BraveRequestHandler::SetupCallbacks() {
-  brave::OnBeforeURLRequestCallback callback =
-      base::BindRepeating(brave::OnBeforeURLRequest_SiteHacksWork);
-  before_url_request_callbacks_.push_back(callback);
+BraveRequestHandler::Stage::Stage() = default;
+BraveRequestHandler::Stage::Stage(const Stage&) = default;
+BraveRequestHandler::Stage::~Stage() = default;
 
-  callback = base::BindRepeating(brave::OnBeforeURLRequest_AdBlockTPPreWork);
-  before_url_request_callbacks_.push_back(callback);
+void BraveRequestHandler::SetupCallbacks() {
+  // Off the UI thread, the kAnySequence stages come first, so that a request
+  // leaves the UI thread at most once per event. They keep their relative
+  // order, since the last stage to set |new_url_spec| wins. Otherwise every
+  // stage keeps its original place.
+  const bool group_any_sequence_stages = !!off_ui_task_runner_;
+  auto add_common_static_redirect_stage = [this]() {
+    AddBeforeURLRequestStage(
+        "CommonStaticRedirect", StageMode::kSync, StageAffinity::kAnySequence,
+        base::BindRepeating(
+            brave::OnBeforeURLRequest_CommonStaticRedirectWork));
+  };
+#if BUILDFLAG(ENABLE_BRAVE_TRANSLATE_GO)
+  auto add_translate_redirect_stage = [this]() {
+    AddBeforeURLRequestStage(
+        "TranslateRedirect", StageMode::kSync, StageAffinity::kAnySequence,
+        base::BindRepeating(brave::OnBeforeURLRequest_TranslateRedirectWork));
+  };
+#endif
 
-  callback = base::BindRepeating(brave::OnBeforeURLRequest_HttpsePreFileWork);
-  before_url_request_callbacks_.push_back(callback);
+  AddBeforeURLRequestStage(
+      "SiteHacks", StageMode::kSync, StageAffinity::kAnySequence,
+      base::BindRepeating(brave::OnBeforeURLRequest_SiteHacksWork));
+  if (group_any_sequence_stages) {
+    add_common_static_redirect_stage();
+#if BUILDFLAG(ENABLE_BRAVE_TRANSLATE_GO)
+    add_translate_redirect_stage();
+#endif
+  }
 
-  callback =
-      base::BindRepeating(brave::OnBeforeURLRequest_CommonStaticRedirectWork);
-  before_url_request_callbacks_.push_back(callback);
+  AddBeforeURLRequestStage(
+      "AdBlockTP", StageMode::kAsync, StageAffinity::kUIThread,
+      base::BindRepeating(brave::OnBeforeURLRequest_AdBlockTPPreWork));
+  AddBeforeURLRequestStage(
+      "Httpse", StageMode::kAsync, StageAffinity::kUIThread,
+      base::BindRepeating(brave::OnBeforeURLRequest_HttpsePreFileWork));
+  if (!group_any_sequence_stages)
+    add_common_static_redirect_stage();
 
 #if BUILDFLAG(DECENTRALIZED_DNS_ENABLED) && BUILDFLAG(BRAVE_WALLET_ENABLED)
-  callback = base::BindRepeating(
-      decentralized_dns::OnBeforeURLRequest_DecentralizedDnsPreRedirectWork);
-  before_url_request_callbacks_.push_back(callback);
+  AddBeforeURLRequestStage(
+      "DecentralizedDns", StageMode::kAsync, StageAffinity::kUIThread,
+      base::BindRepeating(
+          decentralized_dns::OnBeforeURLRequest_DecentralizedDnsPreRedirectWork));
 #endif
 
 #if BUILDFLAG(BRAVE_REWARDS_ENABLED)
-  callback = base::BindRepeating(brave_rewards::OnBeforeURLRequest);
-  before_url_request_callbacks_.push_back(callback);
+  AddBeforeURLRequestStage(
+      "Rewards", StageMode::kSync, StageAffinity::kUIThread,
+      base::BindRepeating(brave_rewards::OnBeforeURLRequest));
 #endif
 
 #if BUILDFLAG(ENABLE_BRAVE_TRANSLATE_GO)
-  callback =
-      base::BindRepeating(brave::OnBeforeURLRequest_TranslateRedirectWork);
-  before_url_request_callbacks_.push_back(callback);
+  if (!group_any_sequence_stages)
+    add_translate_redirect_stage();
 #endif
 
 #if BUILDFLAG(IPFS_ENABLED)
   if (base::FeatureList::IsEnabled(ipfs::features::kIpfsFeature)) {
-    callback = base::BindRepeating(ipfs::OnBeforeURLRequest_IPFSRedirectWork);
-    before_url_request_callbacks_.push_back(callback);
-    brave::OnHeadersReceivedCallback ipfs_headers_received_callback =
-        base::BindRepeating(ipfs::OnHeadersReceived_IPFSRedirectWork);
-    headers_received_callbacks_.push_back(ipfs_headers_received_callback);
+    AddBeforeURLRequestStage(
+        "IPFSRedirect", StageMode::kSync, StageAffinity::kUIThread,
+        base::BindRepeating(ipfs::OnBeforeURLRequest_IPFSRedirectWork));
+    AddHeadersReceivedStage(
+        "IPFSRedirect", StageMode::kSync,
+        base::BindRepeating(ipfs::OnHeadersReceived_IPFSRedirectWork));
   }
 #endif
 
-  brave::OnBeforeStartTransactionCallback start_transaction_callback =
-      base::BindRepeating(brave::OnBeforeStartTransaction_SiteHacksWork);
-  before_start_transaction_callbacks_.push_back(start_transaction_callback);
-
-  start_transaction_callback = base::BindRepeating(
-      brave::OnBeforeStartTransaction_GlobalPrivacyControlWork);
-  before_start_transaction_callbacks_.push_back(start_transaction_callback);
+  AddBeforeStartTransactionStage(
+      "SiteHacks", StageMode::kSync,
+      base::BindRepeating(brave::OnBeforeStartTransaction_SiteHacksWork));
+  AddBeforeStartTransactionStage(
+      "GlobalPrivacyControl", StageMode::kSync,
+      base::BindRepeating(
+          brave::OnBeforeStartTransaction_GlobalPrivacyControlWork));
 
 #if BUILDFLAG(ENABLE_BRAVE_REFERRALS)
-  start_transaction_callback =
-      base::BindRepeating(brave::OnBeforeStartTransaction_ReferralsWork);
-  before_start_transaction_callbacks_.push_back(start_transaction_callback);
+  AddBeforeStartTransactionStage(
+      "Referrals", StageMode::kSync,
+      base::BindRepeating(brave::OnBeforeStartTransaction_ReferralsWork));
 #endif
 
 #if BUILDFLAG(ENABLE_BRAVE_WEBTORRENT)
-  brave::OnHeadersReceivedCallback headers_received_callback =
-      base::BindRepeating(webtorrent::OnHeadersReceived_TorrentRedirectWork);
-  headers_received_callbacks_.push_back(headers_received_callback);
+  AddHeadersReceivedStage(
+      "TorrentRedirect", StageMode::kSync,
+      base::BindRepeating(webtorrent::OnHeadersReceived_TorrentRedirectWork));
 #endif
 
   if (base::FeatureList::IsEnabled(
           ::brave_shields::features::kBraveAdblockCspRules)) {
-    brave::OnHeadersReceivedCallback headers_received_callback2 =
-        base::BindRepeating(brave::OnHeadersReceived_AdBlockCspWork);
-    headers_received_callbacks_.push_back(headers_received_callback2);
+    AddHeadersReceivedStage(
+        "AdBlockCsp", StageMode::kAsync,
+        base::BindRepeating(brave::OnHeadersReceived_AdBlockCspWork));
   }
 }
 
+void BraveRequestHandler::AddBeforeURLRequestStage(
+    const char* name,
+    StageMode mode,
+    StageAffinity affinity,
+    brave::OnBeforeURLRequestCallback callback) {
+  // Asynchronous stages resume the pipeline through a WeakPtr that is bound
+  // to the UI thread.
+  DCHECK(affinity == StageAffinity::kUIThread || mode == StageMode::kSync);
+  DCHECK(!off_ui_task_runner_ || affinity == StageAffinity::kUIThread ||
+         std::none_of(stages_->data.begin(), stages_->data.end(),
+                      [](const Stage& stage) {
+                        return stage.event_type == brave::kOnBeforeRequest &&
+                               stage.affinity == StageAffinity::kUIThread;
+                      }))
+      << "kAnySequence stages must be added before kUIThread stages";
+  Stage stage;
+  stage.event_type = brave::kOnBeforeRequest;
+  stage.affinity = affinity;
+  stage.before_url_request = std::move(callback);
+  AddStage(name, mode, std::move(stage));
+}
+
+void BraveRequestHandler::AddBeforeStartTransactionStage(
+    const char* name,
+    StageMode mode,
+    brave::OnBeforeStartTransactionCallback callback) {
+  Stage stage;
+  stage.event_type = brave::kOnBeforeStartTransaction;
+  stage.before_start_transaction = std::move(callback);
+  AddStage(name, mode, std::move(stage));
+}
+
+void BraveRequestHandler::AddHeadersReceivedStage(
+    const char* name,
+    StageMode mode,
+    brave::OnHeadersReceivedCallback callback) {
+  Stage stage;
+  stage.event_type = brave::kOnHeadersReceived;
+  stage.headers_received = std::move(callback);
+  AddStage(name, mode, std::move(stage));
+}
+
+void BraveRequestHandler::AddStage(const char* name,
+                                   StageMode mode,
+                                   Stage stage) {
+  stage.mode = mode;
+  stage.histogram_name = base::StrCat(
+      {"Brave.RequestHandler.Stage.", GetEventTypeName(stage.event_type), ".",
+       name});
+  // Same buckets as UMA_HISTOGRAM_TIMES.
+  stage.histogram = base::Histogram::FactoryTimeGet(
+      stage.histogram_name, base::TimeDelta::FromMilliseconds(1),
+      base::TimeDelta::FromSeconds(10), 50,
+      base::HistogramBase::kUmaTargetedHistogramFlag);
+  stage_counts_[stage.event_type]++;
+  stages_->data.push_back(std::move(stage));
+}
+
+bool BraveRequestHandler::HasStages(
+    brave::BraveNetworkDelegateEventType event_type) const {
+  return base::Contains(stage_counts_, event_type);
+}
+
 void BraveRequestHandler::InitPrefChangeRegistrar() {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 #if BUILDFLAG(ENABLE_BRAVE_REFERRALS)
@@ -178,7 +300,7 @@ int BraveRequestHandler::OnBeforeURLRequest(
     std::shared_ptr<brave::BraveRequestInfo> ctx,
     net::CompletionOnceCallback callback,
     GURL* new_url) {
-  if (before_url_request_callbacks_.empty() || IsInternalScheme(ctx)) {
+  if (!HasStages(brave::kOnBeforeRequest) || IsInternalScheme(ctx)) {
     return net::OK;
   }
   SCOPED_UMA_HISTOGRAM_TIMER("Brave.OnBeforeURLRequest_Handler");
@@ -193,7 +315,7 @@ int BraveRequestHandler::OnBeforeStartTransaction(
     std::shared_ptr<brave::BraveRequestInfo> ctx,
     net::CompletionOnceCallback callback,
     net::HttpRequestHeaders* headers) {
-  if (before_start_transaction_callbacks_.empty() || IsInternalScheme(ctx)) {
+  if (!HasStages(brave::kOnBeforeStartTransaction) || IsInternalScheme(ctx)) {
     return net::OK;
   }
   ctx->event_type = brave::kOnBeforeStartTransaction;
@@ -216,7 +338,7 @@ int BraveRequestHandler::OnHeadersReceived(
         original_response_headers, override_response_headers);
   }
 
-  if (headers_received_callbacks_.empty() &&
+  if (!HasStages(brave::kOnHeadersReceived) &&
       !ctx->request_url.SchemeIs(content::kChromeUIScheme)) {
     // Extension scheme not excluded since brave_webtorrent needs it.
     return net::OK;
@@ -237,6 +359,7 @@ void BraveRequestHandler::OnURLRequestDestroyed(
   if (base::Contains(callbacks_, ctx->request_identifier)) {
     callbacks_.erase(ctx->request_identifier);
   }
+  brave::OnURLRequestDestroyed_Httpse(ctx);
 }
 
 void BraveRequestHandler::RunCallbackForRequestIdentifier(
@@ -250,8 +373,72 @@ void BraveRequestHandler::RunCallbackForRequestIdentifier(
                  base::BindOnce(std::move(it->second), rv));
 }
 
-// TODO(iefremov): Merge all callback containers into one and run only one loop
-// instead of many (issues/5574).
+// static
+int BraveRequestHandler::RunStage(
+    const Stage& stage,
+    const brave::ResponseCallback& next_callback,
+    std::shared_ptr<brave::BraveRequestInfo> ctx) {
+  TRACE_EVENT1("browser", "BraveRequestHandler::RunStage",
+               "stage", stage.histogram_name);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  int rv = net::OK;
+  switch (stage.event_type) {
+    case brave::kOnBeforeRequest:
+      rv = stage.before_url_request.Run(next_callback, ctx);
+      break;
+    case brave::kOnBeforeStartTransaction:
+      rv = stage.before_start_transaction.Run(ctx->headers, next_callback, ctx);
+      break;
+    case brave::kOnHeadersReceived:
+      rv = stage.headers_received.Run(
+          ctx->original_response_headers, ctx->override_response_headers,
+          ctx->allowed_unsafe_redirect_url, next_callback, ctx);
+      break;
+    default:
+      NOTREACHED();
+  }
+  stage.histogram->AddTime(base::TimeTicks::Now() - start);
+  return rv;
+}
+
+// static
+int BraveRequestHandler::RunStagesOffUIThread(
+    scoped_refptr<StageList> stages,
+    std::shared_ptr<brave::BraveRequestInfo> ctx) {
+  TRACE_EVENT0("browser",
+               "BraveRequestHandler::RunStagesOffUIThread");
+  const brave::ResponseCallback no_continuation;
+  int rv = net::OK;
+  while (ctx->next_url_request_index < stages->data.size()) {
+    const Stage& stage = stages->data[ctx->next_url_request_index];
+    if (stage.event_type == ctx->event_type &&
+        stage.affinity != StageAffinity::kAnySequence) {
+      break;
+    }
+    ctx->next_url_request_index++;
+    if (stage.event_type != ctx->event_type)
+      continue;
+    rv = RunStage(stage, no_continuation, ctx);
+    DCHECK_NE(rv, net::ERR_IO_PENDING) << stage.histogram_name;
+    if (rv != net::OK)
+      break;
+  }
+  return rv;
+}
+
+void BraveRequestHandler::OnStagesRunOffUIThread(
+    std::shared_ptr<brave::BraveRequestInfo> ctx,
+    int rv) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  if (!base::Contains(callbacks_, ctx->request_identifier))
+    return;
+  if (rv != net::OK) {
+    RunCallbackForRequestIdentifier(ctx->request_identifier, rv);
+    return;
+  }
+  RunNextCallback(ctx);
+}
+
 void BraveRequestHandler::RunNextCallback(
     std::shared_ptr<brave::BraveRequestInfo> ctx) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
@@ -260,57 +447,45 @@ void BraveRequestHandler::RunNextCallback(
     return;
   }
 
-  // Continue processing callbacks until we hit one that returns PENDING
+  // Continue processing stages until we hit one that returns PENDING.
+  // Synchronous stages never resume the pipeline themselves, so they get an
+  // empty continuation instead of a freshly bound one.
   int rv = net::OK;
+  const brave::ResponseCallback no_continuation;
+  while (ctx->next_url_request_index < stages_->data.size()) {
+    const Stage& stage = stages_->data[ctx->next_url_request_index];
+    if (stage.event_type != ctx->event_type) {
+      ctx->next_url_request_index++;
+      continue;
+    }
 
-  if (ctx->event_type == brave::kOnBeforeRequest) {
-    while (before_url_request_callbacks_.size() !=
-           ctx->next_url_request_index) {
-      brave::OnBeforeURLRequestCallback callback =
-          before_url_request_callbacks_[ctx->next_url_request_index++];
-      brave::ResponseCallback next_callback =
-          base::BindRepeating(&BraveRequestHandler::RunNextCallback,
-                              weak_factory_.GetWeakPtr(), ctx);
-      rv = callback.Run(next_callback, ctx);
-      if (rv == net::ERR_IO_PENDING) {
-        return;
-      }
-      if (rv != net::OK) {
-        break;
-      }
+    if (off_ui_task_runner_ && stage.affinity == StageAffinity::kAnySequence) {
+      // The UI thread doesn't touch |ctx| while the request is pending.
+      off_ui_task_runner_->PostTaskAndReplyWithResult(
+          FROM_HERE,
+          base::BindOnce(&BraveRequestHandler::RunStagesOffUIThread, stages_,
+                         ctx),
+          base::BindOnce(&BraveRequestHandler::OnStagesRunOffUIThread,
+                         weak_factory_.GetWeakPtr(), ctx));
+      return;
     }
-  } else if (ctx->event_type == brave::kOnBeforeStartTransaction) {
-    while (before_start_transaction_callbacks_.size() !=
-           ctx->next_url_request_index) {
-      brave::OnBeforeStartTransactionCallback callback =
-          before_start_transaction_callbacks_[ctx->next_url_request_index++];
-      brave::ResponseCallback next_callback =
-          base::BindRepeating(&BraveRequestHandler::RunNextCallback,
-                              weak_factory_.GetWeakPtr(), ctx);
-      rv = callback.Run(ctx->headers, next_callback, ctx);
-      if (rv == net::ERR_IO_PENDING) {
-        return;
-      }
-      if (rv != net::OK) {
-        break;
-      }
+
+    ctx->next_url_request_index++;
+    if (stage.mode == StageMode::kAsync) {
+      rv = RunStage(stage,
+                    base::BindRepeating(&BraveRequestHandler::RunNextCallback,
+                                        weak_factory_.GetWeakPtr(), ctx),
+                    ctx);
+    } else {
+      rv = RunStage(stage, no_continuation, ctx);
+      DCHECK_NE(rv, net::ERR_IO_PENDING) << stage.histogram_name;
     }
-  } else if (ctx->event_type == brave::kOnHeadersReceived) {
-    while (headers_received_callbacks_.size() != ctx->next_url_request_index) {
-      brave::OnHeadersReceivedCallback callback =
-          headers_received_callbacks_[ctx->next_url_request_index++];
-      brave::ResponseCallback next_callback =
-          base::BindRepeating(&BraveRequestHandler::RunNextCallback,
-                              weak_factory_.GetWeakPtr(), ctx);
-      rv = callback.Run(ctx->original_response_headers,
-                        ctx->override_response_headers,
-                        ctx->allowed_unsafe_redirect_url, next_callback, ctx);
-      if (rv == net::ERR_IO_PENDING) {
-        return;
-      }
-      if (rv != net::OK) {
-        break;
-      }
+
+    if (rv == net::ERR_IO_PENDING) {
+      return;
+    }
+    if (rv != net::OK) {
+      break;
     }
   }
 
@@ -11,12 +11,18 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/ref_counted.h"
+#include "base/sequenced_task_runner.h"
 #include "brave/browser/net/url_context.h"
 #include "content/public/browser/browser_thread.h"
 #include "net/base/completion_once_callback.h"
 
 class PrefChangeRegistrar;
 
+namespace base {
+class HistogramBase;
+}  // namespace base
+
 // Contains different network stack hooks (similar to capabilities of WebRequest
 // API).
 class BraveRequestHandler {
@@ -44,7 +50,61 @@ class BraveRequestHandler {
   void RunCallbackForRequestIdentifier(uint64_t request_identifier, int rv);
 
  private:
+  // Synchronous stages finish their work before returning and must never
+  // return net::ERR_IO_PENDING. Only asynchronous stages are handed a
+  // continuation that resumes the pipeline.
+  enum class StageMode { kSync, kAsync };
+
+  // Stages that only read and write |ctx| may run on |off_ui_task_runner_|
+  // when kBraveRequestHandlerOffUIThread is enabled. Everything that touches
+  // profiles, WebContents, services or memory owned by the caller stays on the
+  // UI thread.
+  enum class StageAffinity { kUIThread, kAnySequence };
+
+  // One helper in the request pipeline. Exactly one of the callbacks is set,
+  // matching |event_type|.
+  struct Stage {
+    Stage();
+    Stage(const Stage&);
+    ~Stage();
+
+    brave::BraveNetworkDelegateEventType event_type = brave::kUnknownEventType;
+    StageMode mode = StageMode::kSync;
+    StageAffinity affinity = StageAffinity::kUIThread;
+    std::string histogram_name;
+    // Looked up once when the stage is added, so running a stage doesn't
+    // search the histogram registry by name.
+    base::HistogramBase* histogram = nullptr;
+    brave::OnBeforeURLRequestCallback before_url_request;
+    brave::OnBeforeStartTransactionCallback before_start_transaction;
+    brave::OnHeadersReceivedCallback headers_received;
+  };
+
   void SetupCallbacks();
+  using StageList = base::RefCountedData<std::vector<Stage>>;
+
+  void AddBeforeURLRequestStage(const char* name,
+                                StageMode mode,
+                                StageAffinity affinity,
+                                brave::OnBeforeURLRequestCallback callback);
+  void AddBeforeStartTransactionStage(
+      const char* name,
+      StageMode mode,
+      brave::OnBeforeStartTransactionCallback callback);
+  void AddHeadersReceivedStage(const char* name,
+                               StageMode mode,
+                               brave::OnHeadersReceivedCallback callback);
+  void AddStage(const char* name, StageMode mode, Stage stage);
+  bool HasStages(brave::BraveNetworkDelegateEventType event_type) const;
+  static int RunStage(const Stage& stage,
+                      const brave::ResponseCallback& next_callback,
+                      std::shared_ptr<brave::BraveRequestInfo> ctx);
+  // Runs the consecutive kAnySequence stages starting at the current index of
+  // |ctx|, on |off_ui_task_runner_|.
+  static int RunStagesOffUIThread(scoped_refptr<StageList> stages,
+                                  std::shared_ptr<brave::BraveRequestInfo> ctx);
+  void OnStagesRunOffUIThread(std::shared_ptr<brave::BraveRequestInfo> ctx,
+                              int rv);
   void InitPrefChangeRegistrar();
   void OnReferralHeadersChanged();
   void OnPreferenceChanged(const std::string& pref_name);
@@ -52,10 +112,14 @@ class BraveRequestHandler {
 
   void RunNextCallback(std::shared_ptr<brave::BraveRequestInfo> ctx);
 
-  std::vector<brave::OnBeforeURLRequestCallback> before_url_request_callbacks_;
-  std::vector<brave::OnBeforeStartTransactionCallback>
-      before_start_transaction_callbacks_;
-  std::vector<brave::OnHeadersReceivedCallback> headers_received_callbacks_;
+  // Stages for every event type, in the order they run. A request walks the
+  // whole list once per event and skips stages for other event types.
+  // Immutable once SetupCallbacks() returns, and shared with tasks running on
+  // |off_ui_task_runner_|.
+  scoped_refptr<StageList> stages_;
+  std::map<brave::BraveNetworkDelegateEventType, size_t> stage_counts_;
+  // Null unless kBraveRequestHandlerOffUIThread is enabled.
+  scoped_refptr<base::SequencedTaskRunner> off_ui_task_runner_;
 
   // TODO(iefremov): actually, we don't have to keep the list here, since
   // it is global for the whole browser and could live a singletonce in the
@@ -0,0 +1,106 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/brave_shields_settings_snapshot.h"
+
+#include <memory>
+#include <utility>
+
+#include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "chrome/browser/content_settings/host_content_settings_map_factory.h"
+#include "content/public/browser/browser_context.h"
+#include "content/public/browser/browser_thread.h"
+
+namespace brave {
+
+namespace {
+
+const char kShieldsSettingsSnapshotCacheKey[] =
+    "brave_shields_settings_snapshot_cache";
+
+constexpr size_t kMaxCachedSnapshots = 64;
+
+}  // namespace
+
+ShieldsSettingsSnapshot::ShieldsSettingsSnapshot(
+    bool allow_brave_shields,
+    bool allow_ads,
+    bool allow_http_upgradable_resource,
+    bool allow_referrers)
+    : allow_brave_shields_(allow_brave_shields),
+      allow_ads_(allow_ads),
+      allow_http_upgradable_resource_(allow_http_upgradable_resource),
+      allow_referrers_(allow_referrers) {}
+
+ShieldsSettingsSnapshot::~ShieldsSettingsSnapshot() = default;
+
+// static
+scoped_refptr<const ShieldsSettingsSnapshot> ShieldsSettingsSnapshot::Create(
+    HostContentSettingsMap* map,
+    const GURL& origin) {
+  return base::WrapRefCounted(new ShieldsSettingsSnapshot(
+      brave_shields::GetBraveShieldsEnabled(map, origin),
+      brave_shields::GetAdControlType(map, origin) ==
+          brave_shields::ControlType::ALLOW,
+      !brave_shields::GetHTTPSEverywhereEnabled(map, origin),
+      brave_shields::AllowReferrers(map, origin)));
+}
+
+ShieldsSettingsSnapshotCache::ShieldsSettingsSnapshotCache(
+    HostContentSettingsMap* map)
+    : map_(map), snapshots_(kMaxCachedSnapshots) {
+  observation_.Observe(map);
+}
+
+ShieldsSettingsSnapshotCache::~ShieldsSettingsSnapshotCache() = default;
+
+// static
+ShieldsSettingsSnapshotCache* ShieldsSettingsSnapshotCache::GetForBrowserContext(
+    content::BrowserContext* browser_context) {
+  DCHECK(browser_context);
+  ShieldsSettingsSnapshotCache* cache =
+      static_cast<ShieldsSettingsSnapshotCache*>(
+          browser_context->GetUserData(kShieldsSettingsSnapshotCacheKey));
+  if (!cache) {
+    // Object cleanup is handled by SupportsUserData
+    auto new_cache = std::make_unique<ShieldsSettingsSnapshotCache>(
+        HostContentSettingsMapFactory::GetForProfile(browser_context));
+    cache = new_cache.get();
+    browser_context->SetUserData(kShieldsSettingsSnapshotCacheKey,
+                                 std::move(new_cache));
+  }
+  return cache;
+}
+
+scoped_refptr<const ShieldsSettingsSnapshot> ShieldsSettingsSnapshotCache::Get(
+    const GURL& origin) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  auto it = snapshots_.Get(origin);
+  if (it != snapshots_.end())
+    return it->second;
+  auto snapshot = ShieldsSettingsSnapshot::Create(map_.get(), origin);
+  snapshots_.Put(origin, snapshot);
+  return snapshot;
+}
+
+void ShieldsSettingsSnapshotCache::OnContentSettingChanged(
+    const ContentSettingsPattern& primary_pattern,
+    const ContentSettingsPattern& secondary_pattern,
+    ContentSettingsType content_type) {
+  switch (content_type) {
+    case ContentSettingsType::BRAVE_SHIELDS:
+    case ContentSettingsType::BRAVE_ADS:
+    case ContentSettingsType::BRAVE_HTTP_UPGRADABLE_RESOURCES:
+    case ContentSettingsType::BRAVE_REFERRERS:
+    // Sent when every type changes at once, e.g. on clearing site settings.
+    case ContentSettingsType::DEFAULT:
+      snapshots_.Clear();
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace brave
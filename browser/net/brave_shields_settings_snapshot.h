@@ -0,0 +1,89 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_BROWSER_NET_BRAVE_SHIELDS_SETTINGS_SNAPSHOT_H_
+#define BRAVE_BROWSER_NET_BRAVE_SHIELDS_SETTINGS_SNAPSHOT_H_
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/scoped_observation.h"
+#include "base/supports_user_data.h"
+#include "components/content_settings/core/browser/content_settings_observer.h"
+#include "components/content_settings/core/browser/host_content_settings_map.h"
+#include "url/gurl.h"
+
+namespace content {
+class BrowserContext;
+}  // namespace content
+
+namespace brave {
+
+// The shields settings the network delegate helpers need for one top-frame
+// origin. Immutable, so it can be shared by every request from that origin
+// and read from any sequence.
+class ShieldsSettingsSnapshot
+    : public base::RefCountedThreadSafe<ShieldsSettingsSnapshot> {
+ public:
+  static scoped_refptr<const ShieldsSettingsSnapshot> Create(
+      HostContentSettingsMap* map,
+      const GURL& origin);
+
+  bool allow_brave_shields() const { return allow_brave_shields_; }
+  bool allow_ads() const { return allow_ads_; }
+  bool allow_http_upgradable_resource() const {
+    return allow_http_upgradable_resource_;
+  }
+  bool allow_referrers() const { return allow_referrers_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<ShieldsSettingsSnapshot>;
+
+  ShieldsSettingsSnapshot(bool allow_brave_shields,
+                          bool allow_ads,
+                          bool allow_http_upgradable_resource,
+                          bool allow_referrers);
+  ~ShieldsSettingsSnapshot();
+
+  const bool allow_brave_shields_;
+  const bool allow_ads_;
+  const bool allow_http_upgradable_resource_;
+  const bool allow_referrers_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShieldsSettingsSnapshot);
+};
+
+// Per-profile cache of snapshots keyed by top-frame origin, so subresources
+// don't repeat the same content settings lookups. Cleared whenever one of the
+// settings it covers changes.
+class ShieldsSettingsSnapshotCache : public base::SupportsUserData::Data,
+                                     public content_settings::Observer {
+ public:
+  explicit ShieldsSettingsSnapshotCache(HostContentSettingsMap* map);
+  ~ShieldsSettingsSnapshotCache() override;
+
+  static ShieldsSettingsSnapshotCache* GetForBrowserContext(
+      content::BrowserContext* browser_context);
+
+  scoped_refptr<const ShieldsSettingsSnapshot> Get(const GURL& origin);
+
+ private:
+  // content_settings::Observer:
+  void OnContentSettingChanged(const ContentSettingsPattern& primary_pattern,
+                               const ContentSettingsPattern& secondary_pattern,
+                               ContentSettingsType content_type) override;
+
+  scoped_refptr<HostContentSettingsMap> map_;
+  base::ScopedObservation<HostContentSettingsMap, content_settings::Observer>
+      observation_{this};
+  base::MRUCache<GURL, scoped_refptr<const ShieldsSettingsSnapshot>>
+      snapshots_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShieldsSettingsSnapshotCache);
+};
+
+}  // namespace brave
+
+#endif  // BRAVE_BROWSER_NET_BRAVE_SHIELDS_SETTINGS_SNAPSHOT_H_
@@ -0,0 +1,122 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/brave_shields_settings_snapshot.h"
+
+#include <memory>
+
+#include "base/test/scoped_feature_list.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/browser/net/url_context.h"
+#include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "brave/components/brave_shields/common/features.h"
+#include "chrome/browser/content_settings/host_content_settings_map_factory.h"
+#include "chrome/test/base/testing_profile.h"
+#include "content/public/test/browser_task_environment.h"
+#include "net/base/isolation_info.h"
+#include "services/network/public/cpp/resource_request.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+#include "url/origin.h"
+
+namespace brave {
+
+namespace {
+
+constexpr size_t kMakeCTXIterations = 10000;
+
+}  // namespace
+
+class ShieldsSettingsSnapshotTest : public testing::Test {
+ protected:
+  HostContentSettingsMap* map() {
+    return HostContentSettingsMapFactory::GetForProfile(&profile_);
+  }
+
+  ShieldsSettingsSnapshotCache* cache() {
+    return ShieldsSettingsSnapshotCache::GetForBrowserContext(&profile_);
+  }
+
+  // Times MakeCTX for subresources of one page.
+  double MakeCTXMicroseconds() {
+    const url::Origin tab_origin = url::Origin::Create(GURL("https://a.com"));
+    network::ResourceRequest request;
+    request.url = GURL("https://cdn.b.com/script.js");
+    request.request_initiator = tab_origin;
+    request.resource_type =
+        static_cast<int>(blink::mojom::ResourceType::kScript);
+    request.trusted_params = network::ResourceRequest::TrustedParams();
+    request.trusted_params->isolation_info =
+        net::IsolationInfo::CreateForInternalRequest(tab_origin);
+
+    base::ElapsedTimer timer;
+    for (size_t i = 0; i < kMakeCTXIterations; ++i) {
+      auto ctx = BraveRequestInfo::MakeCTX(request, 0, 0, i + 1, &profile_,
+                                           nullptr);
+      EXPECT_TRUE(ctx->allow_brave_shields);
+    }
+    return timer.Elapsed().InMicrosecondsF() / kMakeCTXIterations;
+  }
+
+  content::BrowserTaskEnvironment task_environment_;
+  TestingProfile profile_;
+};
+
+TEST_F(ShieldsSettingsSnapshotTest, MatchesContentSettings) {
+  const GURL origin("https://a.com/");
+  brave_shields::SetAdControlType(map(), brave_shields::ControlType::ALLOW,
+                                  origin);
+  brave_shields::SetHTTPSEverywhereEnabled(map(), false, origin);
+
+  auto snapshot = cache()->Get(origin);
+  EXPECT_EQ(brave_shields::GetBraveShieldsEnabled(map(), origin),
+            snapshot->allow_brave_shields());
+  EXPECT_TRUE(snapshot->allow_ads());
+  EXPECT_TRUE(snapshot->allow_http_upgradable_resource());
+  EXPECT_EQ(brave_shields::AllowReferrers(map(), origin),
+            snapshot->allow_referrers());
+
+  EXPECT_EQ(snapshot, cache()->Get(origin));
+  EXPECT_NE(snapshot, cache()->Get(GURL("https://b.com/")));
+}
+
+TEST_F(ShieldsSettingsSnapshotTest, InvalidatedBySettingsChange) {
+  const GURL origin("https://a.com/");
+  auto snapshot = cache()->Get(origin);
+  EXPECT_TRUE(snapshot->allow_brave_shields());
+
+  brave_shields::SetBraveShieldsEnabled(map(), false, origin);
+  auto updated = cache()->Get(origin);
+  EXPECT_NE(snapshot, updated);
+  EXPECT_FALSE(updated->allow_brave_shields());
+  // Snapshots already handed out don't change.
+  EXPECT_TRUE(snapshot->allow_brave_shields());
+}
+
+TEST_F(ShieldsSettingsSnapshotTest, MakeCTXThroughput) {
+  double uncached_us;
+  {
+    base::test::ScopedFeatureList feature_list;
+    feature_list.InitAndDisableFeature(
+        brave_shields::features::kBraveShieldsSettingsSnapshot);
+    uncached_us = MakeCTXMicroseconds();
+  }
+  double snapshot_us;
+  {
+    base::test::ScopedFeatureList feature_list;
+    feature_list.InitAndEnableFeature(
+        brave_shields::features::kBraveShieldsSettingsSnapshot);
+    snapshot_us = MakeCTXMicroseconds();
+  }
+
+  perf_test::PerfResultReporter reporter("BraveRequestInfo", "MakeCTX");
+  reporter.RegisterImportantMetric(".content_settings_lookups", "us");
+  reporter.RegisterImportantMetric(".settings_snapshot", "us");
+  reporter.AddResult(".content_settings_lookups", uncached_us);
+  reporter.AddResult(".settings_snapshot", snapshot_us);
+}
+
+}  // namespace brave
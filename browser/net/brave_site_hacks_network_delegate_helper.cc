@@ -9,90 +9,39 @@
 #include <string>
 #include <vector>
 
-#include "base/lazy_instance.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/no_destructor.h"
 #include "base/strings/string_util.h"
+#include "brave/browser/net/url_pattern_host_index.h"
 #include "brave/common/network_constants.h"
 #include "brave/common/url_constants.h"
 #include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "brave/components/brave_shields/browser/query_string_trackers.h"
 #include "content/public/common/referrer.h"
 #include "extensions/common/url_pattern.h"
 #include "net/base/registry_controlled_domains/registry_controlled_domain.h"
 #include "net/url_request/url_request.h"
 #include "third_party/blink/public/common/loader/network_utils.h"
 #include "third_party/blink/public/common/loader/referrer_utils.h"
-#include "third_party/re2/src/re2/re2.h"
 
 namespace brave {
 
 namespace {
 
-bool IsUAWhitelisted(const GURL& gurl) {
-  static std::vector<URLPattern> whitelist_patterns(
-      {URLPattern(URLPattern::SCHEME_ALL, "https://*.duckduckgo.com/*"),
-       // For Widevine
-       URLPattern(URLPattern::SCHEME_ALL, "https://*.netflix.com/*")});
-  return std::any_of(
-      whitelist_patterns.begin(), whitelist_patterns.end(),
-      [&gurl](URLPattern pattern) { return pattern.MatchesURL(gurl); });
+const URLPatternHostIndex& GetUAWhitelist() {
+  static const base::NoDestructor<URLPatternHostIndex> whitelist(
+      std::vector<URLPattern>(
+          {URLPattern(URLPattern::SCHEME_ALL, "https://*.duckduckgo.com/*"),
+           // For Widevine
+           URLPattern(URLPattern::SCHEME_ALL, "https://*.netflix.com/*")}));
+  return *whitelist;
 }
 
-const std::string& GetQueryStringTrackers() {
-  static const base::NoDestructor<std::string> trackers(base::JoinString(
-      std::vector<std::string>(
-          {// https://github.com/brave/brave-browser/issues/4239
-           "fbclid", "gclid", "msclkid", "mc_eid",
-           // https://github.com/brave/brave-browser/issues/9879
-           "dclid",
-           // https://github.com/brave/brave-browser/issues/13644
-           "oly_anon_id", "oly_enc_id",
-           // https://github.com/brave/brave-browser/issues/11579
-           "_openstat",
-           // https://github.com/brave/brave-browser/issues/11817
-           "vero_conv", "vero_id",
-           // https://github.com/brave/brave-browser/issues/13647
-           "wickedid",
-           // https://github.com/brave/brave-browser/issues/11578
-           "yclid",
-           // https://github.com/brave/brave-browser/issues/8975
-           "__s",
-           // https://github.com/brave/brave-browser/issues/9019
-           "_hsenc", "__hssc", "__hstc", "__hsfp", "hsCtaTracking"}),
-      "|"));
-  return *trackers;
+bool IsUAWhitelisted(const GURL& gurl) {
+  const URLPatternHostIndex& whitelist = GetUAWhitelist();
+  return whitelist.FindFirstMatch(gurl) < whitelist.size();
 }
 
-// From src/components/autofill/content/renderer/page_passwords_analyser.cc
-// and password_form_conversion_utils.cc:
-#define DECLARE_LAZY_MATCHER(NAME, PATTERN)                                   \
-  struct LabelPatternLazyInstanceTraits_##NAME                                \
-      : public base::internal::DestructorAtExitLazyInstanceTraits<re2::RE2> { \
-    static re2::RE2* New(void* instance) {                                    \
-      re2::RE2::Options options;                                              \
-      options.set_case_sensitive(false);                                      \
-      re2::RE2* matcher = new (instance) re2::RE2(PATTERN, options);          \
-      DCHECK(matcher->ok());                                                  \
-      return matcher;                                                         \
-    }                                                                         \
-  };                                                                          \
-  base::LazyInstance<re2::RE2, LabelPatternLazyInstanceTraits_##NAME> NAME =  \
-      LAZY_INSTANCE_INITIALIZER
-
-// e.g. "?fbclid=1234"
-DECLARE_LAZY_MATCHER(tracker_only_matcher,
-                     "^(" + GetQueryStringTrackers() + ")=[^&]+$");
-
-// e.g. "?fbclid=1234&foo=1"
-DECLARE_LAZY_MATCHER(tracker_first_matcher,
-                     "^(" + GetQueryStringTrackers() + ")=[^&]+&");
-
-// e.g. "?foo=1&fbclid=1234" or "?foo=1&fbclid=1234&bar=2"
-DECLARE_LAZY_MATCHER(tracker_appended_matcher,
-                     "&(" + GetQueryStringTrackers() + ")=[^&]+");
-
-#undef DECLARE_LAZY_MATCHER
-
 void ApplyPotentialQueryStringFilter(std::shared_ptr<BraveRequestInfo> ctx) {
   SCOPED_UMA_HISTOGRAM_TIMER("Brave.SiteHacks.QueryFilter");
 
@@ -122,20 +71,17 @@ void ApplyPotentialQueryStringFilter(std::shared_ptr<BraveRequestInfo> ctx) {
     return;
   }
 
-  std::string new_query = ctx->request_url.query();
-  // Note: the ordering of these replacements is important.
-  const int replacement_count =
-      re2::RE2::GlobalReplace(&new_query, tracker_appended_matcher.Get(), "") +
-      re2::RE2::GlobalReplace(&new_query, tracker_first_matcher.Get(), "") +
-      re2::RE2::GlobalReplace(&new_query, tracker_only_matcher.Get(), "");
+  const base::Optional<std::string> new_query =
+      brave_shields::QueryStringTrackers::GetCurrent()->StripTrackers(
+          ctx->request_url.query_piece());
 
-  if (replacement_count > 0) {
+  if (new_query) {
     url::Replacements<char> replacements;
-    if (new_query.empty()) {
+    if (new_query->empty()) {
       replacements.ClearQuery();
     } else {
-      replacements.SetQuery(new_query.c_str(),
-                            url::Component(0, new_query.size()));
+      replacements.SetQuery(new_query->c_str(),
+                            url::Component(0, new_query->size()));
     }
     ctx->new_url_spec = ctx->request_url.ReplaceComponents(replacements).spec();
   }
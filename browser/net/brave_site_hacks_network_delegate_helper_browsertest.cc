@@ -6,8 +6,10 @@
 #include "base/base64url.h"
 #include "base/path_service.h"
 #include "base/strings/stringprintf.h"
+#include "base/test/scoped_feature_list.h"
 #include "brave/common/brave_paths.h"
 #include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "chrome/browser/content_settings/host_content_settings_map_factory.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/browser/ui/browser.h"
@@ -255,3 +257,44 @@ IN_PROC_BROWSER_TEST_F(BraveSiteHacksNetworkDelegateBrowserTest,
     EXPECT_EQ(contents()->GetLastCommittedURL(), output);
   }
 }
+
+class BraveSiteHacksOffUIThreadBrowserTest
+    : public BraveSiteHacksNetworkDelegateBrowserTest {
+ public:
+  BraveSiteHacksOffUIThreadBrowserTest() {
+    feature_list_.InitAndEnableFeature(
+        brave_shields::features::kBraveRequestHandlerOffUIThread);
+  }
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// The query string filter runs on the request handler sequence here, and must
+// strip exactly what it strips on the UI thread.
+IN_PROC_BROWSER_TEST_F(BraveSiteHacksOffUIThreadBrowserTest,
+                       QueryStringFilterCrossSite) {
+  const std::string inputs[] = {
+      "", "foo=bar", "fbclid=1", "fbclid=2&key=value", "key=value&fbclid=3",
+  };
+  const std::string outputs[] = {
+      "", "foo=bar", "", "key=value", "key=value",
+  };
+
+  constexpr size_t input_count = base::size(inputs);
+  static_assert(input_count == base::size(outputs),
+                "Inputs and outputs must have the same number of elements.");
+
+  for (size_t i = 0; i < input_count; i++) {
+    NavigateToURLAndWaitForRedirects(
+        url(landing_url(inputs[i], simple_landing_url()), cross_site_url()),
+        landing_url(outputs[i], simple_landing_url()));
+  }
+}
+
+IN_PROC_BROWSER_TEST_F(BraveSiteHacksOffUIThreadBrowserTest,
+                       QueryStringFilterShieldsDown) {
+  const GURL dest_url = landing_url("fbclid=1", simple_landing_url());
+  brave_shields::SetBraveShieldsEnabled(content_settings(), false, dest_url);
+  NavigateToURLAndWaitForRedirects(url(dest_url, cross_site_url()), dest_url);
+}
@@ -5,12 +5,15 @@
 
 #include "brave/browser/net/brave_static_redirect_network_delegate_helper.h"
 
-#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include "base/strings/string_piece_forward.h"
+#include "base/no_destructor.h"
+#include "base/optional.h"
+#include "base/strings/string_piece.h"
+#include "brave/browser/net/url_pattern_host_index.h"
 #include "brave/browser/translate/buildflags/buildflags.h"
 #include "brave/common/network_constants.h"
 #include "brave/common/translate_network_constants.h"
@@ -31,6 +34,80 @@ base::StringPiece GetSafeBrowsingEndpoint() {
   return SAFEBROWSING_ENDPOINT;
 }
 
+enum class StaticRedirect {
+  kGeo,
+  kSafeBrowsing,
+  kSafeBrowsingFileCheck,
+  kSafeBrowsingCrxList,
+  kCrxDownload,
+  kAutofill,
+  kCRLSet,
+  kRedirectorProxy,
+#if BUILDFLAG(ENABLE_BRAVE_TRANSLATE_GO)
+  kTranslate,
+  kTranslateLanguage,
+#endif
+};
+
+// The redirect patterns indexed by host. Rules are checked in the order they
+// are added, and the first one that matches wins.
+struct StaticRedirectMatcher {
+  struct Rule {
+    StaticRedirect redirect;
+    // Only the host of the pattern has to match.
+    bool host_only = false;
+    // URLs matching this pattern are left alone.
+    base::Optional<URLPattern> exception;
+  };
+
+  StaticRedirectMatcher() {
+    const int kHttpOrHttps = URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS;
+    Add(URLPattern(URLPattern::SCHEME_HTTPS, kGeoLocationsPattern),
+        {StaticRedirect::kGeo});
+    Add(URLPattern(URLPattern::SCHEME_HTTPS, kSafeBrowsingPrefix),
+        {StaticRedirect::kSafeBrowsing, true});
+    Add(URLPattern(URLPattern::SCHEME_HTTPS, kSafeBrowsingFileCheckPrefix),
+        {StaticRedirect::kSafeBrowsingFileCheck, true});
+    Add(URLPattern(URLPattern::SCHEME_HTTPS, kSafeBrowsingCrxListPrefix),
+        {StaticRedirect::kSafeBrowsingCrxList, true});
+    Add(URLPattern(kHttpOrHttps, kCRXDownloadPrefix),
+        {StaticRedirect::kCrxDownload});
+    Add(URLPattern(URLPattern::SCHEME_HTTPS, kAutofillPrefix),
+        {StaticRedirect::kAutofill});
+    // To-Do (@jumde) - Update the naming for the CRLSet prefixes
+    // https://github.com/brave/brave-browser/issues/10314
+    Add(URLPattern(kHttpOrHttps, kCRLSetPrefix1), {StaticRedirect::kCRLSet});
+    Add(URLPattern(kHttpOrHttps, kCRLSetPrefix2), {StaticRedirect::kCRLSet});
+    Add(URLPattern(kHttpOrHttps, kCRLSetPrefix3), {StaticRedirect::kCRLSet});
+    Add(URLPattern(kHttpOrHttps, kCRLSetPrefix4), {StaticRedirect::kCRLSet});
+    Add(URLPattern(kHttpOrHttps, "*://*.gvt1.com/*"),
+        {StaticRedirect::kRedirectorProxy, false,
+         URLPattern(kHttpOrHttps, kWidevineGvt1Prefix)});
+    Add(URLPattern(kHttpOrHttps, "*://dl.google.com/*"),
+        {StaticRedirect::kRedirectorProxy, false,
+         URLPattern(kHttpOrHttps, kWidevineGoogleDlPrefix)});
+#if BUILDFLAG(ENABLE_BRAVE_TRANSLATE_GO)
+    Add(URLPattern(URLPattern::SCHEME_HTTPS, kTranslateElementJSPattern),
+        {StaticRedirect::kTranslate});
+    Add(URLPattern(URLPattern::SCHEME_HTTPS, kTranslateLanguagePattern),
+        {StaticRedirect::kTranslateLanguage});
+#endif
+  }
+
+  void Add(URLPattern pattern, Rule rule) {
+    index.Add(std::move(pattern));
+    rules.push_back(std::move(rule));
+  }
+
+  URLPatternHostIndex index;
+  std::vector<Rule> rules;
+};
+
+const StaticRedirectMatcher& GetStaticRedirectMatcher() {
+  static const base::NoDestructor<StaticRedirectMatcher> matcher;
+  return *matcher;
+}
+
 }  // namespace
 
 void SetSafeBrowsingEndpointForTesting(bool testing) {
@@ -52,150 +129,75 @@ int OnBeforeURLRequest_StaticRedirectWork(
 int OnBeforeURLRequest_StaticRedirectWorkForGURL(
     const GURL& request_url,
     GURL* new_url) {
-  GURL::Replacements replacements;
-  static URLPattern geo_pattern(URLPattern::SCHEME_HTTPS, kGeoLocationsPattern);
-  static URLPattern safeBrowsing_pattern(URLPattern::SCHEME_HTTPS,
-                                         kSafeBrowsingPrefix);
-  static URLPattern safebrowsingfilecheck_pattern(URLPattern::SCHEME_HTTPS,
-                                                  kSafeBrowsingFileCheckPrefix);
-  static URLPattern safebrowsingcrxlist_pattern(URLPattern::SCHEME_HTTPS,
-                                                kSafeBrowsingCrxListPrefix);
-
-  // To-Do (@jumde) - Update the naming for the variables below
-  // https://github.com/brave/brave-browser/issues/10314
-  static URLPattern crlSet_pattern1(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS, kCRLSetPrefix1);
-  static URLPattern crlSet_pattern2(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS, kCRLSetPrefix2);
-  static URLPattern crlSet_pattern3(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS, kCRLSetPrefix3);
-  static URLPattern crlSet_pattern4(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS, kCRLSetPrefix4);
-  static URLPattern crxDownload_pattern(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS, kCRXDownloadPrefix);
-  static URLPattern autofill_pattern(
-      URLPattern::SCHEME_HTTPS, kAutofillPrefix);
-  static URLPattern gvt1_pattern(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS, "*://*.gvt1.com/*");
-  static URLPattern googleDl_pattern(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS,
-      "*://dl.google.com/*");
-
-  static URLPattern widevine_gvt1_pattern(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS,
-      kWidevineGvt1Prefix);
-  static URLPattern widevine_google_dl_pattern(
-      URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS,
-      kWidevineGoogleDlPrefix);
+  const StaticRedirectMatcher& matcher = GetStaticRedirectMatcher();
+  std::vector<size_t> candidates;
+  matcher.index.GetCandidates(request_url, &candidates);
 
+  GURL::Replacements replacements;
+  for (size_t index : candidates) {
+    const StaticRedirectMatcher::Rule& rule = matcher.rules[index];
+    const URLPattern& pattern = matcher.index.pattern(index);
+    if (rule.host_only ? !pattern.MatchesHost(request_url)
+                       : !pattern.MatchesURL(request_url)) {
+      continue;
+    }
+    if (rule.exception && rule.exception->MatchesURL(request_url))
+      continue;
+
+    switch (rule.redirect) {
+      case StaticRedirect::kGeo:
+        *new_url = GURL(GOOGLEAPIS_ENDPOINT GOOGLEAPIS_API_KEY);
+        return net::OK;
+      case StaticRedirect::kSafeBrowsing:
+      case StaticRedirect::kSafeBrowsingFileCheck:
+      case StaticRedirect::kSafeBrowsingCrxList: {
+        auto safebrowsing_endpoint = GetSafeBrowsingEndpoint();
+        if (safebrowsing_endpoint.empty())
+          continue;
+        if (rule.redirect == StaticRedirect::kSafeBrowsing)
+          replacements.SetHostStr(safebrowsing_endpoint);
+        else if (rule.redirect == StaticRedirect::kSafeBrowsingFileCheck)
+          replacements.SetHostStr(kBraveSafeBrowsingSslProxy);
+        else
+          replacements.SetHostStr(kBraveSafeBrowsing2Proxy);
+        *new_url = request_url.ReplaceComponents(replacements);
+        return net::OK;
+      }
+      case StaticRedirect::kCrxDownload:
+        replacements.SetSchemeStr("https");
+        replacements.SetHostStr("crxdownload.brave.com");
+        *new_url = request_url.ReplaceComponents(replacements);
+        return net::OK;
+      case StaticRedirect::kAutofill:
+        replacements.SetSchemeStr("https");
+        replacements.SetHostStr(kBraveStaticProxy);
+        *new_url = request_url.ReplaceComponents(replacements);
+        return net::OK;
+      case StaticRedirect::kCRLSet:
+        replacements.SetSchemeStr("https");
+        replacements.SetHostStr("crlsets.brave.com");
+        *new_url = request_url.ReplaceComponents(replacements);
+        return net::OK;
+      case StaticRedirect::kRedirectorProxy:
+        replacements.SetSchemeStr("https");
+        replacements.SetHostStr(kBraveRedirectorProxy);
+        *new_url = request_url.ReplaceComponents(replacements);
+        return net::OK;
 #if BUILDFLAG(ENABLE_BRAVE_TRANSLATE_GO)
-  static URLPattern translate_pattern(URLPattern::SCHEME_HTTPS,
-      kTranslateElementJSPattern);
-  static URLPattern translate_language_pattern(URLPattern::SCHEME_HTTPS,
-      kTranslateLanguagePattern);
+      case StaticRedirect::kTranslate:
+        replacements.SetQueryStr(request_url.query_piece());
+        replacements.SetPathStr(request_url.path_piece());
+        *new_url =
+            GURL(kBraveTranslateEndpoint).ReplaceComponents(replacements);
+        return net::OK;
+      case StaticRedirect::kTranslateLanguage:
+        *new_url = GURL(kBraveTranslateLanguageEndpoint);
+        return net::OK;
 #endif
-  if (geo_pattern.MatchesURL(request_url)) {
-    *new_url = GURL(GOOGLEAPIS_ENDPOINT GOOGLEAPIS_API_KEY);
-    return net::OK;
-  }
-
-  auto safebrowsing_endpoint = GetSafeBrowsingEndpoint();
-  if (!safebrowsing_endpoint.empty() &&
-      safeBrowsing_pattern.MatchesHost(request_url)) {
-    replacements.SetHostStr(safebrowsing_endpoint);
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (!safebrowsing_endpoint.empty() &&
-      safebrowsingfilecheck_pattern.MatchesHost(request_url)) {
-    replacements.SetHostStr(kBraveSafeBrowsingSslProxy);
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (!safebrowsing_endpoint.empty() &&
-      safebrowsingcrxlist_pattern.MatchesHost(request_url)) {
-    replacements.SetHostStr(kBraveSafeBrowsing2Proxy);
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (crxDownload_pattern.MatchesURL(request_url)) {
-    replacements.SetSchemeStr("https");
-    replacements.SetHostStr("crxdownload.brave.com");
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
+    }
   }
 
-  if (autofill_pattern.MatchesURL(request_url)) {
-    replacements.SetSchemeStr("https");
-    replacements.SetHostStr(kBraveStaticProxy);
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (crlSet_pattern1.MatchesURL(request_url)) {
-    replacements.SetSchemeStr("https");
-    replacements.SetHostStr("crlsets.brave.com");
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (crlSet_pattern2.MatchesURL(request_url)) {
-    replacements.SetSchemeStr("https");
-    replacements.SetHostStr("crlsets.brave.com");
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (crlSet_pattern3.MatchesURL(request_url)) {
-    replacements.SetSchemeStr("https");
-    replacements.SetHostStr("crlsets.brave.com");
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (crlSet_pattern4.MatchesURL(request_url)) {
-    replacements.SetSchemeStr("https");
-    replacements.SetHostStr("crlsets.brave.com");
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (gvt1_pattern.MatchesURL(request_url) &&
-      !widevine_gvt1_pattern.MatchesURL(request_url)) {
-    replacements.SetSchemeStr("https");
-    replacements.SetHostStr(kBraveRedirectorProxy);
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (googleDl_pattern.MatchesURL(request_url) &&
-      !widevine_google_dl_pattern.MatchesURL(request_url)) {
-    replacements.SetSchemeStr("https");
-    replacements.SetHostStr(kBraveRedirectorProxy);
-    *new_url = request_url.ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-#if BUILDFLAG(ENABLE_BRAVE_TRANSLATE_GO)
-  if (translate_pattern.MatchesURL(request_url)) {
-    replacements.SetQueryStr(request_url.query_piece());
-    replacements.SetPathStr(request_url.path_piece());
-    *new_url =
-      GURL(kBraveTranslateEndpoint).ReplaceComponents(replacements);
-    return net::OK;
-  }
-
-  if (translate_language_pattern.MatchesURL(request_url)) {
-    *new_url = GURL(kBraveTranslateLanguageEndpoint);
-    return net::OK;
-  }
-#endif
-
   return net::OK;
 }
 
-
 }  // namespace brave
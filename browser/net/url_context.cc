@@ -8,8 +8,11 @@
 #include <memory>
 #include <string>
 
+#include "base/feature_list.h"
 #include "brave/browser/brave_shields/brave_shields_web_contents_observer.h"
+#include "brave/browser/net/brave_shields_settings_snapshot.h"
 #include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "brave/components/brave_webtorrent/browser/buildflags/buildflags.h"
 #include "brave/components/brave_webtorrent/browser/webtorrent_util.h"
 #include "brave/components/ipfs/buildflags/buildflags.h"
@@ -132,22 +135,30 @@ std::shared_ptr<brave::BraveRequestInfo> BraveRequestInfo::MakeCTX(
   }
 #endif
 
-  Profile* profile = Profile::FromBrowserContext(browser_context);
-  auto* map = HostContentSettingsMapFactory::GetForProfile(profile);
-  ctx->allow_brave_shields =
-      brave_shields::GetBraveShieldsEnabled(map, ctx->tab_origin);
-  ctx->allow_ads = brave_shields::GetAdControlType(map, ctx->tab_origin) ==
-                   brave_shields::ControlType::ALLOW;
-  ctx->allow_http_upgradable_resource =
-      !brave_shields::GetHTTPSEverywhereEnabled(map, ctx->tab_origin);
-
   // HACK: after we fix multiple creations of BraveRequestInfo we should
   // use only tab_origin. Since we recreate BraveRequestInfo during consequent
   // stages of navigation, |tab_origin| changes and so does |allow_referrers|
   // flag, which is not what we want for determining referrers.
-  ctx->allow_referrers = brave_shields::AllowReferrers(
-      map,
-      ctx->redirect_source.is_empty() ? ctx->tab_origin : ctx->redirect_source);
+  const GURL& referrers_origin =
+      ctx->redirect_source.is_empty() ? ctx->tab_origin : ctx->redirect_source;
+  if (base::FeatureList::IsEnabled(
+          brave_shields::features::kBraveShieldsSettingsSnapshot)) {
+    auto* cache =
+        ShieldsSettingsSnapshotCache::GetForBrowserContext(browser_context);
+    ctx->shields_settings = cache->Get(ctx->tab_origin);
+    ctx->allow_referrers =
+        cache->Get(referrers_origin.GetOrigin())->allow_referrers();
+  } else {
+    Profile* profile = Profile::FromBrowserContext(browser_context);
+    auto* map = HostContentSettingsMapFactory::GetForProfile(profile);
+    ctx->shields_settings =
+        ShieldsSettingsSnapshot::Create(map, ctx->tab_origin);
+    ctx->allow_referrers = brave_shields::AllowReferrers(map, referrers_origin);
+  }
+  ctx->allow_brave_shields = ctx->shields_settings->allow_brave_shields();
+  ctx->allow_ads = ctx->shields_settings->allow_ads();
+  ctx->allow_http_upgradable_resource =
+      ctx->shields_settings->allow_http_upgradable_resource();
   ctx->upload_data = GetUploadData(request);
 
   ctx->browser_context = browser_context;
@@ -10,6 +10,7 @@
 #include <set>
 #include <string>
 
+#include "base/memory/scoped_refptr.h"
 #include "net/base/network_isolation_key.h"
 #include "net/http/http_request_headers.h"
 #include "net/http/http_response_headers.h"
@@ -28,6 +29,7 @@ struct ResourceRequest;
 }
 
 namespace brave {
+class ShieldsSettingsSnapshot;
 struct BraveRequestInfo;
 using ResponseCallback = base::RepeatingCallback<void()>;
 }  // namespace brave
@@ -78,6 +80,8 @@ struct BraveRequestInfo {
   bool allow_http_upgradable_resource = false;
   bool allow_referrers = false;
   bool is_webtorrent_disabled = false;
+  // Settings for |tab_origin| that the allow_* fields above were copied from.
+  scoped_refptr<const ShieldsSettingsSnapshot> shields_settings;
   int frame_tree_node_id = 0;
   uint64_t request_identifier = 0;
   size_t next_url_request_index = 0;
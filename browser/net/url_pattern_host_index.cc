@@ -0,0 +1,81 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/url_pattern_host_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/strings/string_util.h"
+#include "url/gurl.h"
+
+namespace brave {
+
+URLPatternHostIndex::URLPatternHostIndex() = default;
+
+URLPatternHostIndex::URLPatternHostIndex(std::vector<URLPattern> patterns) {
+  for (auto& pattern : patterns)
+    Add(std::move(pattern));
+}
+
+URLPatternHostIndex::~URLPatternHostIndex() = default;
+
+size_t URLPatternHostIndex::Add(URLPattern pattern) {
+  const size_t index = patterns_.size();
+  const std::string host = base::ToLowerASCII(pattern.host());
+  if (pattern.match_all_urls() || (pattern.match_subdomains() && host.empty()))
+    all_hosts_.push_back(index);
+  else if (pattern.match_subdomains())
+    subdomain_hosts_[host].push_back(index);
+  else
+    exact_hosts_[host].push_back(index);
+  patterns_.push_back(std::move(pattern));
+  return index;
+}
+
+// static
+void URLPatternHostIndex::AddCandidates(const HostMap& map,
+                                        base::StringPiece host,
+                                        std::vector<size_t>* candidates) {
+  auto it = map.find(host);
+  if (it != map.end())
+    candidates->insert(candidates->end(), it->second.begin(), it->second.end());
+}
+
+void URLPatternHostIndex::GetCandidates(
+    const GURL& url,
+    std::vector<size_t>* candidates) const {
+  const size_t first_candidate = candidates->size();
+  candidates->insert(candidates->end(), all_hosts_.begin(), all_hosts_.end());
+
+  // GURL hosts are already lower case. URLPattern ignores a trailing dot.
+  base::StringPiece host = url.host_piece();
+  if (base::EndsWith(host, "."))
+    host.remove_suffix(1);
+  AddCandidates(exact_hosts_, host, candidates);
+
+  // Probe the host and each of its parent domains.
+  while (!host.empty()) {
+    AddCandidates(subdomain_hosts_, host, candidates);
+    const size_t dot = host.find('.');
+    if (dot == base::StringPiece::npos)
+      break;
+    host.remove_prefix(dot + 1);
+  }
+
+  std::sort(candidates->begin() + first_candidate, candidates->end());
+}
+
+size_t URLPatternHostIndex::FindFirstMatch(const GURL& url) const {
+  std::vector<size_t> candidates;
+  GetCandidates(url, &candidates);
+  for (size_t index : candidates) {
+    if (patterns_[index].MatchesURL(url))
+      return index;
+  }
+  return patterns_.size();
+}
+
+}  // namespace brave
@@ -0,0 +1,67 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_BROWSER_NET_URL_PATTERN_HOST_INDEX_H_
+#define BRAVE_BROWSER_NET_URL_PATTERN_HOST_INDEX_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+#include "extensions/common/url_pattern.h"
+
+class GURL;
+
+namespace brave {
+
+// An ordered list of URLPatterns indexed by the host they match, so a URL is
+// only checked against the few patterns that can match its host instead of
+// against every pattern in turn.
+class URLPatternHostIndex {
+ public:
+  URLPatternHostIndex();
+  explicit URLPatternHostIndex(std::vector<URLPattern> patterns);
+  ~URLPatternHostIndex();
+
+  // Adds |pattern| after all previously added ones and returns its index.
+  size_t Add(URLPattern pattern);
+
+  const URLPattern& pattern(size_t index) const { return patterns_[index]; }
+  size_t size() const { return patterns_.size(); }
+
+  // Appends the indices of the patterns whose host matches |url|'s host, in
+  // the order they were added. The caller still has to check the scheme and
+  // path of each candidate.
+  void GetCandidates(const GURL& url, std::vector<size_t>* candidates) const;
+
+  // Returns the index of the first pattern matching |url|, or size() if none
+  // does.
+  size_t FindFirstMatch(const GURL& url) const;
+
+ private:
+  using HostMap =
+      base::flat_map<std::string, std::vector<size_t>, std::less<>>;
+
+  static void AddCandidates(const HostMap& map,
+                            base::StringPiece host,
+                            std::vector<size_t>* candidates);
+
+  std::vector<URLPattern> patterns_;
+  // Patterns for exactly one host.
+  HostMap exact_hosts_;
+  // Patterns for a host and all of its subdomains.
+  HostMap subdomain_hosts_;
+  // Patterns that match every host.
+  std::vector<size_t> all_hosts_;
+
+  DISALLOW_COPY_AND_ASSIGN(URLPatternHostIndex);
+};
+
+}  // namespace brave
+
+#endif  // BRAVE_BROWSER_NET_URL_PATTERN_HOST_INDEX_H_
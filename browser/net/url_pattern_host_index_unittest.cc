@@ -0,0 +1,169 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/url_pattern_host_index.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/timer/elapsed_timer.h"
+#include "brave/browser/net/brave_static_redirect_network_delegate_helper.h"
+#include "brave/common/network_constants.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace brave {
+
+namespace {
+
+constexpr int kHttpOrHttps = URLPattern::SCHEME_HTTP | URLPattern::SCHEME_HTTPS;
+
+constexpr size_t kTraceRepetitions = 2000;
+
+// Synthetic subresource requests of a news article page, plus background
+// requests of the kind the browser makes itself.
+const char* const kRequestTrace[] = {
+    "https://news.example.com/2021/06/article.html",
+    "https://cdn.example.com/app.js",
+    "https://cdn.example.com/app.css",
+    "https://fonts.googleapis.com/css?family=Roboto",
+    "https://fonts.gstatic.com/s/roboto/v27/KFOmCnqEu92Fr1Mu4mxK.woff2",
+    "https://www.google-analytics.com/analytics.js",
+    "https://www.googletagmanager.com/gtm.js?id=GTM-XXXX",
+    "https://securepubads.g.doubleclick.net/tag/js/gpt.js",
+    "https://cdn.example.com/thumb1.jpg",
+    "https://cdn.example.com/thumb2.jpg",
+    "https://ajax.googleapis.com/ajax/libs/jquery/3.5.1/jquery.min.js",
+    "https://www.gstatic.com/recaptcha/releases/abc/recaptcha__en.js",
+    "https://connect.facebook.net/en_US/sdk.js",
+    "https://platform.twitter.com/widgets.js",
+    "https://i.ytimg.com/vi/abc/hqdefault.jpg",
+    "https://www.youtube.com/embed/abc",
+    "https://safebrowsing.googleapis.com/v4/threatListUpdates:fetch",
+    "https://redirector.gvt1.com/edgedl/release2/chrome_component/abc.crx3",
+    "https://dl.google.com/release2/chrome_component/abc/crl-set-1.crx3",
+    "https://www.googleapis.com/geolocation/v1/geolocate?key=abc",
+};
+
+std::vector<URLPattern> StaticRedirectPatterns() {
+  return {URLPattern(URLPattern::SCHEME_HTTPS, kGeoLocationsPattern),
+          URLPattern(URLPattern::SCHEME_HTTPS, kSafeBrowsingPrefix),
+          URLPattern(URLPattern::SCHEME_HTTPS, kSafeBrowsingFileCheckPrefix),
+          URLPattern(URLPattern::SCHEME_HTTPS, kSafeBrowsingCrxListPrefix),
+          URLPattern(kHttpOrHttps, kCRXDownloadPrefix),
+          URLPattern(URLPattern::SCHEME_HTTPS, kAutofillPrefix),
+          URLPattern(kHttpOrHttps, kCRLSetPrefix1),
+          URLPattern(kHttpOrHttps, kCRLSetPrefix2),
+          URLPattern(kHttpOrHttps, kCRLSetPrefix3),
+          URLPattern(kHttpOrHttps, kCRLSetPrefix4),
+          URLPattern(kHttpOrHttps, "*://*.gvt1.com/*"),
+          URLPattern(kHttpOrHttps, "*://dl.google.com/*"),
+          URLPattern(kHttpOrHttps, kWidevineGvt1Prefix),
+          URLPattern(kHttpOrHttps, kWidevineGoogleDlPrefix)};
+}
+
+size_t LinearFirstMatch(const std::vector<URLPattern>& patterns,
+                        const GURL& url) {
+  auto it = std::find_if(
+      patterns.begin(), patterns.end(),
+      [&url](const URLPattern& pattern) { return pattern.MatchesURL(url); });
+  return it - patterns.begin();
+}
+
+}  // namespace
+
+TEST(URLPatternHostIndexTest, CandidatesByHost) {
+  URLPatternHostIndex index;
+  index.Add(URLPattern(kHttpOrHttps, "*://*.example.com/*"));
+  index.Add(URLPattern(kHttpOrHttps, "*://a.example.com/*"));
+  index.Add(URLPattern(kHttpOrHttps, "*://*/ads/*"));
+  index.Add(URLPattern(kHttpOrHttps, "*://b.example.com/*"));
+
+  std::vector<size_t> candidates;
+  index.GetCandidates(GURL("https://a.example.com/"), &candidates);
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2}), candidates);
+
+  candidates.clear();
+  index.GetCandidates(GURL("https://example.com./"), &candidates);
+  EXPECT_EQ(std::vector<size_t>({0, 2}), candidates);
+
+  candidates.clear();
+  index.GetCandidates(GURL("https://example.org/"), &candidates);
+  EXPECT_EQ(std::vector<size_t>({2}), candidates);
+}
+
+TEST(URLPatternHostIndexTest, FirstMatchIsInInsertionOrder) {
+  URLPatternHostIndex index;
+  index.Add(URLPattern(kHttpOrHttps, "*://a.example.com/first/*"));
+  index.Add(URLPattern(kHttpOrHttps, "*://*.example.com/*"));
+  index.Add(URLPattern(kHttpOrHttps, "*://a.example.com/*"));
+
+  EXPECT_EQ(0u, index.FindFirstMatch(GURL("https://a.example.com/first/x")));
+  EXPECT_EQ(1u, index.FindFirstMatch(GURL("https://a.example.com/second")));
+  EXPECT_EQ(3u, index.FindFirstMatch(GURL("https://example.org/")));
+  // The scheme and path still have to match.
+  EXPECT_EQ(3u, index.FindFirstMatch(GURL("ftp://a.example.com/")));
+}
+
+TEST(URLPatternHostIndexTest, MatchesLinearScan) {
+  const std::vector<URLPattern> patterns = StaticRedirectPatterns();
+  const URLPatternHostIndex index(patterns);
+  for (const char* url : kRequestTrace) {
+    EXPECT_EQ(LinearFirstMatch(patterns, GURL(url)),
+              index.FindFirstMatch(GURL(url)))
+        << url;
+  }
+}
+
+// Per-request cost of matching the static redirect patterns over a page load
+// trace, scanning every pattern vs. probing the host index.
+TEST(URLPatternHostIndexTest, PerRequestCost) {
+  const std::vector<URLPattern> patterns = StaticRedirectPatterns();
+  const URLPatternHostIndex index(patterns);
+  std::vector<GURL> trace;
+  for (const char* url : kRequestTrace)
+    trace.emplace_back(url);
+  const size_t request_count = trace.size() * kTraceRepetitions;
+
+  size_t matches = 0;
+  base::ElapsedTimer linear_timer;
+  for (size_t i = 0; i < kTraceRepetitions; ++i) {
+    for (const GURL& url : trace)
+      matches += LinearFirstMatch(patterns, url) < patterns.size();
+  }
+  const double linear_ns = linear_timer.Elapsed().InNanoseconds() /
+                           static_cast<double>(request_count);
+
+  base::ElapsedTimer index_timer;
+  for (size_t i = 0; i < kTraceRepetitions; ++i) {
+    for (const GURL& url : trace)
+      matches -= index.FindFirstMatch(url) < index.size();
+  }
+  const double index_ns = index_timer.Elapsed().InNanoseconds() /
+                          static_cast<double>(request_count);
+  EXPECT_EQ(0u, matches);
+
+  base::ElapsedTimer redirect_timer;
+  for (size_t i = 0; i < kTraceRepetitions; ++i) {
+    for (const GURL& url : trace) {
+      GURL new_url;
+      OnBeforeURLRequest_StaticRedirectWorkForGURL(url, &new_url);
+    }
+  }
+  const double redirect_ns = redirect_timer.Elapsed().InNanoseconds() /
+                             static_cast<double>(request_count);
+
+  perf_test::PerfResultReporter reporter("URLPatternHostIndex",
+                                         "StaticRedirects");
+  reporter.RegisterImportantMetric(".linear_scan", "ns");
+  reporter.RegisterImportantMetric(".host_index", "ns");
+  reporter.RegisterImportantMetric(".static_redirect_work", "ns");
+  reporter.AddResult(".linear_scan", linear_ns);
+  reporter.AddResult(".host_index", index_ns);
+  reporter.AddResult(".static_redirect_work", redirect_ns);
+}
+
+}  // namespace brave
@@ -10,6 +10,8 @@
 #include "../../../../net/cookies/cookie_monster.h"
 #undef CookieMonster
 
+#include "brave/net/cookies/brave_ephemeral_cookie_store.h"
+
 namespace net {
 
 class NET_EXPORT CookieMonster : public ChromiumCookieMonster {
@@ -25,7 +27,7 @@ class NET_EXPORT CookieMonster : public ChromiumCookieMonster {
   // CookieStore implementation.
   //
   // This only includes methods that needs special behavior to deal with
-  // our collection of ephemeral monsters.
+  // our ephemeral cookie store.
   void DeleteCanonicalCookieAsync(const CanonicalCookie& cookie,
                                   DeleteCallback callback) override;
   void DeleteAllCreatedInTimeRangeAsync(
@@ -48,11 +50,9 @@ class NET_EXPORT CookieMonster : public ChromiumCookieMonster {
                                         SetCookiesCallback callback);
 
  private:
-  NetLogWithSource net_log_;
-  std::map<std::string, std::unique_ptr<ChromiumCookieMonster>>
-      ephemeral_cookie_stores_;
-  ChromiumCookieMonster* GetOrCreateEphemeralCookieStoreForTopFrameURL(
-      const GURL& top_frame_url);
+  // Ephemeral cookies of every top frame, partitioned by ephemeral storage
+  // domain.
+  EphemeralCookieStore ephemeral_cookie_store_;
 };
 
 }  // namespace net
@@ -5,6 +5,10 @@
 
 #include "third_party/blink/renderer/core/execution_context/execution_context.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/command_line.h"
 #include "base/strings/string_number_conversions.h"
 #include "brave/third_party/blink/renderer/brave_farbling_constants.h"
@@ -22,6 +26,7 @@
 #include "third_party/blink/renderer/platform/network/network_utils.h"
 #include "third_party/blink/renderer/platform/supplementable.h"
 #include "third_party/blink/renderer/platform/wtf/text/string_builder.h"
+#include "third_party/boringssl/src/include/openssl/siphash.h"
 
 namespace {
 
@@ -31,25 +36,13 @@ inline uint64_t lfsr_next(uint64_t v) {
   return ((v >> 1) | (((v << 62) ^ (v << 61)) & (~(~zero << 63) << 62)));
 }
 
-float Identity(float value, size_t index) {
-  return value;
-}
-
-float ConstantMultiplier(double fudge_factor, float value, size_t index) {
-  return value * fudge_factor;
-}
+// Number of pseudo-random values generated before converting them to samples.
+// Stepping the LFSR is inherently serial, but the conversion loop is not.
+constexpr size_t kPseudoRandomBlockSize = 256;
 
-float PseudoRandomSequence(uint64_t seed, float value, size_t index) {
-  static uint64_t v;
+// Pseudo-random float between 0 and 0.1 for LFSR state |v|.
+inline float PseudoRandomSample(uint64_t v) {
   const double maxUInt64AsDouble = UINT64_MAX;
-  if (index == 0) {
-    // start of loop, reset to initial seed which was passed in and is based on
-    // the domain key
-    v = seed;
-  }
-  // get next value in PRNG sequence
-  v = lfsr_next(v);
-  // return pseudo-random float between 0 and 0.1
   return (v / maxUInt64AsDouble) / 10;
 }
 
@@ -60,6 +53,11 @@ namespace brave {
 const char kBraveSessionToken[] = "brave_session_token";
 const char BraveSessionCache::kSupplementName[] = "BraveSessionCache";
 const int kFarbledUserAgentMaxExtraSpaces = 5;
+// Canvases up to this size are HMACed whole to derive the farbling key.
+// Larger ones are digested with SipHash first.
+const size_t kMaxFullyHashedCanvasBytes = 256 * 1024;
+// Size of the HMAC-SHA256 key that picks the canvas pixels to perturb.
+const size_t kCanvasKeySize = 32;
 
 // acceptable letters for generating random strings
 const char kLettersForRandomStrings[] =
@@ -117,6 +115,11 @@ BraveSessionCache::BraveSessionCache(ExecutionContext& context)
   CHECK(h.Init(reinterpret_cast<const unsigned char*>(&session_key_),
                sizeof session_key_));
   CHECK(h.Sign(domain, domain_key_, sizeof domain_key_));
+  crypto::HMAC canvas_h(crypto::HMAC::SHA256);
+  uint8_t canvas_hash_key[32];
+  CHECK(canvas_h.Init(domain_key_, sizeof domain_key_));
+  CHECK(canvas_h.Sign("canvas", canvas_hash_key, sizeof canvas_hash_key));
+  memcpy(canvas_hash_key_, canvas_hash_key, sizeof canvas_hash_key_);
   farbling_enabled_ = true;
 }
 
@@ -130,7 +133,71 @@ BraveSessionCache& BraveSessionCache::From(ExecutionContext& context) {
   return *cache;
 }
 
-AudioFarblingCallback BraveSessionCache::GetAudioFarblingCallback(
+// static
+AudioFarblingHelper AudioFarblingHelper::ConstantMultiplier(
+    double fudge_factor) {
+  return AudioFarblingHelper(false, fudge_factor, 0);
+}
+
+// static
+AudioFarblingHelper AudioFarblingHelper::PseudoRandomSequence(uint64_t seed) {
+  return AudioFarblingHelper(true, 1.0, seed);
+}
+
+AudioFarblingHelper::AudioFarblingHelper(bool pseudo_random,
+                                         double fudge_factor,
+                                         uint64_t seed)
+    : pseudo_random_(pseudo_random),
+      fudge_factor_(fudge_factor),
+      seed_(seed),
+      state_(seed) {}
+
+AudioFarblingHelper::AudioFarblingHelper(const AudioFarblingHelper&) = default;
+AudioFarblingHelper& AudioFarblingHelper::operator=(
+    const AudioFarblingHelper&) = default;
+AudioFarblingHelper::~AudioFarblingHelper() = default;
+
+void AudioFarblingHelper::FarbleAudioChannel(base::span<float> data) const {
+  float* samples = data.data();
+  const size_t size = data.size();
+  if (!pseudo_random_) {
+    // The product is taken in double precision and then rounded, as the
+    // per-sample callback this replaced did; a float multiply (e.g.
+    // vector_math::Vsmul) would round differently. The loop has no
+    // dependencies between iterations, so it vectorizes as is.
+    const double fudge_factor = fudge_factor_;
+    for (size_t i = 0; i < size; ++i)
+      samples[i] = samples[i] * fudge_factor;
+    return;
+  }
+
+  uint64_t v = seed_;
+  uint64_t block[kPseudoRandomBlockSize];
+  for (size_t offset = 0; offset < size; offset += kPseudoRandomBlockSize) {
+    const size_t count = std::min(kPseudoRandomBlockSize, size - offset);
+    for (size_t i = 0; i < count; ++i) {
+      v = lfsr_next(v);
+      block[i] = v;
+    }
+    for (size_t i = 0; i < count; ++i)
+      samples[offset + i] = PseudoRandomSample(block[i]);
+  }
+}
+
+float AudioFarblingHelper::FarbleSample(float value, size_t index) {
+  if (!pseudo_random_)
+    return value * fudge_factor_;
+  if (index == 0) {
+    // start of loop, reset to initial seed which was passed in and is based on
+    // the domain key
+    state_ = seed_;
+  }
+  // get next value in PRNG sequence
+  state_ = lfsr_next(state_);
+  return PseudoRandomSample(state_);
+}
+
+base::Optional<AudioFarblingHelper> BraveSessionCache::GetAudioFarblingHelper(
     blink::WebContentSettingsClient* settings) {
   if (farbling_enabled_ && settings) {
     switch (settings->GetBraveFarblingLevel()) {
@@ -143,15 +210,15 @@ AudioFarblingCallback BraveSessionCache::GetAudioFarblingCallback(
         double fudge_factor = 0.99 + ((*fudge / maxUInt64AsDouble) / 100);
         VLOG(1) << "audio fudge factor (based on session token) = "
                 << fudge_factor;
-        return base::BindRepeating(&ConstantMultiplier, fudge_factor);
+        return AudioFarblingHelper::ConstantMultiplier(fudge_factor);
       }
       case BraveFarblingLevel::MAXIMUM: {
         uint64_t seed = *reinterpret_cast<uint64_t*>(domain_key_);
-        return base::BindRepeating(&PseudoRandomSequence, seed);
+        return AudioFarblingHelper::PseudoRandomSequence(seed);
       }
     }
   }
-  return base::BindRepeating(&Identity);
+  return base::nullopt;
 }
 
 void BraveSessionCache::PerturbPixels(blink::WebContentSettingsClient* settings,
@@ -187,14 +254,8 @@ void BraveSessionCache::PerturbPixelsInternal(const unsigned char* data,
   const size_t pixel_count = size / 4;
   // calculate initial seed to find first pixel to perturb, based on session
   // key, domain key, and canvas contents
-  crypto::HMAC h(crypto::HMAC::SHA256);
-  uint64_t session_plus_domain_key =
-      session_key_ ^ *reinterpret_cast<uint64_t*>(domain_key_);
-  CHECK(h.Init(reinterpret_cast<const unsigned char*>(&session_plus_domain_key),
-               sizeof session_plus_domain_key));
-  uint8_t canvas_key[32];
-  CHECK(h.Sign(base::StringPiece(reinterpret_cast<const char*>(pixels), size),
-               canvas_key, sizeof canvas_key));
+  uint8_t canvas_key[kCanvasKeySize];
+  MakeCanvasKey(pixels, size, canvas_key);
   uint64_t v = *reinterpret_cast<uint64_t*>(canvas_key);
   uint64_t pixel_index;
   // choose which channel (R, G, or B) to perturb
@@ -216,6 +277,30 @@ void BraveSessionCache::PerturbPixelsInternal(const unsigned char* data,
   }
 }
 
+void BraveSessionCache::MakeCanvasKey(const uint8_t* pixels,
+                                      size_t size,
+                                      uint8_t* canvas_key) {
+  crypto::HMAC h(crypto::HMAC::SHA256);
+  uint64_t session_plus_domain_key =
+      session_key_ ^ *reinterpret_cast<uint64_t*>(domain_key_);
+  CHECK(h.Init(reinterpret_cast<const unsigned char*>(&session_plus_domain_key),
+               sizeof session_plus_domain_key));
+  if (size <= kMaxFullyHashedCanvasBytes) {
+    CHECK(h.Sign(base::StringPiece(reinterpret_cast<const char*>(pixels), size),
+                 canvas_key, kCanvasKeySize));
+    return;
+  }
+
+  // HMAC-SHA256 over every pixel of a large canvas on each readback dominates
+  // the cost of farbling it. SipHash digests every byte several times faster,
+  // and is keyed per session and domain, so script can't find another canvas
+  // with the same digest. The key is still an HMAC, now over the digest.
+  const uint64_t message[] = {size, SIPHASH_24(canvas_hash_key_, pixels, size)};
+  CHECK(h.Sign(
+      base::StringPiece(reinterpret_cast<const char*>(message), sizeof message),
+      canvas_key, kCanvasKeySize));
+}
+
 WTF::String BraveSessionCache::GenerateRandomString(std::string seed,
                                                     wtf_size_t length) {
   uint8_t key[32];
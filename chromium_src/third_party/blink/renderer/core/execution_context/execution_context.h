@@ -10,7 +10,8 @@
 
 #include <random>
 
-#include "base/callback.h"
+#include "base/containers/span.h"
+#include "base/optional.h"
 
 namespace blink {
 class WebContentSettingsClient;
@@ -26,7 +27,33 @@ using blink::TraceTrait;
 
 namespace brave {
 
-typedef base::RepeatingCallback<float(float, size_t)> AudioFarblingCallback;
+// Farbles the samples WebAudio hands to script. Whole buffers go through
+// FarbleAudioChannel(); paths that farble an intermediate value one sample at a
+// time use FarbleSample(), which must see indices 0, 1, 2, ... in order.
+class CORE_EXPORT AudioFarblingHelper {
+ public:
+  // Scales every sample by |fudge_factor| (balanced farbling).
+  static AudioFarblingHelper ConstantMultiplier(double fudge_factor);
+  // Replaces every sample with a value in [0, 0.1] drawn from a sequence
+  // seeded by |seed| (maximum farbling).
+  static AudioFarblingHelper PseudoRandomSequence(uint64_t seed);
+
+  AudioFarblingHelper(const AudioFarblingHelper&);
+  AudioFarblingHelper& operator=(const AudioFarblingHelper&);
+  ~AudioFarblingHelper();
+
+  void FarbleAudioChannel(base::span<float> data) const;
+  float FarbleSample(float value, size_t index);
+
+ private:
+  AudioFarblingHelper(bool pseudo_random, double fudge_factor, uint64_t seed);
+
+  bool pseudo_random_;
+  double fudge_factor_;
+  uint64_t seed_;
+  // Position in the pseudo-random sequence for FarbleSample().
+  uint64_t state_;
+};
 
 CORE_EXPORT blink::WebContentSettingsClient* GetContentSettingsClientFor(
     ExecutionContext* context);
@@ -42,7 +69,8 @@ class CORE_EXPORT BraveSessionCache final
 
   static BraveSessionCache& From(ExecutionContext&);
 
-  AudioFarblingCallback GetAudioFarblingCallback(
+  // Returns nullopt when audio is not farbled for this context.
+  base::Optional<AudioFarblingHelper> GetAudioFarblingHelper(
       blink::WebContentSettingsClient* settings);
   void PerturbPixels(blink::WebContentSettingsClient* settings,
                      const unsigned char* data,
@@ -55,8 +83,11 @@ class CORE_EXPORT BraveSessionCache final
   bool farbling_enabled_;
   uint64_t session_key_;
   uint8_t domain_key_[32];
+  // SipHash key for digesting large canvases, derived from |domain_key_|.
+  uint64_t canvas_hash_key_[2];
 
   void PerturbPixelsInternal(const unsigned char* data, size_t size);
+  void MakeCanvasKey(const uint8_t* pixels, size_t size, uint8_t* canvas_key);
 };
 }  // namespace brave
 
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
 
 namespace brave_component_updater {
 
@@ -19,6 +20,8 @@ using DATFileDataBuffer = std::vector<unsigned char>;
 
 void GetDATFileData(const base::FilePath& file_path,
                     DATFileDataBuffer* buffer);
+bool MapDATFile(const base::FilePath& file_path,
+                base::MemoryMappedFile* mapped_file);
 std::string GetDATFileAsString(const base::FilePath& file_path);
 
 template<typename T>
@@ -41,6 +44,27 @@ LoadDATFileDataResult<T> LoadDATFileData(
       std::move(client), std::move(buffer));
 }
 
+// The second member is false if the file could not be mapped.
+template<typename T>
+using LoadMappedDATFileDataResult = std::pair<std::unique_ptr<T>, bool>;
+
+// Same as LoadDATFileData, but deserializes straight out of a read-only
+// mapping of the file instead of a heap copy. The mapping is released before
+// returning, so only the deserialized object outlives this call.
+template<typename T>
+LoadMappedDATFileDataResult<T> LoadMappedDATFileData(
+    const base::FilePath& dat_file_path) {
+  base::MemoryMappedFile mapped_file;
+  if (!MapDATFile(dat_file_path, &mapped_file))
+    return LoadMappedDATFileDataResult<T>(nullptr, false);
+
+  std::unique_ptr<T> client = std::make_unique<T>();
+  if (!client->deserialize(reinterpret_cast<const char*>(mapped_file.data()),
+                           mapped_file.length()))
+    client.reset();
+
+  return LoadMappedDATFileDataResult<T>(std::move(client), true);
+}
 
 }  // namespace brave_component_updater
 
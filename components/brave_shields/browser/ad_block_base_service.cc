@@ -6,11 +6,13 @@
 #include "brave/components/brave_shields/browser/ad_block_base_service.h"
 
 #include <algorithm>
+#include <atomic>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "base/bind.h"
+#include "base/feature_list.h"
 #include "base/files/file_path.h"
 #include "base/json/json_reader.h"
 #include "base/macros.h"
@@ -21,6 +23,7 @@
 #include "brave/components/adblock_rust_ffi/src/wrapper.h"
 #include "brave/components/brave_component_updater/browser/dat_file_util.h"
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
 #include "net/base/registry_controlled_domains/registry_controlled_domain.h"
@@ -32,6 +35,8 @@ using namespace net::registry_controlled_domains;  // NOLINT
 
 namespace {
 
+std::atomic<uint64_t> g_engine_generation{0};
+
 std::string ResourceTypeToString(blink::mojom::ResourceType resource_type) {
   std::string filter_option = "";
   switch (resource_type) {
@@ -182,6 +187,7 @@ void AdBlockBaseService::EnableTag(const std::string& tag, bool enabled) {
       tags_.erase(it);
     }
   }
+  BumpEngineGeneration();
 }
 
 void AdBlockBaseService::AddResources(const std::string& resources) {
@@ -194,6 +200,17 @@ void AdBlockBaseService::AddResources(const std::string& resources) {
 
   ad_block_client_->addResources(resources);
   resources_ = resources;
+  BumpEngineGeneration();
+}
+
+// static
+uint64_t AdBlockBaseService::GetEngineGeneration() {
+  return g_engine_generation.load(std::memory_order_acquire);
+}
+
+// static
+void AdBlockBaseService::BumpEngineGeneration() {
+  g_engine_generation.fetch_add(1, std::memory_order_acq_rel);
 }
 
 bool AdBlockBaseService::TagExists(const std::string& tag) {
@@ -216,6 +233,17 @@ base::Optional<base::Value> AdBlockBaseService::HiddenClassIdSelectors(
 }
 
 void AdBlockBaseService::GetDATFileData(const base::FilePath& dat_file_path) {
+  if (base::FeatureList::IsEnabled(features::kBraveAdblockMappedDATLoading)) {
+    base::ThreadPool::PostTaskAndReplyWithResult(
+        FROM_HERE, {base::MayBlock()},
+        base::BindOnce(
+            &brave_component_updater::LoadMappedDATFileData<adblock::Engine>,
+            dat_file_path),
+        base::BindOnce(&AdBlockBaseService::OnGetMappedDATFileData,
+                       weak_factory_.GetWeakPtr()));
+    return;
+  }
+
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, {base::MayBlock()},
       base::BindOnce(&brave_component_updater::LoadDATFileData<adblock::Engine>,
@@ -229,14 +257,28 @@ void AdBlockBaseService::OnGetDATFileData(GetDATFileDataResult result) {
     LOG(ERROR) << "Could not obtain ad block data";
     return;
   }
-  if (!result.first.get()) {
+  OnDATFileDataLoaded(std::move(result.first));
+}
+
+void AdBlockBaseService::OnGetMappedDATFileData(
+    GetMappedDATFileDataResult result) {
+  if (!result.second) {
+    LOG(ERROR) << "Could not obtain ad block data";
+    return;
+  }
+  OnDATFileDataLoaded(std::move(result.first));
+}
+
+void AdBlockBaseService::OnDATFileDataLoaded(
+    std::unique_ptr<adblock::Engine> ad_block_client) {
+  if (!ad_block_client) {
     LOG(ERROR) << "Failed to deserialize ad block data";
     return;
   }
   GetTaskRunner()->PostTask(
       FROM_HERE, base::BindOnce(&AdBlockBaseService::UpdateAdBlockClient,
                                 base::Unretained(this),
-                                std::move(result.first)));
+                                std::move(ad_block_client)));
 }
 
 void AdBlockBaseService::UpdateAdBlockClient(
@@ -245,6 +287,7 @@ void AdBlockBaseService::UpdateAdBlockClient(
   ad_block_client_ = std::move(ad_block_client);
   AddKnownTagsToAdBlockInstance();
   AddKnownResourcesToAdBlockInstance();
+  BumpEngineGeneration();
 }
 
 void AdBlockBaseService::AddKnownTagsToAdBlockInstance() {
@@ -271,6 +314,7 @@ void AdBlockBaseService::ResetForTest(const std::string& rules,
     resources_ = resources;
   }
   AddKnownResourcesToAdBlockInstance();
+  BumpEngineGeneration();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -37,6 +37,8 @@ class AdBlockBaseService : public BaseBraveShieldsService {
  public:
   using GetDATFileDataResult =
       brave_component_updater::LoadDATFileDataResult<adblock::Engine>;
+  using GetMappedDATFileDataResult =
+      brave_component_updater::LoadMappedDATFileDataResult<adblock::Engine>;
 
   explicit AdBlockBaseService(BraveComponent::Delegate* delegate);
   ~AdBlockBaseService() override;
@@ -56,6 +58,11 @@ class AdBlockBaseService : public BaseBraveShieldsService {
   void EnableTag(const std::string& tag, bool enabled);
   bool TagExists(const std::string& tag);
 
+  // Returns a counter that changes whenever the rules, tags or resources of
+  // any adblock engine change. Used to invalidate cached match results.
+  static uint64_t GetEngineGeneration();
+  static void BumpEngineGeneration();
+
   virtual base::Optional<base::Value> UrlCosmeticResources(
       const std::string& url);
   virtual base::Optional<base::Value> HiddenClassIdSelectors(
@@ -80,6 +87,8 @@ class AdBlockBaseService : public BaseBraveShieldsService {
   void UpdateAdBlockClient(
       std::unique_ptr<adblock::Engine> ad_block_client);
   void OnGetDATFileData(GetDATFileDataResult result);
+  void OnGetMappedDATFileData(GetMappedDATFileDataResult result);
+  void OnDATFileDataLoaded(std::unique_ptr<adblock::Engine> ad_block_client);
   void OnPreferenceChanges(const std::string& pref_name);
 
   std::vector<std::string> tags_;
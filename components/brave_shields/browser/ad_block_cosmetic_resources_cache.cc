@@ -0,0 +1,50 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_cosmetic_resources_cache.h"
+
+namespace brave_shields {
+
+AdBlockCosmeticResourcesCache::AdBlockCosmeticResourcesCache(size_t max_size)
+    : entries_(max_size) {}
+
+AdBlockCosmeticResourcesCache::~AdBlockCosmeticResourcesCache() = default;
+
+base::Optional<base::Value> AdBlockCosmeticResourcesCache::Get(
+    const std::string& url,
+    uint64_t generation) {
+  base::Optional<base::Value> resources;
+  auto it = entries_.Get(url);
+  if (it != entries_.end()) {
+    if (it->second.generation == generation)
+      resources = it->second.resources.Clone();
+    else
+      entries_.Erase(it);
+  }
+
+  if (resources)
+    ++hit_count_;
+  else
+    ++miss_count_;
+  return resources;
+}
+
+bool AdBlockCosmeticResourcesCache::Contains(const std::string& url,
+                                             uint64_t generation) const {
+  auto it = entries_.Peek(url);
+  return it != entries_.end() && it->second.generation == generation;
+}
+
+void AdBlockCosmeticResourcesCache::Put(const std::string& url,
+                                        uint64_t generation,
+                                        const base::Value& resources) {
+  entries_.Put(url, Entry{generation, resources.Clone()});
+}
+
+void AdBlockCosmeticResourcesCache::Clear() {
+  entries_.Clear();
+}
+
+}  // namespace brave_shields
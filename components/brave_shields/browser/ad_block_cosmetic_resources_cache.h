@@ -0,0 +1,61 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_COSMETIC_RESOURCES_CACHE_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_COSMETIC_RESOURCES_CACHE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/optional.h"
+#include "base/values.h"
+
+namespace brave_shields {
+
+// Bounded cache of the merged cosmetic resources for a page URL, as returned
+// by AdBlockService::UrlCosmeticResources. It is keyed on the full URL because
+// $generichide exceptions can match a path, not just the host. Entries are tagged with the engine
+// generation they were computed against and are treated as misses once any
+// engine has been swapped. Only used on the adblock task runner.
+class AdBlockCosmeticResourcesCache {
+ public:
+  static constexpr size_t kDefaultMaxSize = 32;
+
+  explicit AdBlockCosmeticResourcesCache(size_t max_size = kDefaultMaxSize);
+  ~AdBlockCosmeticResourcesCache();
+
+  // Returns a copy of the cached resources for |url|, if they were computed
+  // for |generation|.
+  base::Optional<base::Value> Get(const std::string& url, uint64_t generation);
+  // Whether resources for |url| computed for |generation| are cached, without
+  // touching the hit and miss counts or the recency order.
+  bool Contains(const std::string& url, uint64_t generation) const;
+  void Put(const std::string& url,
+           uint64_t generation,
+           const base::Value& resources);
+  void Clear();
+
+  size_t hit_count() const { return hit_count_; }
+  size_t miss_count() const { return miss_count_; }
+
+ private:
+  struct Entry {
+    uint64_t generation;
+    base::Value resources;
+  };
+
+  base::MRUCache<std::string, Entry> entries_;
+  size_t hit_count_ = 0;
+  size_t miss_count_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(AdBlockCosmeticResourcesCache);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_COSMETIC_RESOURCES_CACHE_H_
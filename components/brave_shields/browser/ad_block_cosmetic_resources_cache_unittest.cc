@@ -0,0 +1,88 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_cosmetic_resources_cache.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace brave_shields {
+
+namespace {
+
+base::Value MakeResources(const std::string& selector) {
+  base::Value resources(base::Value::Type::DICTIONARY);
+  base::Value hide_selectors(base::Value::Type::LIST);
+  hide_selectors.Append(selector);
+  resources.SetKey("hide_selectors", std::move(hide_selectors));
+  return resources;
+}
+
+}  // namespace
+
+TEST(AdBlockCosmeticResourcesCacheTest, ReturnsCopyForSameGeneration) {
+  AdBlockCosmeticResourcesCache cache;
+  const base::Value resources = MakeResources(".ad");
+  cache.Put("https://a.com/", 1, resources);
+
+  base::Optional<base::Value> cached = cache.Get("https://a.com/", 1);
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(resources, *cached);
+  EXPECT_FALSE(cache.Get("https://b.a.com/", 1));
+  EXPECT_EQ(1u, cache.hit_count());
+  EXPECT_EQ(1u, cache.miss_count());
+}
+
+// $generichide exceptions can match a path, so other pages on the same host
+// don't share an entry.
+TEST(AdBlockCosmeticResourcesCacheTest, KeyedOnFullURL) {
+  AdBlockCosmeticResourcesCache cache;
+  cache.Put("https://a.com/article", 1, MakeResources(".ad"));
+
+  EXPECT_TRUE(cache.Contains("https://a.com/article", 1));
+  EXPECT_FALSE(cache.Contains("https://a.com/", 1));
+  EXPECT_FALSE(cache.Get("https://a.com/", 1));
+}
+
+TEST(AdBlockCosmeticResourcesCacheTest, ContainsDoesNotCount) {
+  AdBlockCosmeticResourcesCache cache;
+  cache.Put("https://a.com/", 1, MakeResources(".ad"));
+
+  EXPECT_TRUE(cache.Contains("https://a.com/", 1));
+  EXPECT_FALSE(cache.Contains("https://a.com/", 2));
+  EXPECT_FALSE(cache.Contains("https://b.com/", 1));
+  EXPECT_EQ(0u, cache.hit_count());
+  EXPECT_EQ(0u, cache.miss_count());
+}
+
+TEST(AdBlockCosmeticResourcesCacheTest, EngineChangeInvalidates) {
+  AdBlockCosmeticResourcesCache cache;
+  cache.Put("https://a.com/", 1, MakeResources(".ad"));
+
+  EXPECT_FALSE(cache.Get("https://a.com/", 2));
+  // The stale entry is dropped rather than served to an older generation.
+  EXPECT_FALSE(cache.Get("https://a.com/", 1));
+
+  cache.Put("https://a.com/", 2, MakeResources(".banner"));
+  base::Optional<base::Value> cached = cache.Get("https://a.com/", 2);
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(MakeResources(".banner"), *cached);
+}
+
+TEST(AdBlockCosmeticResourcesCacheTest, Bounded) {
+  AdBlockCosmeticResourcesCache cache(2);
+  cache.Put("https://a.com/", 1, MakeResources(".a"));
+  cache.Put("https://b.com/", 1, MakeResources(".b"));
+  // Touch a.com so b.com is the least recently used.
+  EXPECT_TRUE(cache.Get("https://a.com/", 1));
+  cache.Put("https://c.com/", 1, MakeResources(".c"));
+
+  EXPECT_TRUE(cache.Get("https://a.com/", 1));
+  EXPECT_FALSE(cache.Get("https://b.com/", 1));
+  EXPECT_TRUE(cache.Get("https://c.com/", 1));
+}
+
+}  // namespace brave_shields
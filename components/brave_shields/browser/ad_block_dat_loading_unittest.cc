@@ -0,0 +1,155 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/path_service.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "brave/common/brave_paths.h"
+#include "brave/components/adblock_rust_ffi/src/wrapper.h"
+#include "brave/components/brave_component_updater/browser/dat_file_util.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace brave_shields {
+
+namespace {
+
+constexpr size_t kRegionalListCount = 5;
+
+base::FilePath GetAdBlockDataDir() {
+  base::FilePath test_data_dir;
+  base::PathService::Get(brave::DIR_TEST_DATA, &test_data_dir);
+  return test_data_dir.AppendASCII("adblock-data");
+}
+
+// The default list plus |kRegionalListCount| regional lists. Only one regional
+// list is checked in, so it stands in for all of them.
+std::vector<base::FilePath> GetDATFiles() {
+  const base::FilePath data_dir = GetAdBlockDataDir();
+  std::vector<base::FilePath> files;
+  files.push_back(data_dir.AppendASCII("adblock-default")
+                      .AppendASCII("rs-ABPFilterParserData.dat"));
+  for (size_t i = 0; i < kRegionalListCount; ++i) {
+    files.push_back(
+        data_dir.AppendASCII("adblock-regional")
+            .AppendASCII("9852EFC4-99E4-4F2D-A915-9C3196C7A1DE")
+            .AppendASCII("rs-9852EFC4-99E4-4F2D-A915-9C3196C7A1DE.dat"));
+  }
+  return files;
+}
+
+#if defined(OS_LINUX)
+// Returns the value in KiB of |field| (e.g. "VmRSS") in /proc/self/status.
+int64_t ReadProcStatusKiB(const std::string& field) {
+  std::string status;
+  if (!base::ReadFileToString(base::FilePath("/proc/self/status"), &status))
+    return -1;
+  for (const auto& line : base::SplitStringPiece(
+           status, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    if (!base::StartsWith(line, field + ":"))
+      continue;
+    std::vector<base::StringPiece> parts = base::SplitStringPiece(
+        line.substr(field.size() + 1), " ", base::TRIM_WHITESPACE,
+        base::SPLIT_WANT_NONEMPTY);
+    int64_t value = -1;
+    if (!parts.empty() && base::StringToInt64(parts[0], &value))
+      return value;
+  }
+  return -1;
+}
+
+// Resets VmHWM so the peak only covers what happens after this call.
+void ResetPeakRSS() {
+  base::WriteFile(base::FilePath("/proc/self/clear_refs"), "5");
+}
+
+// Reported while the loaded engines are still alive.
+void ReportMemory(const std::string& story) {
+  perf_test::PerfResultReporter reporter("AdBlockDATLoading", story);
+  reporter.RegisterImportantMetric(".peak_rss", "KiB");
+  reporter.RegisterImportantMetric(".steady_rss", "KiB");
+  reporter.AddResult(".peak_rss",
+                     static_cast<size_t>(ReadProcStatusKiB("VmHWM")));
+  reporter.AddResult(".steady_rss",
+                     static_cast<size_t>(ReadProcStatusKiB("VmRSS")));
+}
+#endif  // defined(OS_LINUX)
+
+}  // namespace
+
+TEST(AdBlockDATLoadingTest, MappedMatchesBuffered) {
+  const auto files = GetDATFiles();
+  for (const auto& file : files) {
+    auto buffered =
+        brave_component_updater::LoadDATFileData<adblock::Engine>(file);
+    auto mapped =
+        brave_component_updater::LoadMappedDATFileData<adblock::Engine>(file);
+    ASSERT_FALSE(buffered.second.empty());
+    ASSERT_TRUE(buffered.first);
+    ASSERT_TRUE(mapped.second);
+    ASSERT_TRUE(mapped.first);
+
+    bool buffered_rule = false, buffered_exception = false,
+         buffered_important = false;
+    bool mapped_rule = false, mapped_exception = false,
+         mapped_important = false;
+    std::string buffered_redirect, mapped_redirect;
+    buffered.first->matches("https://ad-delivery.net/ad.js", "ad-delivery.net",
+                            "example.com", true, "script", &buffered_rule,
+                            &buffered_exception, &buffered_important,
+                            &buffered_redirect);
+    mapped.first->matches("https://ad-delivery.net/ad.js", "ad-delivery.net",
+                          "example.com", true, "script", &mapped_rule,
+                          &mapped_exception, &mapped_important,
+                          &mapped_redirect);
+    EXPECT_EQ(buffered_rule, mapped_rule);
+    EXPECT_EQ(buffered_exception, mapped_exception);
+    EXPECT_EQ(buffered_important, mapped_important);
+    EXPECT_EQ(buffered_redirect, mapped_redirect);
+  }
+}
+
+TEST(AdBlockDATLoadingTest, MappedMissingFile) {
+  auto result = brave_component_updater::LoadMappedDATFileData<adblock::Engine>(
+      GetAdBlockDataDir().AppendASCII("does-not-exist.dat"));
+  EXPECT_FALSE(result.second);
+  EXPECT_FALSE(result.first);
+}
+
+#if defined(OS_LINUX)
+TEST(AdBlockDATLoadingTest, MemoryBuffered) {
+  std::vector<std::unique_ptr<adblock::Engine>> engines;
+  ResetPeakRSS();
+  for (const auto& file : GetDATFiles()) {
+    auto result =
+        brave_component_updater::LoadDATFileData<adblock::Engine>(file);
+    ASSERT_TRUE(result.first);
+    engines.push_back(std::move(result.first));
+  }
+  ReportMemory("buffered");
+}
+
+TEST(AdBlockDATLoadingTest, MemoryMapped) {
+  std::vector<std::unique_ptr<adblock::Engine>> engines;
+  ResetPeakRSS();
+  for (const auto& file : GetDATFiles()) {
+    auto result =
+        brave_component_updater::LoadMappedDATFileData<adblock::Engine>(file);
+    ASSERT_TRUE(result.first);
+    engines.push_back(std::move(result.first));
+  }
+  ReportMemory("mapped");
+}
+#endif  // defined(OS_LINUX)
+
+}  // namespace brave_shields
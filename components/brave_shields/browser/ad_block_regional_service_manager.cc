@@ -186,10 +186,12 @@ void AdBlockRegionalServiceManager::EnableFilterList(
       regional_service->Start();
       regional_services_.insert(
           std::make_pair(uuid, std::move(regional_service)));
+      AdBlockBaseService::BumpEngineGeneration();
     } else {
       DCHECK(it != regional_services_.end());
       it->second->Unregister();
       regional_services_.erase(it);
+      AdBlockBaseService::BumpEngineGeneration();
     }
   }
 
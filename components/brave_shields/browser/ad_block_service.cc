@@ -15,6 +15,7 @@
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/metrics/histogram_macros.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/threading/thread_restrictions.h"
@@ -62,6 +63,24 @@ std::string AdBlockService::g_ad_block_component_id_(kAdBlockComponentId);
 std::string AdBlockService::g_ad_block_component_base64_public_key_(
     kAdBlockComponentBase64PublicKey);
 
+AdBlockService::RequestQuery::RequestQuery() = default;
+AdBlockService::RequestQuery::RequestQuery(const RequestQuery&) = default;
+AdBlockService::RequestQuery::RequestQuery(RequestQuery&&) = default;
+AdBlockService::RequestQuery& AdBlockService::RequestQuery::operator=(
+    const RequestQuery&) = default;
+AdBlockService::RequestQuery& AdBlockService::RequestQuery::operator=(
+    RequestQuery&&) = default;
+AdBlockService::RequestQuery::~RequestQuery() = default;
+
+void AdBlockService::ShouldStartRequests(base::span<RequestQuery> queries) {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  for (auto& query : queries) {
+    ShouldStartRequest(query.url, query.resource_type, query.tab_host,
+                       &query.did_match_rule, &query.did_match_exception,
+                       &query.did_match_important, &query.mock_data_url);
+  }
+}
+
 void AdBlockService::ShouldStartRequest(
     const GURL& url,
     blink::mojom::ResourceType resource_type,
@@ -70,6 +89,47 @@ void AdBlockService::ShouldStartRequest(
     bool* did_match_exception,
     bool* did_match_important,
     std::string* mock_data_url) {
+  if (!did_match_rule || !did_match_exception || !did_match_important) {
+    ShouldStartRequestUncached(url, resource_type, tab_host, did_match_rule,
+                               did_match_exception, did_match_important,
+                               mock_data_url);
+    return;
+  }
+
+  const uint64_t generation = GetEngineGeneration();
+  const std::string key = AdBlockVerdictCache::ComputeKey(
+      url, resource_type, tab_host, *did_match_rule, *did_match_exception,
+      *did_match_important);
+
+  AdBlockVerdictCache::Verdict verdict;
+  if (!verdict_cache_.Get(key, generation, &verdict)) {
+    verdict.did_match_rule = *did_match_rule;
+    verdict.did_match_exception = *did_match_exception;
+    verdict.did_match_important = *did_match_important;
+    ShouldStartRequestUncached(url, resource_type, tab_host,
+                               &verdict.did_match_rule,
+                               &verdict.did_match_exception,
+                               &verdict.did_match_important,
+                               &verdict.mock_data_url);
+    verdict_cache_.Put(key, generation, verdict);
+  }
+
+  *did_match_rule = verdict.did_match_rule;
+  *did_match_exception = verdict.did_match_exception;
+  *did_match_important = verdict.did_match_important;
+  // The engines only write |mock_data_url| when a redirect rule matched.
+  if (mock_data_url && !verdict.mock_data_url.empty())
+    *mock_data_url = verdict.mock_data_url;
+}
+
+void AdBlockService::ShouldStartRequestUncached(
+    const GURL& url,
+    blink::mojom::ResourceType resource_type,
+    const std::string& tab_host,
+    bool* did_match_rule,
+    bool* did_match_exception,
+    bool* did_match_important,
+    std::string* mock_data_url) {
   AdBlockBaseService::ShouldStartRequest(
       url, resource_type, tab_host, did_match_rule, did_match_exception,
       did_match_important, mock_data_url);
@@ -109,6 +169,55 @@ base::Optional<std::string> AdBlockService::GetCspDirectives(
 
 base::Optional<base::Value> AdBlockService::UrlCosmeticResources(
     const std::string& url) {
+  if (!base::FeatureList::IsEnabled(
+          features::kBraveAdblockCosmeticResourcesCache)) {
+    return UrlCosmeticResourcesUncached(url);
+  }
+
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  const uint64_t generation = GetEngineGeneration();
+  base::Optional<base::Value> resources =
+      cosmetic_resources_cache_.Get(url, generation);
+  UMA_HISTOGRAM_BOOLEAN("Brave.Adblock.CosmeticResourcesCache.Hit",
+                        resources.has_value());
+  if (resources)
+    return resources;
+
+  resources = UrlCosmeticResourcesUncached(url);
+  MaybeCacheCosmeticResources(url, generation, resources);
+  return resources;
+}
+
+void AdBlockService::WarmCosmeticResourcesCache(const GURL& url) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  GetTaskRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&AdBlockService::WarmCosmeticResourcesCacheOnTaskRunner,
+                     base::Unretained(this), url.spec()));
+}
+
+void AdBlockService::WarmCosmeticResourcesCacheOnTaskRunner(
+    const std::string& url) {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  // Not recorded in the hit histogram, which measures what frames get.
+  const uint64_t generation = GetEngineGeneration();
+  if (cosmetic_resources_cache_.Contains(url, generation))
+    return;
+  MaybeCacheCosmeticResources(url, generation,
+                              UrlCosmeticResourcesUncached(url));
+}
+
+void AdBlockService::MaybeCacheCosmeticResources(
+    const std::string& url,
+    uint64_t generation,
+    const base::Optional<base::Value>& resources) {
+  // Failures aren't cached, e.g. while an engine is still loading.
+  if (resources && resources->is_dict())
+    cosmetic_resources_cache_.Put(url, generation, *resources);
+}
+
+base::Optional<base::Value> AdBlockService::UrlCosmeticResourcesUncached(
+    const std::string& url) {
   base::Optional<base::Value> resources =
       AdBlockBaseService::UrlCosmeticResources(url);
 
@@ -12,9 +12,12 @@
 #include <string>
 #include <vector>
 
+#include "base/containers/span.h"
 #include "base/optional.h"
 #include "base/values.h"
 #include "brave/components/brave_shields/browser/ad_block_base_service.h"
+#include "brave/components/brave_shields/browser/ad_block_cosmetic_resources_cache.h"
+#include "brave/components/brave_shields/browser/ad_block_verdict_cache.h"
 #include "components/keyed_service/core/keyed_service.h"
 #include "components/prefs/pref_registry_simple.h"
 #include "content/public/browser/browser_thread.h"
@@ -46,6 +49,26 @@ const char kAdBlockComponentBase64PublicKey[] =
 // The brave shields service in charge of ad-block checking and init.
 class AdBlockService : public AdBlockBaseService {
  public:
+  // A single network request to be matched by ShouldStartRequests. The match
+  // flags are both inputs and outputs, as with ShouldStartRequest.
+  struct RequestQuery {
+    RequestQuery();
+    RequestQuery(const RequestQuery&);
+    RequestQuery(RequestQuery&&);
+    RequestQuery& operator=(const RequestQuery&);
+    RequestQuery& operator=(RequestQuery&&);
+    ~RequestQuery();
+
+    GURL url;
+    blink::mojom::ResourceType resource_type =
+        blink::mojom::ResourceType::kSubResource;
+    std::string tab_host;
+    bool did_match_rule = false;
+    bool did_match_exception = false;
+    bool did_match_important = false;
+    std::string mock_data_url;
+  };
+
   explicit AdBlockService(BraveComponent::Delegate* delegate);
   ~AdBlockService() override;
 
@@ -56,6 +79,9 @@ class AdBlockService : public AdBlockBaseService {
                           bool* did_match_exception,
                           bool* did_match_important,
                           std::string* mock_data_url) override;
+  // Matches a batch of requests in one go, so callers can check a page's
+  // subresources with a single task on the adblock task runner.
+  void ShouldStartRequests(base::span<RequestQuery> queries);
   base::Optional<std::string> GetCspDirectives(
       const GURL& url,
       blink::mojom::ResourceType resource_type,
@@ -66,6 +92,9 @@ class AdBlockService : public AdBlockBaseService {
       const std::vector<std::string>& classes,
       const std::vector<std::string>& ids,
       const std::vector<std::string>& exceptions) override;
+  // Computes the cosmetic resources for |url| on the adblock task runner
+  // ahead of time, so they are cached by the time the frame asks for them.
+  void WarmCosmeticResourcesCache(const GURL& url);
 
   AdBlockRegionalServiceManager* regional_service_manager();
   AdBlockCustomFiltersService* custom_filters_service();
@@ -79,6 +108,25 @@ class AdBlockService : public AdBlockBaseService {
   void OnRegionalCatalogFileDataReady(const std::string& catalog_json);
 
  private:
+  // Runs the request through the default, regional and custom engines without
+  // consulting |verdict_cache_|.
+  void ShouldStartRequestUncached(const GURL& url,
+                                  blink::mojom::ResourceType resource_type,
+                                  const std::string& tab_host,
+                                  bool* did_match_rule,
+                                  bool* did_match_exception,
+                                  bool* did_match_important,
+                                  std::string* mock_data_url);
+  // Queries and merges the default, regional and custom engines without
+  // consulting |cosmetic_resources_cache_|.
+  base::Optional<base::Value> UrlCosmeticResourcesUncached(
+      const std::string& url);
+  void WarmCosmeticResourcesCacheOnTaskRunner(const std::string& url);
+  void MaybeCacheCosmeticResources(
+      const std::string& url,
+      uint64_t generation,
+      const base::Optional<base::Value>& resources);
+
   friend class ::AdBlockServiceTest;
   friend class ::DomainBlockTest;
   static std::string g_ad_block_component_id_;
@@ -95,6 +143,10 @@ class AdBlockService : public AdBlockBaseService {
 
   BraveComponent::Delegate* component_delegate_;
 
+  AdBlockVerdictCache verdict_cache_;
+  // Only accessed on the adblock task runner.
+  AdBlockCosmeticResourcesCache cosmetic_resources_cache_;
+
   base::WeakPtrFactory<AdBlockService> weak_factory_{this};
   DISALLOW_COPY_AND_ASSIGN(AdBlockService);
 };
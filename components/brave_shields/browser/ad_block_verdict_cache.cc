@@ -0,0 +1,95 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_verdict_cache.h"
+
+#include "base/check_op.h"
+#include "base/hash/hash.h"
+#include "base/metrics/histogram_macros.h"
+#include "url/gurl.h"
+
+namespace brave_shields {
+
+AdBlockVerdictCache::Shard::Shard(size_t max_size) : entries(max_size) {}
+
+AdBlockVerdictCache::Shard::~Shard() = default;
+
+AdBlockVerdictCache::AdBlockVerdictCache(size_t shard_count,
+                                         size_t entries_per_shard) {
+  DCHECK_GT(shard_count, 0u);
+  for (size_t i = 0; i < shard_count; ++i)
+    shards_.push_back(std::make_unique<Shard>(entries_per_shard));
+}
+
+AdBlockVerdictCache::~AdBlockVerdictCache() = default;
+
+// static
+std::string AdBlockVerdictCache::ComputeKey(
+    const GURL& url,
+    blink::mojom::ResourceType resource_type,
+    const std::string& tab_host,
+    bool did_match_rule,
+    bool did_match_exception,
+    bool did_match_important) {
+  std::string key = url.possibly_invalid_spec();
+  key.reserve(key.size() + tab_host.size() + 6);
+  key.push_back('\n');
+  key.append(tab_host);
+  key.push_back('\n');
+  key.push_back(static_cast<char>(resource_type));
+  key.push_back(did_match_rule ? '1' : '0');
+  key.push_back(did_match_exception ? '1' : '0');
+  key.push_back(did_match_important ? '1' : '0');
+  return key;
+}
+
+AdBlockVerdictCache::Shard* AdBlockVerdictCache::GetShard(
+    const std::string& key) {
+  return shards_[base::FastHash(key) % shards_.size()].get();
+}
+
+bool AdBlockVerdictCache::Get(const std::string& key,
+                              uint64_t generation,
+                              Verdict* verdict) {
+  DCHECK(verdict);
+  bool hit = false;
+  {
+    Shard* shard = GetShard(key);
+    base::AutoLock lock(shard->lock);
+    auto it = shard->entries.Get(key);
+    if (it != shard->entries.end()) {
+      if (it->second.generation == generation) {
+        *verdict = it->second.verdict;
+        hit = true;
+      } else {
+        shard->entries.Erase(it);
+      }
+    }
+  }
+
+  if (hit)
+    ++hit_count_;
+  else
+    ++miss_count_;
+  UMA_HISTOGRAM_BOOLEAN("Brave.Adblock.VerdictCache.Hit", hit);
+  return hit;
+}
+
+void AdBlockVerdictCache::Put(const std::string& key,
+                              uint64_t generation,
+                              const Verdict& verdict) {
+  Shard* shard = GetShard(key);
+  base::AutoLock lock(shard->lock);
+  shard->entries.Put(key, Entry{generation, verdict});
+}
+
+void AdBlockVerdictCache::Clear() {
+  for (auto& shard : shards_) {
+    base::AutoLock lock(shard->lock);
+    shard->entries.Clear();
+  }
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,87 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_VERDICT_CACHE_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_VERDICT_CACHE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
+
+class GURL;
+
+namespace brave_shields {
+
+// Bounded, sharded cache of network filter verdicts, keyed by the full
+// (url, tab_host, resource_type) tuple along with the incoming match flags.
+// Entries are tagged with the engine generation they were computed against
+// and are treated as misses once the generation moves on.
+class AdBlockVerdictCache {
+ public:
+  struct Verdict {
+    bool did_match_rule = false;
+    bool did_match_exception = false;
+    bool did_match_important = false;
+    std::string mock_data_url;
+  };
+
+  static constexpr size_t kDefaultShardCount = 8;
+  static constexpr size_t kDefaultEntriesPerShard = 512;
+
+  explicit AdBlockVerdictCache(
+      size_t shard_count = kDefaultShardCount,
+      size_t entries_per_shard = kDefaultEntriesPerShard);
+  ~AdBlockVerdictCache();
+
+  // The incoming flags are part of the key because the engines skip some
+  // checks depending on what previous engines already matched.
+  static std::string ComputeKey(const GURL& url,
+                                blink::mojom::ResourceType resource_type,
+                                const std::string& tab_host,
+                                bool did_match_rule,
+                                bool did_match_exception,
+                                bool did_match_important);
+
+  bool Get(const std::string& key, uint64_t generation, Verdict* verdict);
+  void Put(const std::string& key, uint64_t generation, const Verdict& verdict);
+  void Clear();
+
+  size_t hit_count() const { return hit_count_; }
+  size_t miss_count() const { return miss_count_; }
+
+ private:
+  struct Entry {
+    uint64_t generation;
+    Verdict verdict;
+  };
+
+  struct Shard {
+    explicit Shard(size_t max_size);
+    ~Shard();
+
+    base::Lock lock;
+    base::HashingMRUCache<std::string, Entry> entries;
+  };
+
+  Shard* GetShard(const std::string& key);
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> hit_count_{0};
+  std::atomic<size_t> miss_count_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(AdBlockVerdictCache);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_VERDICT_CACHE_H_
@@ -0,0 +1,150 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <set>
+#include <string>
+
+#include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "brave/components/brave_shields/browser/ad_block_verdict_cache.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace brave_shields {
+
+namespace {
+
+struct TraceEntry {
+  const char* url;
+  const char* tab_host;
+  blink::mojom::ResourceType resource_type;
+};
+
+// Synthetic subresource requests of a news article page, written by hand
+// to repeat the same script and tracking pixel requests.
+const TraceEntry kRequestTrace[] = {
+    {"https://cdn.example.com/app.js", "news.example.com",
+     blink::mojom::ResourceType::kScript},
+    {"https://ads.tracker.net/pixel.gif", "news.example.com",
+     blink::mojom::ResourceType::kImage},
+    {"https://cdn.example.com/app.css", "news.example.com",
+     blink::mojom::ResourceType::kStylesheet},
+    {"https://ads.tracker.net/pixel.gif", "news.example.com",
+     blink::mojom::ResourceType::kImage},
+    {"https://cdn.example.com/thumb1.jpg", "news.example.com",
+     blink::mojom::ResourceType::kImage},
+    {"https://ads.tracker.net/pixel.gif", "news.example.com",
+     blink::mojom::ResourceType::kImage},
+    {"https://cdn.example.com/app.js", "news.example.com",
+     blink::mojom::ResourceType::kScript},
+    {"https://ads.tracker.net/pixel.gif", "blog.example.org",
+     blink::mojom::ResourceType::kImage},
+    {"https://cdn.example.com/thumb1.jpg", "news.example.com",
+     blink::mojom::ResourceType::kImage},
+    {"https://cdn.example.com/app.js", "news.example.com",
+     blink::mojom::ResourceType::kXhr},
+    {"https://ads.tracker.net/pixel.gif", "news.example.com",
+     blink::mojom::ResourceType::kImage},
+    {"https://cdn.example.com/app.css", "news.example.com",
+     blink::mojom::ResourceType::kStylesheet},
+};
+
+// Stand-in for the engines: blocks anything served from ads.tracker.net.
+AdBlockVerdictCache::Verdict Match(const TraceEntry& entry) {
+  AdBlockVerdictCache::Verdict verdict;
+  verdict.did_match_rule = GURL(entry.url).host() == "ads.tracker.net";
+  return verdict;
+}
+
+std::string KeyFor(const TraceEntry& entry) {
+  return AdBlockVerdictCache::ComputeKey(GURL(entry.url), entry.resource_type,
+                                         entry.tab_host, false, false, false);
+}
+
+// Replays |kRequestTrace| against |cache| and returns the number of times the
+// engines had to be consulted.
+size_t ReplayTrace(AdBlockVerdictCache* cache, uint64_t generation) {
+  size_t engine_queries = 0;
+  for (const auto& entry : kRequestTrace) {
+    const std::string key = KeyFor(entry);
+    AdBlockVerdictCache::Verdict verdict;
+    if (!cache->Get(key, generation, &verdict)) {
+      ++engine_queries;
+      verdict = Match(entry);
+      cache->Put(key, generation, verdict);
+    }
+    EXPECT_EQ(Match(entry).did_match_rule, verdict.did_match_rule);
+  }
+  return engine_queries;
+}
+
+size_t UniqueKeysInTrace() {
+  std::set<std::string> keys;
+  for (const auto& entry : kRequestTrace)
+    keys.insert(KeyFor(entry));
+  return keys.size();
+}
+
+}  // namespace
+
+TEST(AdBlockVerdictCacheTest, ReplayTraceHitsOnRepeatedTuples) {
+  AdBlockVerdictCache cache;
+  const size_t trace_size = base::size(kRequestTrace);
+  const size_t unique_keys = UniqueKeysInTrace();
+  ASSERT_LT(unique_keys, trace_size);
+
+  EXPECT_EQ(unique_keys, ReplayTrace(&cache, 1));
+  EXPECT_EQ(trace_size - unique_keys, cache.hit_count());
+  EXPECT_EQ(unique_keys, cache.miss_count());
+
+  // A second pass over the same page is served entirely from the cache.
+  EXPECT_EQ(0u, ReplayTrace(&cache, 1));
+  EXPECT_EQ(2 * trace_size - unique_keys, cache.hit_count());
+}
+
+TEST(AdBlockVerdictCacheTest, GenerationChangeInvalidates) {
+  AdBlockVerdictCache cache;
+  const size_t unique_keys = UniqueKeysInTrace();
+
+  EXPECT_EQ(unique_keys, ReplayTrace(&cache, 1));
+  EXPECT_EQ(unique_keys, ReplayTrace(&cache, 2));
+  EXPECT_EQ(0u, ReplayTrace(&cache, 2));
+
+  cache.Clear();
+  EXPECT_EQ(unique_keys, ReplayTrace(&cache, 2));
+}
+
+TEST(AdBlockVerdictCacheTest, KeyIncludesTupleAndIncomingFlags) {
+  const GURL url("https://ads.tracker.net/pixel.gif");
+  const std::string key = AdBlockVerdictCache::ComputeKey(
+      url, blink::mojom::ResourceType::kImage, "a.com", false, false, false);
+  EXPECT_NE(key, AdBlockVerdictCache::ComputeKey(
+                     url, blink::mojom::ResourceType::kScript, "a.com", false,
+                     false, false));
+  EXPECT_NE(key, AdBlockVerdictCache::ComputeKey(
+                     url, blink::mojom::ResourceType::kImage, "b.com", false,
+                     false, false));
+  EXPECT_NE(key, AdBlockVerdictCache::ComputeKey(
+                     url, blink::mojom::ResourceType::kImage, "a.com", true,
+                     false, false));
+}
+
+TEST(AdBlockVerdictCacheTest, Bounded) {
+  AdBlockVerdictCache cache(2, 2);
+  AdBlockVerdictCache::Verdict verdict;
+  verdict.mock_data_url = "data:text/plain,";
+  for (size_t i = 0; i < 100; ++i)
+    cache.Put(base::NumberToString(i), 1, verdict);
+
+  size_t retained = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    if (cache.Get(base::NumberToString(i), 1, &verdict))
+      ++retained;
+  }
+  EXPECT_EQ(4u, retained);
+  EXPECT_EQ("data:text/plain,", verdict.mock_data_url);
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,78 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/cosmetic_resources_prefetch_throttle.h"
+
+#include "base/feature_list.h"
+#include "brave/components/brave_shields/browser/ad_block_service.h"
+#include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "brave/components/brave_shields/common/features.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/navigation_handle.h"
+#include "url/gurl.h"
+
+namespace brave_shields {
+
+// static
+std::unique_ptr<CosmeticResourcesPrefetchThrottle>
+CosmeticResourcesPrefetchThrottle::MaybeCreateThrottleFor(
+    content::NavigationHandle* navigation_handle,
+    AdBlockService* ad_block_service,
+    HostContentSettingsMap* content_settings) {
+  if (!ad_block_service)
+    return nullptr;
+  if (!base::FeatureList::IsEnabled(
+          features::kBraveAdblockCosmeticResourcesCache))
+    return nullptr;
+  return std::make_unique<CosmeticResourcesPrefetchThrottle>(
+      navigation_handle, ad_block_service, content_settings);
+}
+
+CosmeticResourcesPrefetchThrottle::CosmeticResourcesPrefetchThrottle(
+    content::NavigationHandle* navigation_handle,
+    AdBlockService* ad_block_service,
+    HostContentSettingsMap* content_settings)
+    : content::NavigationThrottle(navigation_handle),
+      ad_block_service_(ad_block_service),
+      content_settings_(content_settings) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+}
+
+CosmeticResourcesPrefetchThrottle::~CosmeticResourcesPrefetchThrottle() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+}
+
+content::NavigationThrottle::ThrottleCheckResult
+CosmeticResourcesPrefetchThrottle::WillStartRequest() {
+  MaybeWarmCache();
+  return content::NavigationThrottle::PROCEED;
+}
+
+content::NavigationThrottle::ThrottleCheckResult
+CosmeticResourcesPrefetchThrottle::WillRedirectRequest() {
+  MaybeWarmCache();
+  return content::NavigationThrottle::PROCEED;
+}
+
+void CosmeticResourcesPrefetchThrottle::MaybeWarmCache() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  if (!ad_block_service_->IsInitialized())
+    return;
+
+  const GURL& url = navigation_handle()->GetURL();
+  // The renderer only asks for cosmetic resources of http(s) documents.
+  if (!url.SchemeIsHTTPOrHTTPS())
+    return;
+  if (!ShouldDoCosmeticFiltering(content_settings_, url))
+    return;
+
+  ad_block_service_->WarmCosmeticResourcesCache(url);
+}
+
+const char* CosmeticResourcesPrefetchThrottle::GetNameForLogging() {
+  return "CosmeticResourcesPrefetchThrottle";
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,59 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_COSMETIC_RESOURCES_PREFETCH_THROTTLE_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_COSMETIC_RESOURCES_PREFETCH_THROTTLE_H_
+
+#include <memory>
+
+#include "content/public/browser/navigation_throttle.h"
+
+class HostContentSettingsMap;
+
+namespace content {
+class NavigationHandle;
+}  // namespace content
+
+namespace brave_shields {
+
+class AdBlockService;
+
+// Starts computing the cosmetic resources for a navigation's URL when its
+// request starts, so they are cached by the time the renderer asks for them
+// after commit. Never defers or cancels the navigation.
+class CosmeticResourcesPrefetchThrottle : public content::NavigationThrottle {
+ public:
+  CosmeticResourcesPrefetchThrottle(
+      content::NavigationHandle* navigation_handle,
+      AdBlockService* ad_block_service,
+      HostContentSettingsMap* content_settings);
+  ~CosmeticResourcesPrefetchThrottle() override;
+
+  CosmeticResourcesPrefetchThrottle(const CosmeticResourcesPrefetchThrottle&) =
+      delete;
+  CosmeticResourcesPrefetchThrottle& operator=(
+      const CosmeticResourcesPrefetchThrottle&) = delete;
+
+  static std::unique_ptr<CosmeticResourcesPrefetchThrottle>
+  MaybeCreateThrottleFor(content::NavigationHandle* navigation_handle,
+                         AdBlockService* ad_block_service,
+                         HostContentSettingsMap* content_settings);
+
+  // content::NavigationThrottle implementation:
+  content::NavigationThrottle::ThrottleCheckResult WillStartRequest() override;
+  content::NavigationThrottle::ThrottleCheckResult WillRedirectRequest()
+      override;
+  const char* GetNameForLogging() override;
+
+ private:
+  void MaybeWarmCache();
+
+  AdBlockService* ad_block_service_ = nullptr;
+  HostContentSettingsMap* content_settings_ = nullptr;
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_COSMETIC_RESOURCES_PREFETCH_THROTTLE_H_
@@ -0,0 +1,151 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/https_everywhere_host_table.h"
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/important_file_writer.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "third_party/leveldatabase/src/include/leveldb/db.h"
+#include "third_party/leveldatabase/src/include/leveldb/iterator.h"
+
+namespace brave_shields {
+
+namespace {
+
+constexpr char kMagic[4] = {'H', 'S', 'E', 'T'};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t blob_size;
+};
+
+}  // namespace
+
+// Offsets are relative to the start of the blob that follows the index.
+struct HTTPSEHostTable::Entry {
+  uint32_t key_offset;
+  uint32_t key_size;
+  uint32_t value_offset;
+  uint32_t value_size;
+};
+
+HTTPSEHostTable::HTTPSEHostTable() = default;
+HTTPSEHostTable::~HTTPSEHostTable() = default;
+
+// static
+bool HTTPSEHostTable::WriteFromLevelDB(leveldb::DB* db,
+                                       const base::FilePath& path) {
+  std::vector<Entry> entries;
+  std::string blob;
+  std::unique_ptr<leveldb::Iterator> it(
+      db->NewIterator(leveldb::ReadOptions()));
+  // leveldb iterates in bytewise key order, which is the order Get() searches.
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    const leveldb::Slice key = it->key();
+    const leveldb::Slice value = it->value();
+    if (blob.size() + key.size() + value.size() >
+        std::numeric_limits<uint32_t>::max()) {
+      LOG(ERROR) << "HTTPS Everywhere rules too large for host table";
+      return false;
+    }
+    Entry entry;
+    entry.key_offset = blob.size();
+    entry.key_size = key.size();
+    blob.append(key.data(), key.size());
+    entry.value_offset = blob.size();
+    entry.value_size = value.size();
+    blob.append(value.data(), value.size());
+    entries.push_back(entry);
+  }
+  if (!it->status().ok())
+    return false;
+
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.entry_count = entries.size();
+  header.blob_size = blob.size();
+
+  std::string data;
+  data.reserve(sizeof(header) + entries.size() * sizeof(Entry) + blob.size());
+  data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  data.append(reinterpret_cast<const char*>(entries.data()),
+              entries.size() * sizeof(Entry));
+  data.append(blob);
+  return base::ImportantFileWriter::WriteFileAtomically(path, data);
+}
+
+// static
+std::unique_ptr<HTTPSEHostTable> HTTPSEHostTable::Open(
+    const base::FilePath& path) {
+  auto table = base::WrapUnique(new HTTPSEHostTable());
+  if (!table->file_.Initialize(path))
+    return nullptr;
+
+  const uint8_t* data = table->file_.data();
+  const size_t length = table->file_.length();
+  if (length < sizeof(Header))
+    return nullptr;
+  Header header;
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    return nullptr;
+  }
+  const size_t index_size = size_t{header.entry_count} * sizeof(Entry);
+  if (length != sizeof(Header) + index_size + header.blob_size)
+    return nullptr;
+
+  table->entries_ = reinterpret_cast<const Entry*>(data + sizeof(Header));
+  table->entry_count_ = header.entry_count;
+  table->blob_ = base::StringPiece(
+      reinterpret_cast<const char*>(data + sizeof(Header) + index_size),
+      header.blob_size);
+  return table;
+}
+
+bool HTTPSEHostTable::GetEntry(size_t index,
+                               base::StringPiece* key,
+                               base::StringPiece* value) const {
+  const Entry& entry = entries_[index];
+  if (size_t{entry.key_offset} + entry.key_size > blob_.size() ||
+      size_t{entry.value_offset} + entry.value_size > blob_.size()) {
+    return false;
+  }
+  *key = blob_.substr(entry.key_offset, entry.key_size);
+  *value = blob_.substr(entry.value_offset, entry.value_size);
+  return true;
+}
+
+std::string HTTPSEHostTable::Get(base::StringPiece key) const {
+  size_t low = 0;
+  size_t high = entry_count_;
+  while (low < high) {
+    const size_t mid = low + (high - low) / 2;
+    base::StringPiece mid_key;
+    base::StringPiece value;
+    if (!GetEntry(mid, &mid_key, &value))
+      return "";
+    const int compare = mid_key.compare(key);
+    if (compare == 0)
+      return value.as_string();
+    if (compare < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return "";
+}
+
+}  // namespace brave_shields
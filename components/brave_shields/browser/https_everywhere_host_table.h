@@ -0,0 +1,64 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_HOST_TABLE_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_HOST_TABLE_H_
+
+#include <memory>
+#include <string>
+
+#include "base/files/memory_mapped_file.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+class FilePath;
+}  // namespace base
+
+namespace leveldb {
+class DB;
+}  // namespace leveldb
+
+namespace brave_shields {
+
+// Read-only HTTPS Everywhere rules keyed by reversed host (e.g. "com.foo.*"),
+// stored as a single file of sorted fixed-size index entries followed by the
+// key and rule blobs. The file is memory mapped, so opening it does no parsing
+// and lookups are a binary search over the mapped index.
+class HTTPSEHostTable {
+ public:
+  ~HTTPSEHostTable();
+
+  // Writes every entry of |db| to |path| in host table format.
+  static bool WriteFromLevelDB(leveldb::DB* db, const base::FilePath& path);
+
+  // Returns nullptr if |path| is missing or isn't a host table.
+  static std::unique_ptr<HTTPSEHostTable> Open(const base::FilePath& path);
+
+  // Returns the rules stored under |key|, or an empty string.
+  std::string Get(base::StringPiece key) const;
+
+  size_t size() const { return entry_count_; }
+
+ private:
+  struct Entry;
+
+  HTTPSEHostTable();
+
+  bool GetEntry(size_t index,
+                base::StringPiece* key,
+                base::StringPiece* value) const;
+
+  base::MemoryMappedFile file_;
+  const Entry* entries_ = nullptr;
+  size_t entry_count_ = 0;
+  base::StringPiece blob_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTTPSEHostTable);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_HOST_TABLE_H_
@@ -0,0 +1,140 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/https_everywhere_host_table.h"
+
+#include <memory>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/path_service.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/common/brave_paths.h"
+#include "brave/components/brave_shields/browser/https_everywhere_rule_set.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/leveldatabase/src/include/leveldb/db.h"
+#include "third_party/leveldatabase/src/include/leveldb/iterator.h"
+#include "third_party/zlib/google/zip.h"
+
+namespace brave_shields {
+
+namespace {
+
+// Reversed host that has a default rule in the bundled database.
+constexpr char kFirstRedirectKey[] = "com.cloudmagic.www";
+constexpr char kFirstRedirectUrl[] = "http://www.cloudmagic.com/";
+
+base::FilePath GetZippedLevelDBPath() {
+  base::FilePath test_data_dir;
+  base::PathService::Get(brave::DIR_TEST_DATA, &test_data_dir);
+  return test_data_dir.AppendASCII("https-everywhere-data")
+      .AppendASCII("6.0")
+      .AppendASCII("httpse.leveldb.zip");
+}
+
+std::unique_ptr<leveldb::DB> UnzipAndOpenLevelDB(const base::FilePath& dir) {
+  if (!zip::Unzip(GetZippedLevelDBPath(), dir))
+    return nullptr;
+  leveldb::DB* db = nullptr;
+  leveldb::Options options;
+  if (!leveldb::DB::Open(options,
+                         dir.AppendASCII("httpse.leveldb").AsUTF8Unsafe(), &db)
+           .ok()) {
+    return nullptr;
+  }
+  return std::unique_ptr<leveldb::DB>(db);
+}
+
+std::string LevelDBGet(leveldb::DB* db, const std::string& key) {
+  std::string value;
+  if (!db->Get(leveldb::ReadOptions(), key, &value).ok())
+    return "";
+  return value;
+}
+
+}  // namespace
+
+class HTTPSEHostTableTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    db_ = UnzipAndOpenLevelDB(temp_dir_.GetPath());
+    ASSERT_TRUE(db_);
+    table_path_ = temp_dir_.GetPath().AppendASCII("httpse.hosts");
+    ASSERT_TRUE(HTTPSEHostTable::WriteFromLevelDB(db_.get(), table_path_));
+  }
+
+  base::ScopedTempDir temp_dir_;
+  std::unique_ptr<leveldb::DB> db_;
+  base::FilePath table_path_;
+};
+
+TEST_F(HTTPSEHostTableTest, MatchesLevelDB) {
+  auto table = HTTPSEHostTable::Open(table_path_);
+  ASSERT_TRUE(table);
+
+  size_t count = 0;
+  std::unique_ptr<leveldb::Iterator> it(
+      db_->NewIterator(leveldb::ReadOptions()));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    EXPECT_EQ(it->value().ToString(), table->Get(it->key().ToString()));
+    ++count;
+  }
+  EXPECT_EQ(count, table->size());
+  EXPECT_LT(0u, count);
+
+  EXPECT_EQ("", table->Get(""));
+  EXPECT_EQ("", table->Get("invalid.example.*"));
+}
+
+TEST_F(HTTPSEHostTableTest, RejectsOtherFiles) {
+  EXPECT_FALSE(HTTPSEHostTable::Open(temp_dir_.GetPath().AppendASCII("none")));
+  EXPECT_FALSE(HTTPSEHostTable::Open(GetZippedLevelDBPath()));
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(table_path_, &contents));
+  contents.resize(contents.size() - 1);
+  const base::FilePath truncated =
+      temp_dir_.GetPath().AppendASCII("truncated.hosts");
+  ASSERT_TRUE(base::WriteFile(truncated, contents));
+  EXPECT_FALSE(HTTPSEHostTable::Open(truncated));
+}
+
+// Time from component ready to the first rewritten URL, for the leveldb path
+// (unzip, open, Get) and for a host table written on a previous startup.
+TEST_F(HTTPSEHostTableTest, TimeToFirstRedirect) {
+  base::ScopedTempDir leveldb_dir;
+  ASSERT_TRUE(leveldb_dir.CreateUniqueTempDir());
+  base::ElapsedTimer leveldb_timer;
+  auto db = UnzipAndOpenLevelDB(leveldb_dir.GetPath());
+  ASSERT_TRUE(db);
+  const std::string leveldb_url =
+      HTTPSERuleSet::Parse(LevelDBGet(db.get(), kFirstRedirectKey))
+          ->Apply(kFirstRedirectUrl);
+  const base::TimeDelta leveldb_time = leveldb_timer.Elapsed();
+
+  base::ElapsedTimer table_timer;
+  auto table = HTTPSEHostTable::Open(table_path_);
+  ASSERT_TRUE(table);
+  const std::string table_url =
+      HTTPSERuleSet::Parse(table->Get(kFirstRedirectKey))
+          ->Apply(kFirstRedirectUrl);
+  const base::TimeDelta table_time = table_timer.Elapsed();
+
+  EXPECT_EQ("https://www.cloudmagic.com/", table_url);
+  EXPECT_EQ(leveldb_url, table_url);
+
+  perf_test::PerfResultReporter reporter("HTTPSEHostTable",
+                                         "time_to_first_redirect");
+  reporter.RegisterImportantMetric(".leveldb", "ms");
+  reporter.RegisterImportantMetric(".host_table", "ms");
+  reporter.AddResult(".leveldb", leveldb_time);
+  reporter.AddResult(".host_table", table_time);
+}
+
+}  // namespace brave_shields
@@ -6,40 +6,114 @@
 #ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RECENTLY_USED_CACHE_H_
 #define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RECENTLY_USED_CACHE_H_
 
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/containers/mru_cache.h"
 #include "base/synchronization/lock.h"
+#include "base/time/default_tick_clock.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
 
+// Recently looked up URLs and their HTTPS Everywhere result. Keys are spread
+// over |shard_count| independently locked MRU caches so lookups from different
+// threads rarely wait on each other. Besides rewritten URLs the cache also
+// remembers URLs that have no rewrite ("negative" entries) for |negative_ttl|.
 template <class T> class HTTPSERecentlyUsedCache {
  public:
-  explicit HTTPSERecentlyUsedCache(size_t size = 100) : data_(size) {}
+  // Recorded by callers as UMA, so entries must not be renumbered.
+  enum class Result {
+    kMiss = 0,
+    kHit = 1,
+    kNegativeHit = 2,
+    kMaxValue = kNegativeHit,
+  };
+
+  explicit HTTPSERecentlyUsedCache(
+      size_t shard_size = 100,
+      size_t shard_count = 1,
+      base::TimeDelta negative_ttl = base::TimeDelta::FromMinutes(10))
+      : negative_ttl_(negative_ttl),
+        clock_(base::DefaultTickClock::GetInstance()) {
+    for (size_t i = 0; i < shard_count; ++i)
+      shards_.push_back(std::make_unique<Shard>(shard_size));
+  }
 
   void add(const std::string& key, const T& value) {
-    base::AutoLock create(lock_);
-    data_.Put(key, value);
+    Shard* shard = GetShard(key);
+    base::AutoLock lock(shard->lock);
+    shard->data.Put(key, Entry{value, base::TimeTicks()});
   }
 
-  bool get(const std::string& key, T* value) {
-    base::AutoLock create(lock_);
-    auto it = data_.Get(key);
-    if (it != data_.end()) {
-      *value = it->second;
-      return true;
+  // Remembers that |key| has no value, until |negative_ttl| has passed.
+  void add_negative(const std::string& key) {
+    Shard* shard = GetShard(key);
+    base::AutoLock lock(shard->lock);
+    shard->data.Put(key, Entry{T(), clock_->NowTicks() + negative_ttl_});
+  }
+
+  Result lookup(const std::string& key, T* value) {
+    Shard* shard = GetShard(key);
+    base::AutoLock lock(shard->lock);
+    auto it = shard->data.Get(key);
+    if (it == shard->data.end())
+      return Result::kMiss;
+    if (!it->second.IsNegative()) {
+      *value = it->second.value;
+      return Result::kHit;
     }
-    return false;
+    if (clock_->NowTicks() < it->second.expiry)
+      return Result::kNegativeHit;
+    shard->data.Erase(it);
+    return Result::kMiss;
+  }
+
+  bool get(const std::string& key, T* value) {
+    return lookup(key, value) == Result::kHit;
   }
 
   void remove(const std::string& key) {
-    base::AutoLock lock(lock_);
-    auto it = data_.Peek(key);
-    if (it != data_.end())
-      data_.Erase(it);
+    Shard* shard = GetShard(key);
+    base::AutoLock lock(shard->lock);
+    auto it = shard->data.Peek(key);
+    if (it != shard->data.end())
+      shard->data.Erase(it);
+  }
+
+  void clear() {
+    for (auto& shard : shards_) {
+      base::AutoLock lock(shard->lock);
+      shard->data.Clear();
+    }
   }
 
+  void SetTickClockForTesting(const base::TickClock* clock) { clock_ = clock; }
+
  private:
-  base::MRUCache<std::string, T> data_;
-  base::Lock lock_;
+  struct Entry {
+    bool IsNegative() const { return !expiry.is_null(); }
+
+    T value;
+    // Null for positive entries.
+    base::TimeTicks expiry;
+  };
+
+  struct Shard {
+    explicit Shard(size_t size) : data(size) {}
+
+    base::MRUCache<std::string, Entry> data;
+    base::Lock lock;
+  };
+
+  Shard* GetShard(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % shards_.size()].get();
+  }
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  const base::TimeDelta negative_ttl_;
+  const base::TickClock* clock_;
 };
 
 #endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RECENTLY_USED_CACHE_H_
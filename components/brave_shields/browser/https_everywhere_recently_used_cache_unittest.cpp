@@ -5,6 +5,8 @@
 
 #include <string>
 
+#include "base/strings/string_number_conversions.h"
+#include "base/test/simple_test_tick_clock.h"
 #include "brave/components/brave_shields/browser/https_everywhere_recently_used_cache.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -28,3 +30,46 @@ TEST(HTTPSEverywhereRecentlyUsedCacheTest, Operations) {
   cache.remove("kD");
   ASSERT_FALSE(cache.get("kD", &v));
 }
+
+TEST(HTTPSEverywhereRecentlyUsedCacheTest, NegativeEntriesExpire) {
+  using Cache = HTTPSERecentlyUsedCache<std::string>;
+  base::SimpleTestTickClock clock;
+  Cache cache(10, 1, base::TimeDelta::FromMinutes(1));
+  cache.SetTickClockForTesting(&clock);
+
+  std::string v;
+  cache.add_negative("kA");
+  ASSERT_EQ(Cache::Result::kNegativeHit, cache.lookup("kA", &v));
+  ASSERT_FALSE(cache.get("kA", &v));
+  ASSERT_TRUE(v.empty());
+
+  clock.Advance(base::TimeDelta::FromMinutes(2));
+  ASSERT_EQ(Cache::Result::kMiss, cache.lookup("kA", &v));
+
+  // Positive entries don't expire and replace negative ones.
+  cache.add_negative("kB");
+  cache.add("kB", "vB");
+  clock.Advance(base::TimeDelta::FromHours(1));
+  ASSERT_EQ(Cache::Result::kHit, cache.lookup("kB", &v));
+  ASSERT_STREQ(v.c_str(), "vB");
+}
+
+TEST(HTTPSEverywhereRecentlyUsedCacheTest, Sharded) {
+  using Cache = HTTPSERecentlyUsedCache<std::string>;
+  Cache cache(4, 8);
+
+  // Each shard is bounded on its own, so the total never exceeds 4 * 8.
+  for (int i = 0; i < 1000; ++i)
+    cache.add("x" + base::NumberToString(i), "x");
+  std::string v;
+  int found = 0;
+  for (int i = 0; i < 1000; ++i) {
+    if (cache.get("x" + base::NumberToString(i), &v))
+      ++found;
+  }
+  ASSERT_LE(found, 32);
+  ASSERT_GT(found, 0);
+
+  cache.clear();
+  ASSERT_FALSE(cache.get("x999", &v));
+}
@@ -0,0 +1,121 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/https_everywhere_rule_set.h"
+
+#include <utility>
+
+#include "base/json/json_reader.h"
+#include "base/memory/ptr_util.h"
+#include "base/values.h"
+#include "third_party/re2/src/re2/re2.h"
+
+namespace brave_shields {
+
+HTTPSERuleSet::Rule::Rule() = default;
+HTTPSERuleSet::Rule::Rule(Rule&&) = default;
+HTTPSERuleSet::Rule::~Rule() = default;
+
+HTTPSERuleSet::Ruleset::Ruleset() = default;
+HTTPSERuleSet::Ruleset::Ruleset(Ruleset&&) = default;
+HTTPSERuleSet::Ruleset::~Ruleset() = default;
+
+HTTPSERuleSet::HTTPSERuleSet() = default;
+HTTPSERuleSet::~HTTPSERuleSet() = default;
+
+// static
+std::unique_ptr<HTTPSERuleSet> HTTPSERuleSet::Parse(const std::string& json) {
+  auto rule_set = base::WrapUnique(new HTTPSERuleSet());
+
+  base::Optional<base::Value> json_object = base::JSONReader::Read(json);
+  if (!json_object || !json_object->is_list())
+    return rule_set;
+
+  for (const auto& item : json_object->GetList()) {
+    if (!item.is_dict())
+      continue;
+
+    Ruleset ruleset;
+    const base::Value* exclusions = item.FindListKey("e");
+    if (exclusions) {
+      for (const auto& exclusion : exclusions->GetList()) {
+        if (!exclusion.is_dict())
+          continue;
+        const std::string* pattern = exclusion.FindStringKey("p");
+        if (!pattern)
+          continue;
+        auto regex =
+            std::make_unique<re2::RE2>(CorrecttoRuleToRE2Engine(*pattern));
+        if (regex->ok())
+          ruleset.exclusions.push_back(std::move(regex));
+      }
+    }
+
+    const base::Value* rules = item.FindListKey("r");
+    ruleset.has_rules = rules != nullptr;
+    if (rules) {
+      for (const auto& rule_value : rules->GetList()) {
+        if (!rule_value.is_dict())
+          continue;
+        Rule rule;
+        if (rule_value.FindKey("d")) {
+          rule.is_default = true;
+          ruleset.rules.push_back(std::move(rule));
+          continue;
+        }
+        const std::string* from = rule_value.FindStringKey("f");
+        const std::string* to = rule_value.FindStringKey("t");
+        if (!from || !to)
+          continue;
+        rule.from = std::make_unique<re2::RE2>(*from);
+        rule.to = CorrecttoRuleToRE2Engine(*to);
+        ruleset.rules.push_back(std::move(rule));
+      }
+    }
+
+    rule_set->rulesets_.push_back(std::move(ruleset));
+  }
+
+  return rule_set;
+}
+
+std::string HTTPSERuleSet::Apply(const std::string& original_url) const {
+  for (const auto& ruleset : rulesets_) {
+    for (const auto& exclusion : ruleset.exclusions) {
+      if (re2::RE2::FullMatch(original_url, *exclusion))
+        return "";
+    }
+
+    if (!ruleset.has_rules)
+      return "";
+
+    for (const auto& rule : ruleset.rules) {
+      if (rule.is_default) {
+        std::string new_url(original_url);
+        return new_url.insert(4, "s");
+      }
+
+      std::string new_url(original_url);
+      if (re2::RE2::Replace(&new_url, *rule.from, rule.to) &&
+          new_url != original_url) {
+        return new_url;
+      }
+    }
+  }
+  return "";
+}
+
+std::string CorrecttoRuleToRE2Engine(const std::string& to) {
+  std::string correctedto(to);
+  size_t pos = to.find("$");
+  while (std::string::npos != pos) {
+    correctedto[pos] = '\\';
+    pos = correctedto.find("$");
+  }
+
+  return correctedto;
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,72 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULE_SET_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULE_SET_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+
+namespace re2 {
+class RE2;
+}  // namespace re2
+
+namespace brave_shields {
+
+// The rulesets stored under a single HTTPS Everywhere leveldb key, parsed once
+// with every exclusion and "from" pattern precompiled, so that repeated
+// lookups for the same host don't re-parse JSON or recompile regexes.
+class HTTPSERuleSet {
+ public:
+  ~HTTPSERuleSet();
+
+  // Parses the JSON value of a leveldb entry. Malformed input yields a rule
+  // set that never rewrites anything.
+  static std::unique_ptr<HTTPSERuleSet> Parse(const std::string& json);
+
+  // Returns the rewritten URL, or an empty string if no rule applies.
+  std::string Apply(const std::string& original_url) const;
+
+  bool empty() const { return rulesets_.empty(); }
+
+ private:
+  struct Rule {
+    Rule();
+    Rule(Rule&&);
+    ~Rule();
+
+    // Default rules ("d") upgrade the scheme without a regex.
+    bool is_default = false;
+    std::unique_ptr<re2::RE2> from;
+    std::string to;
+  };
+
+  struct Ruleset {
+    Ruleset();
+    Ruleset(Ruleset&&);
+    ~Ruleset();
+
+    std::vector<std::unique_ptr<re2::RE2>> exclusions;
+    // False if the ruleset has no usable "r" list, which ends the lookup.
+    bool has_rules = false;
+    std::vector<Rule> rules;
+  };
+
+  HTTPSERuleSet();
+
+  std::vector<Ruleset> rulesets_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTTPSERuleSet);
+};
+
+// HTTPS Everywhere rules use $1 style backreferences, RE2 expects \1.
+std::string CorrecttoRuleToRE2Engine(const std::string& to);
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULE_SET_H_
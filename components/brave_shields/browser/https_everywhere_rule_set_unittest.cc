@@ -0,0 +1,175 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/https_everywhere_rule_set.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/path_service.h"
+#include "base/stl_util.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/common/brave_paths.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/leveldatabase/src/include/leveldb/db.h"
+#include "third_party/zlib/google/zip.h"
+
+namespace brave_shields {
+
+namespace {
+
+// Popular hosts standing in for a top sites list, which isn't checked in.
+// Lookups go through the same www-stripped and wildcard keys as
+// HTTPSEverywhereService::GetHTTPSURL.
+const char* const kTopHosts[] = {
+    "google.com", "youtube.com", "facebook.com", "baidu.com", "wikipedia.org",
+    "reddit.com", "yahoo.com", "amazon.com", "twitter.com", "instagram.com",
+    "linkedin.com", "netflix.com", "microsoft.com", "bing.com", "ebay.com",
+    "msn.com", "apple.com", "twitch.tv", "stackoverflow.com", "github.com",
+    "imdb.com", "nytimes.com", "cnn.com", "bbc.co.uk", "theguardian.com",
+    "paypal.com", "wordpress.com", "tumblr.com", "pinterest.com", "dropbox.com",
+    "adobe.com", "spotify.com", "medium.com", "mozilla.org", "eff.org",
+    "washingtonpost.com", "craigslist.org", "booking.com", "yelp.com",
+    "soundcloud.com", "vimeo.com", "flickr.com", "archive.org",
+    "duckduckgo.com", "stackexchange.com", "quora.com", "walmart.com",
+    "etsy.com", "forbes.com", "wsj.com",
+};
+
+constexpr size_t kReplayRounds = 20;
+
+std::vector<std::string> KeysForHost(const std::string& host) {
+  std::vector<std::string> keys;
+  keys.push_back(host);
+  const size_t dot = host.find('.');
+  if (dot != std::string::npos)
+    keys.push_back("*" + host.substr(dot));
+  return keys;
+}
+
+std::string LevelDBGet(leveldb::DB* db, const std::string& key) {
+  std::string value;
+  if (!db->Get(leveldb::ReadOptions(), key, &value).ok())
+    return "";
+  return value;
+}
+
+class HTTPSERuleSetTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    base::FilePath test_data_dir;
+    ASSERT_TRUE(base::PathService::Get(brave::DIR_TEST_DATA, &test_data_dir));
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    ASSERT_TRUE(zip::Unzip(test_data_dir.AppendASCII("https-everywhere-data")
+                               .AppendASCII("6.0")
+                               .AppendASCII("httpse.leveldb.zip"),
+                           temp_dir_.GetPath()));
+
+    leveldb::DB* db = nullptr;
+    leveldb::Options options;
+    ASSERT_TRUE(
+        leveldb::DB::Open(options,
+                          temp_dir_.GetPath()
+                              .AppendASCII("httpse.leveldb")
+                              .AsUTF8Unsafe(),
+                          &db)
+            .ok());
+    db_.reset(db);
+  }
+
+  // Looks up |host| the way the service did before rules were cached, parsing
+  // and compiling the stored rules on every call.
+  std::string ApplyUncached(const std::string& host) {
+    const std::string url = "http://" + host + "/";
+    for (const auto& key : KeysForHost(host)) {
+      const std::string value = LevelDBGet(db_.get(), key);
+      if (value.empty())
+        continue;
+      const std::string new_url = HTTPSERuleSet::Parse(value)->Apply(url);
+      if (!new_url.empty())
+        return new_url;
+    }
+    return "";
+  }
+
+  std::string ApplyCached(const std::string& host) {
+    const std::string url = "http://" + host + "/";
+    for (const auto& key : KeysForHost(host)) {
+      auto it = cache_.find(key);
+      if (it == cache_.end()) {
+        it = cache_
+                 .emplace(key, HTTPSERuleSet::Parse(LevelDBGet(db_.get(), key)))
+                 .first;
+      }
+      if (it->second->empty())
+        continue;
+      const std::string new_url = it->second->Apply(url);
+      if (!new_url.empty())
+        return new_url;
+    }
+    return "";
+  }
+
+  base::ScopedTempDir temp_dir_;
+  std::unique_ptr<leveldb::DB> db_;
+  std::map<std::string, std::unique_ptr<HTTPSERuleSet>> cache_;
+};
+
+}  // namespace
+
+TEST(HTTPSERuleSetParseTest, Apply) {
+  auto rule_set = HTTPSERuleSet::Parse(
+      R"([{"e":[{"p":"^http://example\\.com/skip"}],)"
+      R"("r":[{"f":"^http://(www\\.)?example\\.com/",)"
+      R"("t":"https://$1example.com/"}]}])");
+  ASSERT_FALSE(rule_set->empty());
+  EXPECT_EQ("https://www.example.com/a",
+            rule_set->Apply("http://www.example.com/a"));
+  EXPECT_EQ("", rule_set->Apply("http://example.com/skip"));
+  EXPECT_EQ("", rule_set->Apply("http://other.com/"));
+
+  auto default_rule = HTTPSERuleSet::Parse(R"([{"r":[{"d":1}]}])");
+  EXPECT_EQ("https://example.com/", default_rule->Apply("http://example.com/"));
+}
+
+TEST(HTTPSERuleSetParseTest, MalformedJSON) {
+  EXPECT_TRUE(HTTPSERuleSet::Parse("")->empty());
+  EXPECT_TRUE(HTTPSERuleSet::Parse("{")->empty());
+  EXPECT_TRUE(HTTPSERuleSet::Parse(R"({"r":[]})")->empty());
+  EXPECT_EQ("", HTTPSERuleSet::Parse("{")->Apply("http://example.com/"));
+}
+
+TEST_F(HTTPSERuleSetTest, ReplayTopHosts) {
+  for (const char* host : kTopHosts)
+    EXPECT_EQ(ApplyUncached(host), ApplyCached(host)) << host;
+
+  base::ElapsedTimer uncached_timer;
+  for (size_t round = 0; round < kReplayRounds; ++round) {
+    for (const char* host : kTopHosts)
+      ApplyUncached(host);
+  }
+  const double uncached_us = uncached_timer.Elapsed().InMicrosecondsF() /
+                             (kReplayRounds * base::size(kTopHosts));
+
+  base::ElapsedTimer cached_timer;
+  for (size_t round = 0; round < kReplayRounds; ++round) {
+    for (const char* host : kTopHosts)
+      ApplyCached(host);
+  }
+  const double cached_us = cached_timer.Elapsed().InMicrosecondsF() /
+                           (kReplayRounds * base::size(kTopHosts));
+
+  perf_test::PerfResultReporter reporter("HTTPSERuleSet", "top_hosts");
+  reporter.RegisterImportantMetric(".uncached_lookup", "us");
+  reporter.RegisterImportantMetric(".cached_lookup", "us");
+  reporter.AddResult(".uncached_lookup", uncached_us);
+  reporter.AddResult(".cached_lookup", cached_us);
+}
+
+}  // namespace brave_shields
@@ -12,24 +12,35 @@
 
 #include "base/base_paths.h"
 #include "base/bind.h"
-#include "base/json/json_reader.h"
+#include "base/feature_list.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/metrics/histogram_macros.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/threading/scoped_blocking_call.h"
-#include "base/values.h"
+#include "brave/components/brave_shields/browser/https_everywhere_host_table.h"
+#include "brave/components/brave_shields/browser/https_everywhere_rule_set.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "third_party/leveldatabase/src/include/leveldb/db.h"
-#include "third_party/re2/src/re2/re2.h"
 #include "third_party/zlib/google/zip.h"
 
 #define DAT_FILE "httpse.leveldb.zip"
 #define DAT_FILE_VERSION "6.0"
-#define HTTPSE_URLS_REDIRECTS_COUNT_QUEUE   1
+#define HOST_TABLE_FILE "httpse.hosts"
 #define HTTPSE_URL_MAX_REDIRECTS_COUNT      5
 
 namespace {
 
+constexpr size_t kCompiledRulesCacheSize = 1000;
+// Entries are normally erased in OnURLRequestDestroyed, this only bounds what
+// is left behind by requests that never report their destruction.
+constexpr size_t kMaxTrackedRedirectRequests = 1000;
+constexpr size_t kRecentlyUsedCacheShardSize = 128;
+constexpr size_t kRecentlyUsedCacheShardCount = 16;
+constexpr base::TimeDelta kRecentlyUsedCacheNegativeTTL =
+    base::TimeDelta::FromMinutes(10);
+
 std::vector<std::string> Split(const std::string& s, char delim) {
   std::stringstream ss(s);
   std::string item;
@@ -100,12 +111,19 @@ HTTPSEverywhereService::g_https_everywhere_component_base64_public_key_(
 HTTPSEverywhereService::HTTPSEverywhereService(
     BraveComponent::Delegate* delegate)
     : BaseBraveShieldsService(delegate),
+      httpse_redirects_count_(kMaxTrackedRedirectRequests),
+      recently_used_cache_(kRecentlyUsedCacheShardSize,
+                           kRecentlyUsedCacheShardCount,
+                           kRecentlyUsedCacheNegativeTTL),
+      compiled_rules_cache_(kCompiledRulesCacheSize),
       level_db_(nullptr) {
   DETACH_FROM_SEQUENCE(sequence_checker_);
 }
 
 HTTPSEverywhereService::~HTTPSEverywhereService() {
   GetTaskRunner()->DeleteSoon(FROM_HERE, level_db_);
+  if (host_table_)
+    GetTaskRunner()->DeleteSoon(FROM_HERE, std::move(host_table_));
 }
 
 bool HTTPSEverywhereService::Init() {
@@ -117,6 +135,16 @@ bool HTTPSEverywhereService::Init() {
 
 void HTTPSEverywhereService::InitDB(const base::FilePath& install_dir) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  init_start_time_ = base::TimeTicks::Now();
+  first_redirect_recorded_ = false;
+
+  const bool use_host_table = base::FeatureList::IsEnabled(
+      features::kBraveHTTPSEverywhereHostTable);
+  const base::FilePath host_table_path =
+      install_dir.AppendASCII(DAT_FILE_VERSION).AppendASCII(HOST_TABLE_FILE);
+  if (use_host_table && OpenHostTable(host_table_path))
+    return;
+
   base::FilePath zip_db_file_path =
       install_dir.AppendASCII(DAT_FILE_VERSION).AppendASCII(DAT_FILE);
   base::FilePath unzipped_level_db_path = zip_db_file_path.RemoveExtension();
@@ -128,6 +156,8 @@ void HTTPSEverywhereService::InitDB(const base::FilePath& install_dir) {
   }
 
   CloseDatabase();
+  compiled_rules_cache_.Clear();
+  recently_used_cache_.clear();
 
   leveldb::Options options;
   leveldb::Status status =
@@ -141,6 +171,28 @@ void HTTPSEverywhereService::InitDB(const base::FilePath& install_dir) {
     CloseDatabase();
     return;
   }
+
+  // Convert the rules once so later startups can map them directly instead
+  // of unzipping and opening leveldb again.
+  if (use_host_table) {
+    if (HTTPSEHostTable::WriteFromLevelDB(level_db_, host_table_path))
+      OpenHostTable(host_table_path);
+    else
+      LOG(ERROR) << "Failed to write " << host_table_path.value().c_str();
+  }
+}
+
+bool HTTPSEverywhereService::OpenHostTable(const base::FilePath& path) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  std::unique_ptr<HTTPSEHostTable> host_table = HTTPSEHostTable::Open(path);
+  if (!host_table)
+    return false;
+
+  CloseDatabase();
+  compiled_rules_cache_.Clear();
+  recently_used_cache_.clear();
+  host_table_ = std::move(host_table);
+  return true;
 }
 
 void HTTPSEverywhereService::OnComponentReady(
@@ -161,16 +213,22 @@ bool HTTPSEverywhereService::GetHTTPSURL(
   if (!url->is_valid())
     return false;
 
-  if (!IsInitialized() || !level_db_ || url->scheme() == url::kHttpsScheme) {
+  if (!IsInitialized() || (!level_db_ && !host_table_) ||
+      url->scheme() == url::kHttpsScheme) {
     return false;
   }
   if (!ShouldHTTPSERedirect(request_identifier)) {
     return false;
   }
 
-  if (recently_used_cache_.get(url->spec(), new_url)) {
-    AddHTTPSEUrlToRedirectList(request_identifier);
-    return true;
+  switch (recently_used_cache_.lookup(url->spec(), new_url)) {
+    case RecentlyUsedCache::Result::kHit:
+      AddHTTPSEUrlToRedirectList(request_identifier);
+      return true;
+    case RecentlyUsedCache::Result::kNegativeHit:
+      return false;
+    case RecentlyUsedCache::Result::kMiss:
+      break;
   }
 
   GURL candidate_url(*url);
@@ -183,17 +241,22 @@ bool HTTPSEverywhereService::GetHTTPSURL(
   const std::vector<std::string> domains =
       ExpandDomainForLookup(candidate_url.host());
   for (auto domain : domains) {
-    std::string value = leveldbGet(level_db_, domain);
-    if (!value.empty()) {
-      *new_url = ApplyHTTPSRule(candidate_url.spec(), value);
+    const HTTPSERuleSet* rules = GetCompiledRules(domain);
+    if (rules) {
+      *new_url = rules->Apply(candidate_url.spec());
       if (0 != new_url->length()) {
         recently_used_cache_.add(candidate_url.spec(), *new_url);
         AddHTTPSEUrlToRedirectList(request_identifier);
+        if (!first_redirect_recorded_) {
+          first_redirect_recorded_ = true;
+          UMA_HISTOGRAM_TIMES("Brave.HTTPSE.TimeToFirstRedirect",
+                              base::TimeTicks::Now() - init_start_time_);
+        }
         return true;
       }
     }
   }
-  recently_used_cache_.remove(candidate_url.spec());
+  recently_used_cache_.add_negative(candidate_url.spec());
   return false;
 }
 
@@ -211,165 +274,59 @@ bool HTTPSEverywhereService::GetHTTPSURLFromCacheOnly(
     return false;
   }
 
-  if (recently_used_cache_.get(url->spec(), cached_url)) {
-    AddHTTPSEUrlToRedirectList(request_identifier);
-    return true;
+  const RecentlyUsedCache::Result result =
+      recently_used_cache_.lookup(url->spec(), cached_url);
+  UMA_HISTOGRAM_ENUMERATION("Brave.HTTPSE.RecentlyUsedCacheLookup", result);
+  switch (result) {
+    case RecentlyUsedCache::Result::kHit:
+      AddHTTPSEUrlToRedirectList(request_identifier);
+      return true;
+    case RecentlyUsedCache::Result::kNegativeHit:
+      // Known not to be upgradable, |cached_url| stays empty.
+      return true;
+    case RecentlyUsedCache::Result::kMiss:
+      return false;
   }
+  NOTREACHED();
   return false;
 }
 
 bool HTTPSEverywhereService::ShouldHTTPSERedirect(
     const uint64_t& request_identifier) {
-  base::AutoLock auto_lock(httpse_get_urls_redirects_count_mutex_);
-  for (size_t i = 0; i < httpse_urls_redirects_count_.size(); i++) {
-    if (request_identifier ==
-        httpse_urls_redirects_count_[i].request_identifier_ &&
-        httpse_urls_redirects_count_[i].redirects_ >=
-        HTTPSE_URL_MAX_REDIRECTS_COUNT - 1) {
-      return false;
-    }
-  }
-
-  return true;
+  base::AutoLock auto_lock(httpse_redirects_count_mutex_);
+  auto it = httpse_redirects_count_.Peek(request_identifier);
+  return it == httpse_redirects_count_.end() ||
+         it->second < HTTPSE_URL_MAX_REDIRECTS_COUNT - 1;
 }
 
 void HTTPSEverywhereService::AddHTTPSEUrlToRedirectList(
     const uint64_t& request_identifier) {
-  // Adding redirects count for the current request
-  base::AutoLock auto_lock(httpse_get_urls_redirects_count_mutex_);
-  bool hostFound = false;
-  for (size_t i = 0; i < httpse_urls_redirects_count_.size(); i++) {
-    if (request_identifier ==
-        httpse_urls_redirects_count_[i].request_identifier_) {
-      // Found the host, just increment the redirects_count
-      httpse_urls_redirects_count_[i].redirects_++;
-      hostFound = true;
-      break;
-    }
-  }
-  if (!hostFound) {
-      // The host is new, adding it to the redirects list
-      if (httpse_urls_redirects_count_.size() >=
-          HTTPSE_URLS_REDIRECTS_COUNT_QUEUE) {
-          // The queue is full, erase the first element
-          httpse_urls_redirects_count_.erase(
-              httpse_urls_redirects_count_.begin());
-      }
-      httpse_urls_redirects_count_.push_back(
-          HTTPSE_REDIRECTS_COUNT_ST(request_identifier, 1));
-  }
+  base::AutoLock auto_lock(httpse_redirects_count_mutex_);
+  auto it = httpse_redirects_count_.Get(request_identifier);
+  if (it != httpse_redirects_count_.end())
+    it->second++;
+  else
+    httpse_redirects_count_.Put(request_identifier, 1);
 }
 
-std::string HTTPSEverywhereService::ApplyHTTPSRule(
-    const std::string& originalUrl,
-    const std::string& rule) {
-  base::Optional<base::Value> json_object = base::JSONReader::Read(rule);
-  if (base::nullopt == json_object || !json_object->is_list()) {
-    return "";
-  }
-
-  base::Value::ConstListView topValues = json_object->GetList();
-  for (auto it = topValues.cbegin(); it != topValues.cend(); ++it) {
-    if (!it->is_dict()) {
-      continue;
-    }
-    const base::DictionaryValue* childTopDictionary = nullptr;
-    it->GetAsDictionary(&childTopDictionary);
-    if (nullptr == childTopDictionary) {
-      continue;
-    }
-
-    const base::Value* exclusion = nullptr;
-    if (childTopDictionary->Get("e", &exclusion)) {
-      const base::ListValue* eValues = nullptr;
-      exclusion->GetAsList(&eValues);
-      if (nullptr != eValues) {
-        for (size_t j = 0; j < eValues->GetSize(); ++j) {
-          const base::Value* pValue = nullptr;
-          if (!eValues->Get(j, &pValue)) {
-            continue;
-          }
-          const base::DictionaryValue* pDictionary = nullptr;
-          pValue->GetAsDictionary(&pDictionary);
-          if (nullptr == pDictionary) {
-            continue;
-          }
-          const base::Value* patternValue = nullptr;
-          if (!pDictionary->Get("p", &patternValue)) {
-            continue;
-          }
-          std::string pattern;
-          if (!patternValue->GetAsString(&pattern)) {
-            continue;
-          }
-          pattern = CorrecttoRuleToRE2Engine(pattern);
-          if (RE2::FullMatch(originalUrl, pattern)) {
-            return "";
-          }
-        }
-      }
-    }
-
-    const base::Value* rules = nullptr;
-    if (!childTopDictionary->Get("r", &rules)) {
-      return "";
-    }
-    const base::ListValue* rValues = nullptr;
-    rules->GetAsList(&rValues);
-    if (nullptr == rValues) {
-      return "";
-    }
-
-    for (size_t j = 0; j < rValues->GetSize(); ++j) {
-      const base::Value* pValue = nullptr;
-      if (!rValues->Get(j, &pValue)) {
-        continue;
-      }
-      const base::DictionaryValue* pDictionary = nullptr;
-      pValue->GetAsDictionary(&pDictionary);
-      if (nullptr == pDictionary) {
-        continue;
-      }
-      const base::Value* patternValue = nullptr;
-      if (pDictionary->Get("d", &patternValue)) {
-        std::string newUrl(originalUrl);
-        return newUrl.insert(4, "s");
-      }
-
-      const base::Value* from_value = nullptr;
-      const base::Value* to_value = nullptr;
-      if (!pDictionary->Get("f", &from_value) ||
-          !pDictionary->Get("t", &to_value)) {
-        continue;
-      }
-      std::string from, to;
-      if (!from_value->GetAsString(&from) ||
-          !to_value->GetAsString(&to)) {
-        continue;
-      }
-
-      to = CorrecttoRuleToRE2Engine(to);
-      std::string newUrl(originalUrl);
-      RE2 regExp(from);
-
-      if (RE2::Replace(&newUrl, regExp, to) && newUrl != originalUrl) {
-        return newUrl;
-      }
-    }
-  }
-  return "";
+void HTTPSEverywhereService::OnURLRequestDestroyed(
+    const uint64_t& request_identifier) {
+  base::AutoLock auto_lock(httpse_redirects_count_mutex_);
+  auto it = httpse_redirects_count_.Peek(request_identifier);
+  if (it != httpse_redirects_count_.end())
+    httpse_redirects_count_.Erase(it);
 }
 
-std::string HTTPSEverywhereService::CorrecttoRuleToRE2Engine(
-    const std::string& to) {
-  std::string correctedto(to);
-  size_t pos = to.find("$");
-  while (std::string::npos != pos) {
-    correctedto[pos] = '\\';
-    pos = correctedto.find("$");
+const HTTPSERuleSet* HTTPSEverywhereService::GetCompiledRules(
+    const std::string& key) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  auto it = compiled_rules_cache_.Get(key);
+  if (it == compiled_rules_cache_.end()) {
+    it = compiled_rules_cache_.Put(
+        key, HTTPSERuleSet::Parse(host_table_ ? host_table_->Get(key)
+                                              : leveldbGet(level_db_, key)));
   }
-
-  return correctedto;
+  return it->second->empty() ? nullptr : it->second.get();
 }
 
 void HTTPSEverywhereService::CloseDatabase() {
@@ -378,6 +335,7 @@ void HTTPSEverywhereService::CloseDatabase() {
     delete level_db_;
     level_db_ = nullptr;
   }
+  host_table_.reset();
 }
 
 // static
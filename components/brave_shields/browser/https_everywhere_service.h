@@ -10,10 +10,12 @@
 #include <string>
 #include <vector>
 
+#include "base/containers/mru_cache.h"
 #include "base/files/file_path.h"
 #include "base/memory/weak_ptr.h"
 #include "base/sequence_checker.h"
 #include "base/synchronization/lock.h"
+#include "base/time/time.h"
 #include "brave/components/brave_shields/browser/base_brave_shields_service.h"
 #include "brave/components/brave_shields/browser/https_everywhere_recently_used_cache.h"
 
@@ -27,22 +29,13 @@ using brave_component_updater::BraveComponent;
 
 namespace brave_shields {
 
+class HTTPSEHostTable;
+class HTTPSERuleSet;
+
 extern const char kHTTPSEverywhereComponentName[];
 extern const char kHTTPSEverywhereComponentId[];
 extern const char kHTTPSEverywhereComponentBase64PublicKey[];
 
-struct HTTPSE_REDIRECTS_COUNT_ST {
- public:
-  HTTPSE_REDIRECTS_COUNT_ST(uint64_t request_identifier,
-                            unsigned int redirects):
-    request_identifier_(request_identifier),
-    redirects_(redirects) {
-  }
-
-  uint64_t request_identifier_;
-  unsigned int redirects_;
-};
-
 class HTTPSEverywhereService : public BaseBraveShieldsService,
                          public base::SupportsWeakPtr<HTTPSEverywhereService> {
  public:
@@ -51,9 +44,13 @@ class HTTPSEverywhereService : public BaseBraveShieldsService,
   bool GetHTTPSURL(const GURL* url,
                    const uint64_t& request_id,
                    std::string* new_url);
+  // Returns true if |url| is in the recently used cache. |cached_url| is left
+  // empty if the URL is cached as not upgradable.
   bool GetHTTPSURLFromCacheOnly(const GURL* url,
                                 const uint64_t& request_id,
                                 std::string* cached_url);
+  // Drops the redirect count kept for |request_id|.
+  void OnURLRequestDestroyed(const uint64_t& request_id);
 
  protected:
   bool Init() override;
@@ -63,9 +60,9 @@ class HTTPSEverywhereService : public BaseBraveShieldsService,
 
   void AddHTTPSEUrlToRedirectList(const uint64_t& request_id);
   bool ShouldHTTPSERedirect(const uint64_t& request_id);
-  std::string ApplyHTTPSRule(const std::string& originalUrl,
-      const std::string& rule);
-  std::string CorrecttoRuleToRE2Engine(const std::string& to);
+  // Returns the compiled rules stored under |key|, or nullptr if there are
+  // none. Results are kept in |compiled_rules_cache_|.
+  const HTTPSERuleSet* GetCompiledRules(const std::string& key);
 
  private:
   friend class ::HTTPSEverywhereServiceTest;
@@ -80,11 +77,24 @@ class HTTPSEverywhereService : public BaseBraveShieldsService,
   void CloseDatabase();
 
   void InitDB(const base::FilePath& install_dir);
-
-  base::Lock httpse_get_urls_redirects_count_mutex_;
-  std::vector<HTTPSE_REDIRECTS_COUNT_ST> httpse_urls_redirects_count_;
-  HTTPSERecentlyUsedCache<std::string> recently_used_cache_;
+  // Switches lookups over to the host table at |path|. Returns false, leaving
+  // the current database in place, if it can't be opened.
+  bool OpenHostTable(const base::FilePath& path);
+
+  base::Lock httpse_redirects_count_mutex_;
+  // Number of HTTPSE redirects so far, by request identifier.
+  base::HashingMRUCache<uint64_t, unsigned int> httpse_redirects_count_;
+  using RecentlyUsedCache = HTTPSERecentlyUsedCache<std::string>;
+  RecentlyUsedCache recently_used_cache_;
+  // Compiled rules by leveldb key. Keys without an entry are cached as empty
+  // rule sets so they don't go back to leveldb either.
+  base::MRUCache<std::string, std::unique_ptr<HTTPSERuleSet>>
+      compiled_rules_cache_;
   leveldb::DB* level_db_;
+  // Used instead of |level_db_| when kBraveHTTPSEverywhereHostTable is on.
+  std::unique_ptr<HTTPSEHostTable> host_table_;
+  base::TimeTicks init_start_time_;
+  bool first_redirect_recorded_ = false;
 
   SEQUENCE_CHECKER(sequence_checker_);
   DISALLOW_COPY_AND_ASSIGN(HTTPSEverywhereService);
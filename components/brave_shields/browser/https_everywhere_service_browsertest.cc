@@ -3,8 +3,13 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this file,
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <string>
+#include <vector>
+
 #include "base/path_service.h"
+#include "base/run_loop.h"
 #include "base/task/post_task.h"
+#include "base/test/bind.h"
 #include "base/test/thread_test_helper.h"
 #include "brave/browser/brave_browser_process.h"
 #include "brave/common/brave_paths.h"
@@ -141,3 +146,37 @@ IN_PROC_BROWSER_TEST_F(HTTPSEverywhereServiceTest, RedirectsKnownSiteInIframe) {
   EXPECT_EQ(GURL("https://www.digg.com/"),
             iframe_contents->GetLastCommittedURL());
 }
+
+// Redirect loop protection is tracked per request, so requests in flight at
+// the same time must not reset each other's redirect count.
+IN_PROC_BROWSER_TEST_F(HTTPSEverywhereServiceTest,
+                       RedirectLimitWithManyRequestsInFlight) {
+  ASSERT_TRUE(InstallHTTPSEverywhereExtension());
+
+  constexpr uint64_t kRequestCount = 20;
+  constexpr int kAttempts = 10;
+  auto* service = g_brave_browser_process->https_everywhere_service();
+  const GURL url("http://www.digg.com/");
+  std::vector<int> redirects(kRequestCount + 1);
+  bool redirected_after_destroy = false;
+
+  base::RunLoop run_loop;
+  service->GetTaskRunner()->PostTaskAndReply(
+      FROM_HERE, base::BindLambdaForTesting([&]() {
+        std::string new_url;
+        for (int attempt = 0; attempt < kAttempts; ++attempt) {
+          for (uint64_t id = 1; id <= kRequestCount; ++id) {
+            if (service->GetHTTPSURL(&url, id, &new_url))
+              redirects[id]++;
+          }
+        }
+        service->OnURLRequestDestroyed(1);
+        redirected_after_destroy = service->GetHTTPSURL(&url, 1, &new_url);
+      }),
+      run_loop.QuitClosure());
+  run_loop.Run();
+
+  for (uint64_t id = 1; id <= kRequestCount; ++id)
+    EXPECT_EQ(4, redirects[id]) << id;
+  EXPECT_TRUE(redirected_after_destroy);
+}
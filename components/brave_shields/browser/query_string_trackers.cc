@@ -0,0 +1,142 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/query_string_trackers.h"
+
+#include <utility>
+
+#include "base/json/json_reader.h"
+#include "base/no_destructor.h"
+#include "base/strings/string_util.h"
+#include "base/synchronization/lock.h"
+#include "base/values.h"
+
+namespace brave_shields {
+
+namespace {
+
+base::Lock& GetCurrentLock() {
+  static base::NoDestructor<base::Lock> lock;
+  return *lock;
+}
+
+scoped_refptr<const QueryStringTrackers>& GetCurrentTrackers() {
+  static base::NoDestructor<scoped_refptr<const QueryStringTrackers>>
+      trackers(QueryStringTrackers::CreateDefault());
+  return *trackers;
+}
+
+}  // namespace
+
+bool QueryStringTrackers::CaseInsensitiveLess::operator()(
+    base::StringPiece a,
+    base::StringPiece b) const {
+  return base::CompareCaseInsensitiveASCII(a, b) < 0;
+}
+
+QueryStringTrackers::QueryStringTrackers(std::vector<std::string> names)
+    : names_(std::move(names)) {}
+
+QueryStringTrackers::~QueryStringTrackers() = default;
+
+// static
+scoped_refptr<const QueryStringTrackers> QueryStringTrackers::CreateDefault() {
+  return base::WrapRefCounted(new QueryStringTrackers(
+      {// https://github.com/brave/brave-browser/issues/4239
+       "fbclid", "gclid", "msclkid", "mc_eid",
+       // https://github.com/brave/brave-browser/issues/9879
+       "dclid",
+       // https://github.com/brave/brave-browser/issues/13644
+       "oly_anon_id", "oly_enc_id",
+       // https://github.com/brave/brave-browser/issues/11579
+       "_openstat",
+       // https://github.com/brave/brave-browser/issues/11817
+       "vero_conv", "vero_id",
+       // https://github.com/brave/brave-browser/issues/13647
+       "wickedid",
+       // https://github.com/brave/brave-browser/issues/11578
+       "yclid",
+       // https://github.com/brave/brave-browser/issues/8975
+       "__s",
+       // https://github.com/brave/brave-browser/issues/9019
+       "_hsenc", "__hssc", "__hstc", "__hsfp", "hsCtaTracking"}));
+}
+
+// static
+scoped_refptr<const QueryStringTrackers> QueryStringTrackers::CreateFromJSON(
+    base::StringPiece json) {
+  base::Optional<base::Value> root = base::JSONReader::Read(json);
+  if (!root || !root->is_list())
+    return nullptr;
+
+  std::vector<std::string> names;
+  for (const auto& name : root->GetList()) {
+    if (!name.is_string() || name.GetString().empty())
+      return nullptr;
+    names.push_back(name.GetString());
+  }
+  return base::WrapRefCounted(new QueryStringTrackers(std::move(names)));
+}
+
+// static
+scoped_refptr<const QueryStringTrackers> QueryStringTrackers::GetCurrent() {
+  base::AutoLock lock(GetCurrentLock());
+  return GetCurrentTrackers();
+}
+
+// static
+void QueryStringTrackers::SetCurrent(
+    scoped_refptr<const QueryStringTrackers> trackers) {
+  DCHECK(trackers);
+  base::AutoLock lock(GetCurrentLock());
+  GetCurrentTrackers() = std::move(trackers);
+}
+
+bool QueryStringTrackers::Contains(base::StringPiece name) const {
+  return names_.find(name) != names_.end();
+}
+
+base::Optional<std::string> QueryStringTrackers::StripTrackers(
+    base::StringPiece query) const {
+  std::string stripped;
+  bool removed = false;
+  // Whether |stripped| holds at least one parameter, possibly an empty one.
+  bool any_kept = false;
+  size_t start = 0;
+  while (true) {
+    size_t end = query.find('&', start);
+    if (end == base::StringPiece::npos)
+      end = query.size();
+    const base::StringPiece param = query.substr(start, end - start);
+
+    // Only parameters with a value are trackers, e.g. "fbclid=1234".
+    const size_t equals = param.find('=');
+    if (equals != base::StringPiece::npos && equals + 1 < param.size() &&
+        Contains(param.substr(0, equals))) {
+      if (!removed) {
+        // The query is only rebuilt once a tracker is found. Everything
+        // before it is kept as is.
+        removed = true;
+        any_kept = start > 0;
+        stripped.assign(query.data(), any_kept ? start - 1 : 0);
+      }
+    } else if (removed) {
+      if (any_kept)
+        stripped.push_back('&');
+      param.AppendToString(&stripped);
+      any_kept = true;
+    }
+
+    if (end == query.size())
+      break;
+    start = end + 1;
+  }
+
+  if (!removed)
+    return base::nullopt;
+  return stripped;
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,61 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_STRING_TRACKERS_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_STRING_TRACKERS_H_
+
+#include <string>
+#include <vector>
+
+#include "base/containers/flat_set.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/optional.h"
+#include "base/strings/string_piece.h"
+
+namespace brave_shields {
+
+// Names of query string parameters that are only used for cross-site
+// tracking, e.g. fbclid. Immutable, so it can be shared across threads.
+class QueryStringTrackers
+    : public base::RefCountedThreadSafe<QueryStringTrackers> {
+ public:
+  // The list built into the browser, used until the data file is loaded.
+  static scoped_refptr<const QueryStringTrackers> CreateDefault();
+  // Parses a JSON list of parameter names. Returns nullptr if |json| isn't
+  // a list of strings.
+  static scoped_refptr<const QueryStringTrackers> CreateFromJSON(
+      base::StringPiece json);
+
+  // The list currently in use. Can be called on any thread.
+  static scoped_refptr<const QueryStringTrackers> GetCurrent();
+  static void SetCurrent(scoped_refptr<const QueryStringTrackers> trackers);
+
+  // Names are matched case-insensitively.
+  bool Contains(base::StringPiece name) const;
+
+  // Walks |query| once and returns it without the tracker parameters that
+  // have a value, or nullopt if there were none.
+  base::Optional<std::string> StripTrackers(base::StringPiece query) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<QueryStringTrackers>;
+
+  struct CaseInsensitiveLess {
+    using is_transparent = void;
+    bool operator()(base::StringPiece a, base::StringPiece b) const;
+  };
+
+  explicit QueryStringTrackers(std::vector<std::string> names);
+  ~QueryStringTrackers();
+
+  const base::flat_set<std::string, CaseInsensitiveLess> names_;
+
+  DISALLOW_COPY_AND_ASSIGN(QueryStringTrackers);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_STRING_TRACKERS_H_
@@ -0,0 +1,82 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/query_string_trackers_service.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/task_runner_util.h"
+#include "brave/components/brave_component_updater/browser/local_data_files_service.h"
+#include "brave/components/brave_shields/browser/query_string_trackers.h"
+
+namespace brave_shields {
+
+const char kQueryStringTrackersFile[] = "QueryStringTrackers.json";
+const char kQueryStringTrackersFileVersion[] = "1";
+
+namespace {
+
+// Unlike GetDATFileAsString, a missing file isn't logged as an error, because
+// component versions that predate the list don't ship it.
+std::string ReadQueryStringTrackersFile(const base::FilePath& path) {
+  std::string contents;
+  if (!base::ReadFileToString(path, &contents))
+    return std::string();
+  return contents;
+}
+
+}  // namespace
+
+QueryStringTrackersService::QueryStringTrackersService(
+    LocalDataFilesService* local_data_files_service)
+    : LocalDataFilesObserver(local_data_files_service) {}
+
+QueryStringTrackersService::~QueryStringTrackersService() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+void QueryStringTrackersService::OnComponentReady(
+    const std::string& component_id,
+    const base::FilePath& install_dir,
+    const std::string& manifest) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  base::FilePath dat_file_path =
+      install_dir.AppendASCII(kQueryStringTrackersFileVersion)
+          .AppendASCII(kQueryStringTrackersFile);
+
+  base::PostTaskAndReplyWithResult(
+      local_data_files_service()->GetTaskRunner().get(), FROM_HERE,
+      base::BindOnce(&ReadQueryStringTrackersFile, dat_file_path),
+      base::BindOnce(&QueryStringTrackersService::OnDATFileDataReady,
+                     weak_factory_.GetWeakPtr()));
+}
+
+void QueryStringTrackersService::OnDATFileDataReady(std::string contents) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  // Missing or empty files keep the built-in list.
+  if (contents.empty())
+    return;
+
+  scoped_refptr<const QueryStringTrackers> trackers =
+      QueryStringTrackers::CreateFromJSON(contents);
+  if (!trackers) {
+    LOG(ERROR) << "Failed to parse query string trackers";
+    return;
+  }
+  QueryStringTrackers::SetCurrent(std::move(trackers));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<QueryStringTrackersService> QueryStringTrackersServiceFactory(
+    LocalDataFilesService* local_data_files_service) {
+  return std::make_unique<QueryStringTrackersService>(
+      local_data_files_service);
+}
+
+}  // namespace brave_shields
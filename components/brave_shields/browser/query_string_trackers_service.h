@@ -0,0 +1,54 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_STRING_TRACKERS_SERVICE_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_STRING_TRACKERS_SERVICE_H_
+
+#include <memory>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequence_checker.h"
+#include "brave/components/brave_component_updater/browser/local_data_files_observer.h"
+
+using brave_component_updater::LocalDataFilesObserver;
+using brave_component_updater::LocalDataFilesService;
+
+namespace brave_shields {
+
+extern const char kQueryStringTrackersFile[];
+extern const char kQueryStringTrackersFileVersion[];
+
+// Loads the list of tracking query string parameters from the local data
+// files component, so it can be updated without a browser release. The
+// built-in list stays in use until then, or if the file is invalid.
+class QueryStringTrackersService : public LocalDataFilesObserver {
+ public:
+  explicit QueryStringTrackersService(
+      LocalDataFilesService* local_data_files_service);
+  ~QueryStringTrackersService() override;
+
+  // implementation of LocalDataFilesObserver
+  void OnComponentReady(const std::string& component_id,
+                        const base::FilePath& install_dir,
+                        const std::string& manifest) override;
+
+ private:
+  void OnDATFileDataReady(std::string contents);
+
+  SEQUENCE_CHECKER(sequence_checker_);
+  base::WeakPtrFactory<QueryStringTrackersService> weak_factory_{this};
+
+  DISALLOW_COPY_AND_ASSIGN(QueryStringTrackersService);
+};
+
+// Creates the QueryStringTrackersService
+std::unique_ptr<QueryStringTrackersService> QueryStringTrackersServiceFactory(
+    LocalDataFilesService* local_data_files_service);
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_STRING_TRACKERS_SERVICE_H_
@@ -0,0 +1,74 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/query_string_trackers.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace brave_shields {
+
+TEST(QueryStringTrackersTest, StripTrackers) {
+  const auto trackers = QueryStringTrackers::CreateDefault();
+  const struct {
+    const char* query;
+    const char* expected;
+  } kCases[] = {
+      {"fbclid=1", ""},
+      {"fbclid=1&foo=1", "foo=1"},
+      {"foo=1&fbclid=1", "foo=1"},
+      {"foo=1&fbclid=1&bar=2", "foo=1&bar=2"},
+      {"fbclid=1&gclid=2&foo=1&mc_eid=3", "foo=1"},
+      {"foo=1&&fbclid=1&", "foo=1&&"},
+      {"&fbclid=1&foo", "&foo"},
+      {"FBCLID=1&foo=1", "foo=1"},
+      {"hscTATracking=1", ""},
+      {"fbclid=a=b&foo=1", "foo=1"},
+  };
+  for (const auto& test_case : kCases) {
+    base::Optional<std::string> stripped =
+        trackers->StripTrackers(test_case.query);
+    ASSERT_TRUE(stripped) << test_case.query;
+    EXPECT_EQ(test_case.expected, *stripped) << test_case.query;
+  }
+}
+
+TEST(QueryStringTrackersTest, UntouchedWithoutTrackers) {
+  const auto trackers = QueryStringTrackers::CreateDefault();
+  for (const char* query :
+       {"", "foo=1", "fbclid", "fbclid=", "foo=1&fbclid=&bar=2",
+        "xfbclid=1", "fbclidx=1", "foo=fbclid"}) {
+    EXPECT_FALSE(trackers->StripTrackers(query)) << query;
+  }
+}
+
+TEST(QueryStringTrackersTest, CreateFromJSON) {
+  const auto trackers =
+      QueryStringTrackers::CreateFromJSON(R"(["utm_source", "fbclid"])");
+  ASSERT_TRUE(trackers);
+  EXPECT_TRUE(trackers->Contains("utm_source"));
+  EXPECT_TRUE(trackers->Contains("FBCLID"));
+  EXPECT_FALSE(trackers->Contains("gclid"));
+
+  EXPECT_FALSE(QueryStringTrackers::CreateFromJSON("not json"));
+  EXPECT_FALSE(QueryStringTrackers::CreateFromJSON(R"({"fbclid": 1})"));
+  EXPECT_FALSE(QueryStringTrackers::CreateFromJSON(R"(["fbclid", 1])"));
+  EXPECT_FALSE(QueryStringTrackers::CreateFromJSON(R"(["fbclid", ""])"));
+}
+
+TEST(QueryStringTrackersTest, SetCurrent) {
+  const auto default_trackers = QueryStringTrackers::GetCurrent();
+  EXPECT_TRUE(default_trackers->Contains("fbclid"));
+
+  QueryStringTrackers::SetCurrent(
+      QueryStringTrackers::CreateFromJSON(R"(["utm_source"])"));
+  EXPECT_TRUE(QueryStringTrackers::GetCurrent()->Contains("utm_source"));
+  EXPECT_FALSE(QueryStringTrackers::GetCurrent()->Contains("fbclid"));
+
+  QueryStringTrackers::SetCurrent(default_trackers);
+}
+
+}  // namespace brave_shields
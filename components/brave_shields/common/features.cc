@@ -10,6 +10,11 @@
 namespace brave_shields {
 namespace features {
 
+// When enabled, subresource requests arriving close together are matched
+// against the adblock engines in a single task on the adblock task runner
+// instead of one task per request.
+const base::Feature kBraveAdblockBatchMatching{
+    "BraveAdblockBatchMatching", base::FEATURE_DISABLED_BY_DEFAULT};
 // When enabled, Brave will issue DNS queries for requests that the adblock
 // engine has not blocked, then check them again with the original hostname
 // substituted for any canonical name found.
@@ -20,8 +25,16 @@ const base::Feature kBraveAdblockCosmeticFiltering{
     base::FEATURE_ENABLED_BY_DEFAULT};
 const base::Feature kBraveAdblockCosmeticFilteringNative{
     "BraveAdblockCosmeticFilteringNative", base::FEATURE_DISABLED_BY_DEFAULT};
+// When enabled, the merged cosmetic resources for a host are cached until an
+// engine changes, and computed as soon as a navigation to the host starts.
+const base::Feature kBraveAdblockCosmeticResourcesCache{
+    "BraveAdblockCosmeticResourcesCache", base::FEATURE_ENABLED_BY_DEFAULT};
 const base::Feature kBraveAdblockCspRules{
     "BraveAdblockCspRules", base::FEATURE_ENABLED_BY_DEFAULT};
+// When enabled, adblock DAT files are deserialized directly from a read-only
+// memory mapping instead of first being copied into a heap buffer.
+const base::Feature kBraveAdblockMappedDATLoading{
+    "BraveAdblockMappedDATLoading", base::FEATURE_ENABLED_BY_DEFAULT};
 // When enabled, Brave will block domains listed in the user's selected adblock
 // filters and present a security interstitial with choice to proceed and
 // optionally whitelist the domain.
@@ -33,6 +46,19 @@ const base::Feature kBraveDomainBlock{"BraveDomainBlock",
 // potentially blocked by Brave Shields.
 const base::Feature kBraveExtensionNetworkBlocking{
     "BraveExtensionNetworkBlocking", base::FEATURE_DISABLED_BY_DEFAULT};
+// When enabled, HTTPS Everywhere rules are converted once into a sorted host
+// table that is memory mapped on later startups, instead of unzipping and
+// opening the bundled leveldb database every time.
+const base::Feature kBraveHTTPSEverywhereHostTable{
+    "BraveHTTPSEverywhereHostTable", base::FEATURE_ENABLED_BY_DEFAULT};
+// When enabled, network delegate helpers that only depend on the per-request
+// settings snapshot run on a dedicated sequence instead of the UI thread.
+const base::Feature kBraveRequestHandlerOffUIThread{
+    "BraveRequestHandlerOffUIThread", base::FEATURE_DISABLED_BY_DEFAULT};
+// When enabled, shields content settings for a top-frame origin are looked up
+// once and shared by all of its requests until a shields setting changes.
+const base::Feature kBraveShieldsSettingsSnapshot{
+    "BraveShieldsSettingsSnapshot", base::FEATURE_ENABLED_BY_DEFAULT};
 
 }  // namespace features
 }  // namespace brave_shields
@@ -12,12 +12,18 @@ struct Feature;
 
 namespace brave_shields {
 namespace features {
+extern const base::Feature kBraveAdblockBatchMatching;
 extern const base::Feature kBraveAdblockCnameUncloaking;
 extern const base::Feature kBraveAdblockCosmeticFiltering;
 extern const base::Feature kBraveAdblockCosmeticFilteringNative;
+extern const base::Feature kBraveAdblockCosmeticResourcesCache;
 extern const base::Feature kBraveAdblockCspRules;
+extern const base::Feature kBraveAdblockMappedDATLoading;
 extern const base::Feature kBraveDomainBlock;
 extern const base::Feature kBraveExtensionNetworkBlocking;
+extern const base::Feature kBraveHTTPSEverywhereHostTable;
+extern const base::Feature kBraveRequestHandlerOffUIThread;
+extern const base::Feature kBraveShieldsSettingsSnapshot;
 }  // namespace features
 }  // namespace brave_shields
 
@@ -15,6 +15,7 @@
 #include "brave/common/pref_names.h"
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
 #include "brave/components/content_settings/core/browser/brave_content_settings_utils.h"
+#include "brave/components/content_settings/core/browser/brave_cookie_rule_store.h"
 #include "components/content_settings/core/browser/content_settings_pref.h"
 #include "components/content_settings/core/browser/website_settings_registry.h"
 #include "components/content_settings/core/common/content_settings_pattern.h"
@@ -23,7 +24,6 @@
 #include "components/prefs/pref_service.h"
 #include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
-#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
 #include "services/preferences/public/cpp/dictionary_value_update.h"
 #include "services/preferences/public/cpp/scoped_pref_update.h"
 
@@ -31,90 +31,37 @@ namespace content_settings {
 
 namespace {
 
-constexpr char kGoogleAuthPattern[] = "https://accounts.google.com/*";
-constexpr char kFirebasePattern[] = "https://[*.]firebaseapp.com/*";
-
 const char kExpirationPath[] = "expiration";
 const char kLastModifiedPath[] = "last_modified";
 const char kSessionModelPath[] = "model";
 const char kSettingPath[] = "setting";
 const char kPerResourcePath[] = "per_resource";
 
-Rule CloneRule(const Rule& rule, bool reverse_patterns = false) {
-  // brave plugin rules incorrectly use first party url as primary
-  auto primary_pattern = reverse_patterns ? rule.secondary_pattern
-                                          : rule.primary_pattern;
-  auto secondary_pattern = reverse_patterns ? rule.primary_pattern
-                                            : rule.secondary_pattern;
-
-  if (primary_pattern ==
-      ContentSettingsPattern::FromString("https://firstParty/*")) {
-    DCHECK(reverse_patterns);  // we should only hit this for brave plugin rules
-    if (!secondary_pattern.MatchesAllHosts()) {
-      primary_pattern = ContentSettingsPattern::FromString(
-          "*://[*.]" +
-          net::registry_controlled_domains::GetDomainAndRegistry(
-              secondary_pattern.GetHost(),
-              net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES) +
-          "/*");
-    } else {
-      primary_pattern = secondary_pattern;
-    }
-  }
-
-  return Rule(primary_pattern, secondary_pattern, rule.value.Clone(),
-              rule.expiration, rule.session_model);
-}
-
 class BraveShieldsRuleIterator : public RuleIterator {
  public:
-  explicit BraveShieldsRuleIterator(std::vector<Rule> rules)
-      : rules_(std::move(rules)) {
-    iterator_ = rules_.begin();
-  }
+  explicit BraveShieldsRuleIterator(
+      scoped_refptr<const BraveCookieRuleStore::Rules> rules)
+      : rules_(std::move(rules)), iterator_(rules_->data.begin()) {}
 
   bool HasNext() const override {
-    return iterator_ != rules_.end();
+    return iterator_ != rules_->data.end();
   }
 
   Rule Next() override {
-    return CloneRule(*(iterator_++));
+    const Rule& rule = *(iterator_++);
+    return Rule(rule.primary_pattern, rule.secondary_pattern,
+                rule.value.Clone(), rule.expiration, rule.session_model);
   }
 
  private:
-  std::vector<Rule> rules_;
+  // Shared with the provider and other iterators, so rules are only cloned
+  // as they are returned.
+  scoped_refptr<const BraveCookieRuleStore::Rules> rules_;
   std::vector<Rule>::const_iterator iterator_;
 
   DISALLOW_COPY_AND_ASSIGN(BraveShieldsRuleIterator);
 };
 
-
-bool IsActive(const Rule& cookie_rule,
-              const std::vector<Rule>& shield_rules) {
-  // don't include default rules in the iterator
-  if (cookie_rule.primary_pattern == ContentSettingsPattern::Wildcard() &&
-      (cookie_rule.secondary_pattern == ContentSettingsPattern::Wildcard() ||
-       cookie_rule.secondary_pattern ==
-          ContentSettingsPattern::FromString("https://firstParty/*"))) {
-    return false;
-  }
-
-  bool default_value = true;
-  for (const auto& shield_rule : shield_rules) {
-    auto primary_compare =
-        shield_rule.primary_pattern.Compare(cookie_rule.primary_pattern);
-    // TODO(bridiver) - verify that SUCCESSOR is correct and not PREDECESSOR
-    if (primary_compare == ContentSettingsPattern::IDENTITY ||
-        primary_compare == ContentSettingsPattern::SUCCESSOR) {
-      // TODO(bridiver) - move this logic into shields_util for allow/block
-      return
-          ValueToContentSetting(&shield_rule.value) != CONTENT_SETTING_BLOCK;
-    }
-  }
-
-  return default_value;
-}
-
 }  // namespace
 
 // static
@@ -146,7 +93,12 @@ BravePrefProvider::BravePrefProvider(PrefService* prefs,
 
   MigrateShieldsSettings(off_the_record);
 
-  OnCookieSettingsChanged(ContentSettingsType::BRAVE_COOKIES);
+  OnCookiePrefsChanged(kGoogleLoginControlType);
+  for (auto content_type :
+       {ContentSettingsType::COOKIES, ContentSettingsType::BRAVE_SHIELDS,
+        ContentSettingsType::BRAVE_COOKIES}) {
+    OnCookieSettingsChanged(content_type);
+  }
 
   // Enable change notifications after initial setup to avoid notification spam
   initialized_ = true;
@@ -366,16 +318,11 @@ bool BravePrefProvider::SetWebsiteSetting(
     const ContentSettingConstraints& constraints) {
   // handle changes to brave cookie settings from chromium cookie settings UI
   if (content_type == ContentSettingsType::COOKIES) {
-    auto* value = in_value.get();
-    auto match = std::find_if(
-        brave_cookie_rules_[off_the_record_].begin(),
-        brave_cookie_rules_[off_the_record_].end(),
-        [primary_pattern, secondary_pattern, value](const auto& rule) {
-          return rule.primary_pattern == primary_pattern &&
-                 rule.secondary_pattern == secondary_pattern &&
-                 ValueToContentSetting(&rule.value) !=
-                    ValueToContentSetting(value); });
-    if (match != brave_cookie_rules_[off_the_record_].end()) {
+    auto brave_setting =
+        cookie_rule_stores_[off_the_record_].GetBraveRuleSetting(
+            primary_pattern, secondary_pattern);
+    if (brave_setting &&
+        *brave_setting != ValueToContentSetting(in_value.get())) {
       // swap primary/secondary pattern - see CloneRule
       auto plugin_primary_pattern = secondary_pattern;
       auto plugin_secondary_pattern = primary_pattern;
@@ -416,23 +363,30 @@ bool BravePrefProvider::SetWebsiteSettingInternal(
                             std::move(in_value), constraints);
   }
 
-  return PrefProvider::SetWebsiteSetting(primary_pattern, secondary_pattern,
-                                         content_type, std::move(in_value),
-                                         constraints);
+  // Keep the rule being written so the change notification it triggers can
+  // update the cookie rules without reading the type back.
+  if (content_type == ContentSettingsType::BRAVE_COOKIES ||
+      content_type == ContentSettingsType::BRAVE_SHIELDS) {
+    pending_cookie_rule_.emplace(
+        content_type,
+        Rule(primary_pattern, secondary_pattern,
+             in_value ? in_value->Clone() : base::Value(),
+             constraints.expiration, constraints.session_model));
+  }
+  const bool result = PrefProvider::SetWebsiteSetting(
+      primary_pattern, secondary_pattern, content_type, std::move(in_value),
+      constraints);
+  pending_cookie_rule_.reset();
+  return result;
 }
 
 std::unique_ptr<RuleIterator> BravePrefProvider::GetRuleIterator(
       ContentSettingsType content_type,
       bool incognito) const {
   if (content_type == ContentSettingsType::COOKIES) {
-    std::vector<Rule> rules;
-    for (auto i = cookie_rules_.at(incognito).begin();
-         i != cookie_rules_.at(incognito).end();
-         ++i) {
-      rules.emplace_back(CloneRule(*i));
-    }
-
-    return std::make_unique<BraveShieldsRuleIterator>(std::move(rules));
+    base::AutoLock lock(cookie_rules_lock_);
+    return std::make_unique<BraveShieldsRuleIterator>(
+        cookie_rules_.at(incognito));
   }
 
   return PrefProvider::GetRuleIterator(content_type, incognito);
@@ -440,140 +394,35 @@ std::unique_ptr<RuleIterator> BravePrefProvider::GetRuleIterator(
 
 void BravePrefProvider::UpdateCookieRules(ContentSettingsType content_type,
                                           bool incognito) {
-  auto& rules = cookie_rules_[incognito];
-  auto old_rules = std::move(brave_cookie_rules_[incognito]);
-
-  rules.clear();
-  brave_cookie_rules_[incognito].clear();
-
-  // kGoogleLoginControlType preference adds an exception for
-  // accounts.google.com to access cookies in 3p context to allow login using
-  // google oauth. The exception is added before all overrides to allow google
-  // oauth to work when the user sets custom overrides for a site.
-  // For example: Google OAuth will be allowed if the user allows all cookies
-  // and sets 3p cookie blocking for a site.
-  //
-  // We also create the same exception for firebase apps, since they
-  // are tightly bound to google, and require google auth to work.
-  // See: #5075, #9852, #10367
-  if (prefs_->GetBoolean(kGoogleLoginControlType)) {
-    const auto google_auth_rule = Rule(
-        ContentSettingsPattern::FromString(kGoogleAuthPattern),
-        ContentSettingsPattern::Wildcard(),
-        base::Value::FromUniquePtrValue(
-                         ContentSettingToValue(CONTENT_SETTING_ALLOW)),
-                     base::Time(), SessionModel::Durable);
-    rules.emplace_back(CloneRule(google_auth_rule));
-    brave_cookie_rules_[incognito].emplace_back(CloneRule(google_auth_rule));
-
-    const auto firebase_rule = Rule(
-        ContentSettingsPattern::FromString(kFirebasePattern),
-        ContentSettingsPattern::Wildcard(),
-        base::Value::FromUniquePtrValue(
-            ContentSettingToValue(CONTENT_SETTING_ALLOW)),
-        base::Time(), SessionModel::Durable);
-    rules.emplace_back(CloneRule(firebase_rule));
-    brave_cookie_rules_[incognito].emplace_back(CloneRule(firebase_rule));
-  }
-  // non-pref based exceptions should go in the cookie_settings_base.cc
-  // chromium_src override
-
-  // add chromium cookies
-  auto chromium_cookies_iterator = PrefProvider::GetRuleIterator(
-      ContentSettingsType::COOKIES,
-      incognito);
-  while (chromium_cookies_iterator && chromium_cookies_iterator->HasNext()) {
-    rules.emplace_back(CloneRule(chromium_cookies_iterator->Next()));
-  }
-  chromium_cookies_iterator.reset();
-
-  auto brave_shields_iterator = PrefProvider::GetRuleIterator(
-      ContentSettingsType::BRAVE_SHIELDS, incognito);
-
-  // collect shield rules
-  std::vector<Rule> shield_rules;
-  while (brave_shields_iterator && brave_shields_iterator->HasNext()) {
-    shield_rules.emplace_back(CloneRule(brave_shields_iterator->Next()));
-  }
-
-  brave_shields_iterator.reset();
-
-  // add brave cookies after checking shield status
-  auto brave_cookies_iterator = PrefProvider::GetRuleIterator(
-      ContentSettingsType::BRAVE_COOKIES, incognito);
-
-  // Matching cookie rules against shield rules.
-  while (brave_cookies_iterator && brave_cookies_iterator->HasNext()) {
-    auto rule = brave_cookies_iterator->Next();
-    if (IsActive(rule, shield_rules)) {
-      rules.emplace_back(CloneRule(rule, true));
-      brave_cookie_rules_[incognito].emplace_back(CloneRule(rule, true));
-    }
-  }
-
-  // Adding shields down rules (they always override cookie rules).
-  for (const auto& shield_rule : shield_rules) {
-    // There is no global shields rule
-    if (shield_rule.primary_pattern.MatchesAllHosts())
-      NOTREACHED();
-
-    // Shields down.
-    if (ValueToContentSetting(&shield_rule.value) == CONTENT_SETTING_BLOCK) {
-      rules.emplace_back(
-          Rule(ContentSettingsPattern::Wildcard(),
-               shield_rule.primary_pattern,
-               base::Value::FromUniquePtrValue(
-                   ContentSettingToValue(CONTENT_SETTING_ALLOW)),
-               base::Time(), SessionModel::Durable));
-      brave_cookie_rules_[incognito].emplace_back(
-          Rule(ContentSettingsPattern::Wildcard(),
-               shield_rule.primary_pattern,
-               base::Value::FromUniquePtrValue(
-                   ContentSettingToValue(CONTENT_SETTING_ALLOW)),
-               base::Time(), SessionModel::Durable));
-    }
-  }
+  cookie_rule_stores_[incognito].ResetRules(
+      content_type, PrefProvider::GetRuleIterator(content_type, incognito));
+  PublishCookieRules(content_type, incognito);
+}
 
-  // get the list of changes
-  std::vector<Rule> brave_cookie_updates;
-  for (const auto& new_rule : brave_cookie_rules_[incognito]) {
-    auto match = std::find_if(
-        old_rules.begin(),
-        old_rules.end(),
-        [&new_rule](const auto& old_rule) {
-          // we want an exact match here because any change to the rule
-          // is an update
-          return new_rule.primary_pattern == old_rule.primary_pattern &&
-                 new_rule.secondary_pattern == old_rule.secondary_pattern &&
-                 ValueToContentSetting(&new_rule.value) ==
-                    ValueToContentSetting(&old_rule.value);
-        });
-    if (match == old_rules.end()) {
-      brave_cookie_updates.emplace_back(CloneRule(new_rule));
-    }
-  }
+void BravePrefProvider::UpdateCookieRule(ContentSettingsType content_type,
+                                         const Rule& rule) {
+  // PrefProvider writes to the incognito rules only when off the record, so
+  // the other store never changes.
+  cookie_rule_stores_[off_the_record_].UpdateRule(
+      content_type, rule.primary_pattern, rule.secondary_pattern,
+      rule.value.is_none() ? nullptr : &rule);
+  PublishCookieRules(content_type, off_the_record_);
+}
 
-  // find any removed rules
-  for (const auto& old_rule : old_rules) {
-    auto match = std::find_if(
-        brave_cookie_rules_[incognito].begin(),
-        brave_cookie_rules_[incognito].end(),
-        [&old_rule](const auto& new_rule) {
-          // we only care about the patterns here because we're looking
-          // for deleted rules, not changed rules
-          return new_rule.primary_pattern == old_rule.primary_pattern &&
-                 new_rule.secondary_pattern == old_rule.secondary_pattern;
-        });
-    if (match == brave_cookie_rules_[incognito].end()) {
-      brave_cookie_updates.emplace_back(
-          Rule(old_rule.primary_pattern, old_rule.secondary_pattern,
-               base::Value(), old_rule.expiration, old_rule.session_model));
-    }
+void BravePrefProvider::PublishCookieRules(ContentSettingsType content_type,
+                                           bool incognito) {
+  auto& store = cookie_rule_stores_[incognito];
+  auto rules = store.BuildRules();
+  {
+    base::AutoLock lock(cookie_rules_lock_);
+    cookie_rules_[incognito] = std::move(rules);
   }
 
+  auto brave_cookie_updates = store.TakeChangedBraveRules();
   // Notify brave cookie changes as ContentSettingsType::COOKIES
-  if (initialized_ && (content_type == ContentSettingsType::BRAVE_COOKIES ||
-                       content_type == ContentSettingsType::BRAVE_SHIELDS)) {
+  if (initialized_ && !brave_cookie_updates.empty() &&
+      (content_type == ContentSettingsType::BRAVE_COOKIES ||
+       content_type == ContentSettingsType::BRAVE_SHIELDS)) {
     // PostTask here to avoid content settings autolock DCHECK
     base::PostTask(
         FROM_HERE,
@@ -584,17 +433,22 @@ void BravePrefProvider::UpdateCookieRules(ContentSettingsType content_type,
   }
 }
 
-void BravePrefProvider::NotifyChanges(const std::vector<Rule>& rules,
-                                      bool incognito) {
-  for (const auto& rule : rules) {
-    Notify(rule.primary_pattern, rule.secondary_pattern,
+void BravePrefProvider::NotifyChanges(
+    const std::vector<BraveCookieRuleStore::PatternPair>& patterns,
+    bool incognito) {
+  for (const auto& pattern_pair : patterns) {
+    Notify(pattern_pair.first, pattern_pair.second,
            ContentSettingsType::COOKIES);
   }
 }
 
 void BravePrefProvider::OnCookiePrefsChanged(
     const std::string& pref) {
-  OnCookieSettingsChanged(ContentSettingsType::BRAVE_COOKIES);
+  const bool enabled = prefs_->GetBoolean(kGoogleLoginControlType);
+  for (bool incognito : {true, false}) {
+    cookie_rule_stores_[incognito].SetGoogleAuthRulesEnabled(enabled);
+    PublishCookieRules(ContentSettingsType::BRAVE_COOKIES, incognito);
+  }
 }
 
 void BravePrefProvider::OnCookieSettingsChanged(
@@ -610,6 +464,16 @@ void BravePrefProvider::OnContentSettingChanged(
   if (content_type == ContentSettingsType::COOKIES ||
       content_type == ContentSettingsType::BRAVE_COOKIES ||
       content_type == ContentSettingsType::BRAVE_SHIELDS) {
+    // A rule written through SetWebsiteSetting is updated on its own. Any
+    // other change, e.g. prefs synced with wildcard patterns, reads the type
+    // again. Chromium cookie rules are few, so those are always read again.
+    if (content_type != ContentSettingsType::COOKIES && pending_cookie_rule_ &&
+        pending_cookie_rule_->first == content_type &&
+        pending_cookie_rule_->second.primary_pattern == primary_pattern &&
+        pending_cookie_rule_->second.secondary_pattern == secondary_pattern) {
+      UpdateCookieRule(content_type, pending_cookie_rule_->second);
+      return;
+    }
     OnCookieSettingsChanged(content_type);
   }
 }
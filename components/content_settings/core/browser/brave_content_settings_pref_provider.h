@@ -9,9 +9,13 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/memory/weak_ptr.h"
+#include "base/optional.h"
+#include "base/synchronization/lock.h"
+#include "brave/components/content_settings/core/browser/brave_cookie_rule_store.h"
 #include "components/content_settings/core/browser/content_settings_observer.h"
 #include "components/content_settings/core/browser/content_settings_pref_provider.h"
 #include "components/prefs/pref_change_registrar.h"
@@ -63,8 +67,14 @@ class BravePrefProvider : public PrefProvider,
   void MigrateShieldsSettingsV1ToV2();
   void MigrateShieldsSettingsV1ToV2ForOneType(ContentSettingsType content_type);
   void UpdateCookieRules(ContentSettingsType content_type, bool incognito);
+  // Applies |rule|, just written to |content_type|, to the cookie rules. Its
+  // value is none if the setting was reset to default.
+  void UpdateCookieRule(ContentSettingsType content_type, const Rule& rule);
+  void PublishCookieRules(ContentSettingsType content_type, bool incognito);
   void OnCookieSettingsChanged(ContentSettingsType content_type);
-  void NotifyChanges(const std::vector<Rule>& rules, bool incognito);
+  void NotifyChanges(
+      const std::vector<BraveCookieRuleStore::PatternPair>& patterns,
+      bool incognito);
   bool SetWebsiteSettingInternal(
       const ContentSettingsPattern& primary_pattern,
       const ContentSettingsPattern& secondary_pattern,
@@ -78,8 +88,17 @@ class BravePrefProvider : public PrefProvider,
                                ContentSettingsType content_type) override;
   void OnCookiePrefsChanged(const std::string& pref);
 
-  std::map<bool /* is_incognito */, std::vector<Rule>> cookie_rules_;
-  std::map<bool /* is_incognito */, std::vector<Rule>> brave_cookie_rules_;
+  std::map<bool /* is_incognito */, BraveCookieRuleStore> cookie_rule_stores_;
+  // The rules of |cookie_rule_stores_| as of their last change, shared with
+  // the iterators GetRuleIterator() hands out.
+  mutable base::Lock cookie_rules_lock_;
+  std::map<bool /* is_incognito */,
+           scoped_refptr<const BraveCookieRuleStore::Rules>>
+      cookie_rules_;
+
+  // The BRAVE_COOKIES or BRAVE_SHIELDS rule SetWebsiteSettingInternal is
+  // writing, if any.
+  base::Optional<std::pair<ContentSettingsType, Rule>> pending_cookie_rule_;
 
   bool initialized_;
   bool store_last_modified_;
@@ -8,6 +8,8 @@
 
 #include "base/macros.h"
 #include "base/optional.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
 #include "base/values.h"
 #include "brave/common/pref_names.h"
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
@@ -25,6 +27,7 @@
 #include "services/preferences/public/cpp/dictionary_value_update.h"
 #include "services/preferences/public/cpp/scoped_pref_update.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
 #include "url/gurl.h"
 
 namespace content_settings {
@@ -40,6 +43,9 @@ const char kSessionModelPath[] = "model";
 const char kSettingPath[] = "setting";
 const char kPerResourcePath[] = "per_resource";
 
+constexpr size_t kPerfSiteOverrides = 10000;
+constexpr size_t kPerfIterations = 100;
+
 using GURLSourcePair = std::pair<GURL, ContentSettingsType>;
 
 ContentSettingsPattern SecondaryUrlToPattern(const GURL& gurl) {
@@ -122,6 +128,29 @@ void CheckMigrationFromResourceIdentifierForDictionary(
   EXPECT_EQ(actual_value, expected_setting_value);
 }
 
+std::string SiteOverridePattern(size_t i) {
+  return base::StringPrintf("[*.]site%zu.com", i);
+}
+
+// Writes |setting| for |count| sites straight to prefs, the way settings
+// restored from disk or sync arrive.
+void SeedSiteOverrides(PrefService* prefs,
+                       ContentSettingsType content_type,
+                       size_t count,
+                       ContentSetting setting) {
+  prefs::ScopedDictionaryPrefUpdate update(
+      prefs,
+      GetShieldsSettingUserPrefsPath(GetShieldsContentTypeName(content_type)));
+  std::unique_ptr<prefs::DictionaryValueUpdate> dictionary = update.Get();
+  for (size_t i = 0; i < count; ++i) {
+    std::unique_ptr<prefs::DictionaryValueUpdate> settings_dictionary =
+        dictionary->SetDictionaryWithoutPathExpansion(
+            SiteOverridePattern(i) + ",*",
+            std::make_unique<base::DictionaryValue>());
+    settings_dictionary->SetInteger(kSettingPath, setting);
+  }
+}
+
 class ShieldsSetting {
  public:
   ShieldsSetting(BravePrefProvider* provider,
@@ -524,4 +553,108 @@ TEST_F(BravePrefProviderTest, TestShieldsSettingsMigrationFromUnknownSettings) {
   provider.ShutdownOnUIThread();
 }
 
+TEST_F(BravePrefProviderTest, TestCookieRulesFollowShieldsSetting) {
+  BravePrefProvider provider(
+      testing_profile()->GetPrefs(), false /* incognito */,
+      true /* store_last_modified */, false /* restore_session */);
+  const GURL site("https://www.example.com");
+  const GURL tracker("https://tracker.com");
+  const auto pattern = ContentSettingsPattern::FromString("[*.]example.com");
+
+  provider.SetWebsiteSetting(pattern, ContentSettingsPattern::Wildcard(),
+                             ContentSettingsType::BRAVE_COOKIES,
+                             ContentSettingToValue(CONTENT_SETTING_BLOCK), {});
+  EXPECT_EQ(CONTENT_SETTING_BLOCK,
+            TestUtils::GetContentSetting(&provider, tracker, site,
+                                         ContentSettingsType::COOKIES, false));
+
+  // Shields down replaces the site's cookie settings.
+  provider.SetWebsiteSetting(pattern, ContentSettingsPattern::Wildcard(),
+                             ContentSettingsType::BRAVE_SHIELDS,
+                             ContentSettingToValue(CONTENT_SETTING_BLOCK), {});
+  EXPECT_EQ(CONTENT_SETTING_ALLOW,
+            TestUtils::GetContentSetting(&provider, tracker, site,
+                                         ContentSettingsType::COOKIES, false));
+
+  provider.SetWebsiteSetting(pattern, ContentSettingsPattern::Wildcard(),
+                             ContentSettingsType::BRAVE_SHIELDS,
+                             ContentSettingToValue(CONTENT_SETTING_DEFAULT),
+                             {});
+  EXPECT_EQ(CONTENT_SETTING_BLOCK,
+            TestUtils::GetContentSetting(&provider, tracker, site,
+                                         ContentSettingsType::COOKIES, false));
+
+  provider.SetWebsiteSetting(pattern, ContentSettingsPattern::Wildcard(),
+                             ContentSettingsType::BRAVE_COOKIES,
+                             ContentSettingToValue(CONTENT_SETTING_DEFAULT),
+                             {});
+  EXPECT_EQ(CONTENT_SETTING_DEFAULT,
+            TestUtils::GetContentSetting(&provider, tracker, site,
+                                         ContentSettingsType::COOKIES, false));
+
+  provider.ShutdownOnUIThread();
+}
+
+TEST_F(BravePrefProviderTest, TestCookieRulesPerf) {
+  PrefService* prefs = testing_profile()->GetPrefs();
+  prefs->SetBoolean(kGoogleLoginControlType, false);
+  SeedSiteOverrides(prefs, ContentSettingsType::BRAVE_COOKIES,
+                    kPerfSiteOverrides, CONTENT_SETTING_BLOCK);
+  // Every other site has shields down.
+  SeedSiteOverrides(prefs, ContentSettingsType::BRAVE_SHIELDS,
+                    kPerfSiteOverrides / 2, CONTENT_SETTING_BLOCK);
+
+  base::ElapsedTimer load_timer;
+  BravePrefProvider provider(prefs, false /* incognito */,
+                             true /* store_last_modified */,
+                             false /* restore_session */);
+  const double load_ms = load_timer.Elapsed().InMillisecondsF();
+
+  // Toggling shields for one site.
+  const auto pattern = ContentSettingsPattern::FromString(
+      SiteOverridePattern(kPerfSiteOverrides - 1));
+  base::ElapsedTimer update_timer;
+  for (size_t i = 0; i < kPerfIterations; ++i) {
+    provider.SetWebsiteSetting(
+        pattern, ContentSettingsPattern::Wildcard(),
+        ContentSettingsType::BRAVE_SHIELDS,
+        ContentSettingToValue(i % 2 ? CONTENT_SETTING_DEFAULT
+                                    : CONTENT_SETTING_BLOCK),
+        {});
+  }
+  const double update_ms =
+      update_timer.Elapsed().InMillisecondsF() / kPerfIterations;
+
+  base::ElapsedTimer iterator_timer;
+  for (size_t i = 0; i < kPerfIterations; ++i) {
+    auto rule_iterator =
+        provider.GetRuleIterator(ContentSettingsType::COOKIES, false);
+    EXPECT_TRUE(rule_iterator->HasNext());
+  }
+  const double iterator_us =
+      iterator_timer.Elapsed().InMicrosecondsF() / kPerfIterations;
+
+  // Half the sites have their cookie rule, the other half a shields down rule.
+  size_t rule_count = 0;
+  auto rule_iterator =
+      provider.GetRuleIterator(ContentSettingsType::COOKIES, false);
+  while (rule_iterator->HasNext()) {
+    rule_iterator->Next();
+    ++rule_count;
+  }
+  rule_iterator.reset();
+  EXPECT_EQ(kPerfSiteOverrides, rule_count);
+
+  perf_test::PerfResultReporter reporter("BravePrefProvider",
+                                         "10k_site_overrides");
+  reporter.RegisterImportantMetric(".load", "ms");
+  reporter.RegisterImportantMetric(".shields_toggle", "ms");
+  reporter.RegisterImportantMetric(".cookie_rule_iterator", "us");
+  reporter.AddResult(".load", load_ms);
+  reporter.AddResult(".shields_toggle", update_ms);
+  reporter.AddResult(".cookie_rule_iterator", iterator_us);
+
+  provider.ShutdownOnUIThread();
+}
+
 }  //  namespace content_settings
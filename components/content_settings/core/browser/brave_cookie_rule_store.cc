@@ -0,0 +1,427 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/content_settings/core/browser/brave_cookie_rule_store.h"
+
+#include "base/stl_util.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/values.h"
+#include "components/content_settings/core/common/content_settings_utils.h"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
+
+namespace content_settings {
+
+namespace {
+
+constexpr char kGoogleAuthPattern[] = "https://accounts.google.com/*";
+constexpr char kFirebasePattern[] = "https://[*.]firebaseapp.com/*";
+constexpr char kFirstPartyPattern[] = "https://firstParty/*";
+
+Rule CloneRule(const Rule& rule) {
+  return Rule(rule.primary_pattern, rule.secondary_pattern, rule.value.Clone(),
+              rule.expiration, rule.session_model);
+}
+
+Rule MakeAllowRule(const ContentSettingsPattern& primary_pattern,
+                   const ContentSettingsPattern& secondary_pattern) {
+  return Rule(primary_pattern, secondary_pattern,
+              base::Value::FromUniquePtrValue(
+                  ContentSettingToValue(CONTENT_SETTING_ALLOW)),
+              base::Time(), SessionModel::Durable);
+}
+
+// brave plugin rules incorrectly use first party url as primary
+Rule ReverseRule(const Rule& rule) {
+  auto primary_pattern = rule.secondary_pattern;
+  auto secondary_pattern = rule.primary_pattern;
+
+  if (primary_pattern ==
+      ContentSettingsPattern::FromString(kFirstPartyPattern)) {
+    if (!secondary_pattern.MatchesAllHosts()) {
+      primary_pattern = ContentSettingsPattern::FromString(
+          "*://[*.]" +
+          net::registry_controlled_domains::GetDomainAndRegistry(
+              secondary_pattern.GetHost(),
+              net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES) +
+          "/*");
+    } else {
+      primary_pattern = secondary_pattern;
+    }
+  }
+
+  return Rule(primary_pattern, secondary_pattern, rule.value.Clone(),
+              rule.expiration, rule.session_model);
+}
+
+// "www.example.com" becomes "com.example.www.", so a host's subdomains are
+// the hosts whose key starts with its key.
+std::string GetReversedHostKey(const std::string& host) {
+  std::string key;
+  key.reserve(host.size() + 1);
+  const auto labels = base::SplitStringPiece(
+      host, ".", base::KEEP_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  for (auto label = labels.rbegin(); label != labels.rend(); ++label) {
+    label->AppendToString(&key);
+    key.push_back('.');
+  }
+  return key;
+}
+
+}  // namespace
+
+BraveCookieRuleStore::BraveCookieRule::BraveCookieRule(Rule rule, bool active)
+    : rule(std::move(rule)), active(active) {}
+
+BraveCookieRuleStore::BraveCookieRule::BraveCookieRule(BraveCookieRule&&) =
+    default;
+
+BraveCookieRuleStore::BraveCookieRule&
+BraveCookieRuleStore::BraveCookieRule::operator=(BraveCookieRule&&) = default;
+
+BraveCookieRuleStore::BraveCookieRule::~BraveCookieRule() = default;
+
+BraveCookieRuleStore::BraveCookieRuleStore() = default;
+
+BraveCookieRuleStore::~BraveCookieRuleStore() = default;
+
+void BraveCookieRuleStore::ResetRules(ContentSettingsType content_type,
+                                      std::unique_ptr<RuleIterator> rules) {
+  if (content_type == ContentSettingsType::COOKIES) {
+    chromium_rules_.clear();
+    while (rules && rules->HasNext())
+      chromium_rules_.push_back(rules->Next());
+    return;
+  }
+
+  DCHECK(content_type == ContentSettingsType::BRAVE_COOKIES ||
+         content_type == ContentSettingsType::BRAVE_SHIELDS);
+  const auto old_settings = GetBraveRuleSettings();
+
+  if (content_type == ContentSettingsType::BRAVE_SHIELDS) {
+    shield_settings_.clear();
+    shield_patterns_by_host_.clear();
+    while (rules && rules->HasNext()) {
+      Rule rule = rules->Next();
+      // There is no global shields rule
+      DCHECK(!rule.primary_pattern.MatchesAllHosts());
+      SetShieldSetting(rule.primary_pattern,
+                       ValueToContentSetting(&rule.value));
+    }
+    for (auto& brave_cookie_rule : brave_cookie_rules_) {
+      brave_cookie_rule.second.active = IsActive(
+          brave_cookie_rule.first.first, brave_cookie_rule.first.second);
+    }
+  } else {
+    brave_cookie_rules_.clear();
+    brave_cookie_rules_by_host_.clear();
+    while (rules && rules->HasNext()) {
+      Rule rule = rules->Next();
+      SetBraveCookieRule({rule.primary_pattern, rule.secondary_pattern}, &rule);
+    }
+  }
+
+  const auto new_settings = GetBraveRuleSettings();
+  for (const auto& setting : new_settings) {
+    auto old_setting = old_settings.find(setting.first);
+    if (old_setting == old_settings.end() ||
+        old_setting->second != setting.second) {
+      changed_brave_rules_.insert(setting.first);
+    }
+  }
+  for (const auto& setting : old_settings) {
+    if (!base::Contains(new_settings, setting.first))
+      changed_brave_rules_.insert(setting.first);
+  }
+}
+
+void BraveCookieRuleStore::UpdateRule(
+    ContentSettingsType content_type,
+    const ContentSettingsPattern& primary_pattern,
+    const ContentSettingsPattern& secondary_pattern,
+    const Rule* rule) {
+  if (content_type == ContentSettingsType::BRAVE_SHIELDS) {
+    auto old_setting = shield_settings_.find(primary_pattern);
+    const bool was_down = old_setting != shield_settings_.end() &&
+                          old_setting->second == CONTENT_SETTING_BLOCK;
+    base::Optional<ContentSetting> setting;
+    if (rule)
+      setting = ValueToContentSetting(&rule->value);
+    SetShieldSetting(primary_pattern, setting);
+
+    if (was_down != (setting == CONTENT_SETTING_BLOCK)) {
+      changed_brave_rules_.insert(
+          {ContentSettingsPattern::Wildcard(), primary_pattern});
+    }
+    UpdateActiveBraveCookieRules(primary_pattern);
+    return;
+  }
+
+  DCHECK_EQ(content_type, ContentSettingsType::BRAVE_COOKIES);
+  const PatternPair patterns(primary_pattern, secondary_pattern);
+  // Returns the brave rule a brave cookie rule maps to, if it is active.
+  auto get_brave_rule = [this, &patterns]()
+      -> base::Optional<std::pair<PatternPair, ContentSetting>> {
+    auto it = brave_cookie_rules_.find(patterns);
+    if (it == brave_cookie_rules_.end() || !it->second.active)
+      return base::nullopt;
+    const Rule& rule = it->second.rule;
+    return std::make_pair(
+        PatternPair(rule.primary_pattern, rule.secondary_pattern),
+        ValueToContentSetting(&rule.value));
+  };
+
+  const auto old_brave_rule = get_brave_rule();
+  SetBraveCookieRule(patterns, rule);
+  const auto new_brave_rule = get_brave_rule();
+  if (old_brave_rule == new_brave_rule)
+    return;
+  if (old_brave_rule)
+    changed_brave_rules_.insert(old_brave_rule->first);
+  if (new_brave_rule)
+    changed_brave_rules_.insert(new_brave_rule->first);
+}
+
+void BraveCookieRuleStore::SetGoogleAuthRulesEnabled(bool enabled) {
+  if (google_auth_rules_enabled_ == enabled)
+    return;
+  google_auth_rules_enabled_ = enabled;
+  changed_brave_rules_.insert(
+      {ContentSettingsPattern::FromString(kGoogleAuthPattern),
+       ContentSettingsPattern::Wildcard()});
+  changed_brave_rules_.insert(
+      {ContentSettingsPattern::FromString(kFirebasePattern),
+       ContentSettingsPattern::Wildcard()});
+}
+
+base::Optional<ContentSetting> BraveCookieRuleStore::GetBraveRuleSetting(
+    const ContentSettingsPattern& primary_pattern,
+    const ContentSettingsPattern& secondary_pattern) const {
+  if (google_auth_rules_enabled_ &&
+      secondary_pattern == ContentSettingsPattern::Wildcard() &&
+      (primary_pattern ==
+           ContentSettingsPattern::FromString(kGoogleAuthPattern) ||
+       primary_pattern ==
+           ContentSettingsPattern::FromString(kFirebasePattern))) {
+    return CONTENT_SETTING_ALLOW;
+  }
+
+  // The patterns of brave cookie rules are swapped, see ReverseRule.
+  for (const auto& first_party_pattern :
+       {primary_pattern,
+        ContentSettingsPattern::FromString(kFirstPartyPattern)}) {
+    auto it = brave_cookie_rules_.find(
+        PatternPair(secondary_pattern, first_party_pattern));
+    if (it == brave_cookie_rules_.end() || !it->second.active)
+      continue;
+    const Rule& rule = it->second.rule;
+    if (rule.primary_pattern == primary_pattern &&
+        rule.secondary_pattern == secondary_pattern) {
+      return ValueToContentSetting(&rule.value);
+    }
+  }
+
+  if (primary_pattern == ContentSettingsPattern::Wildcard()) {
+    auto shield_setting = shield_settings_.find(secondary_pattern);
+    if (shield_setting != shield_settings_.end() &&
+        shield_setting->second == CONTENT_SETTING_BLOCK) {
+      return CONTENT_SETTING_ALLOW;
+    }
+  }
+
+  return base::nullopt;
+}
+
+std::vector<BraveCookieRuleStore::PatternPair>
+BraveCookieRuleStore::TakeChangedBraveRules() {
+  std::vector<PatternPair> changed_brave_rules(changed_brave_rules_.begin(),
+                                               changed_brave_rules_.end());
+  changed_brave_rules_.clear();
+  return changed_brave_rules;
+}
+
+scoped_refptr<const BraveCookieRuleStore::Rules>
+BraveCookieRuleStore::BuildRules() const {
+  std::vector<Rule> rules;
+  rules.reserve(chromium_rules_.size() + brave_cookie_rules_.size() +
+                shield_settings_.size() + 2);
+
+  // kGoogleLoginControlType preference adds an exception for
+  // accounts.google.com to access cookies in 3p context to allow login using
+  // google oauth. The exception is added before all overrides to allow google
+  // oauth to work when the user sets custom overrides for a site.
+  // For example: Google OAuth will be allowed if the user allows all cookies
+  // and sets 3p cookie blocking for a site.
+  //
+  // We also create the same exception for firebase apps, since they
+  // are tightly bound to google, and require google auth to work.
+  // See: #5075, #9852, #10367
+  if (google_auth_rules_enabled_) {
+    rules.push_back(
+        MakeAllowRule(ContentSettingsPattern::FromString(kGoogleAuthPattern),
+                      ContentSettingsPattern::Wildcard()));
+    rules.push_back(
+        MakeAllowRule(ContentSettingsPattern::FromString(kFirebasePattern),
+                      ContentSettingsPattern::Wildcard()));
+  }
+  // non-pref based exceptions should go in the cookie_settings_base.cc
+  // chromium_src override
+
+  for (const auto& rule : chromium_rules_)
+    rules.push_back(CloneRule(rule));
+
+  // brave cookies of sites with shields up
+  for (const auto& brave_cookie_rule : brave_cookie_rules_) {
+    if (brave_cookie_rule.second.active)
+      rules.push_back(CloneRule(brave_cookie_rule.second.rule));
+  }
+
+  // Adding shields down rules (they always override cookie rules).
+  for (const auto& shield_setting : shield_settings_) {
+    if (shield_setting.second == CONTENT_SETTING_BLOCK) {
+      rules.push_back(MakeAllowRule(ContentSettingsPattern::Wildcard(),
+                                    shield_setting.first));
+    }
+  }
+
+  return base::MakeRefCounted<Rules>(std::move(rules));
+}
+
+void BraveCookieRuleStore::SetShieldSetting(
+    const ContentSettingsPattern& primary_pattern,
+    base::Optional<ContentSetting> setting) {
+  const std::string host = primary_pattern.GetHost();
+  if (setting) {
+    shield_settings_[primary_pattern] = *setting;
+    shield_patterns_by_host_[host].insert(primary_pattern);
+    return;
+  }
+
+  shield_settings_.erase(primary_pattern);
+  auto patterns = shield_patterns_by_host_.find(host);
+  if (patterns == shield_patterns_by_host_.end())
+    return;
+  patterns->second.erase(primary_pattern);
+  if (patterns->second.empty())
+    shield_patterns_by_host_.erase(patterns);
+}
+
+void BraveCookieRuleStore::SetBraveCookieRule(const PatternPair& patterns,
+                                              const Rule* rule) {
+  const std::string host_key = GetReversedHostKey(patterns.first.GetHost());
+  if (!rule) {
+    if (!brave_cookie_rules_.erase(patterns))
+      return;
+    auto host_patterns = brave_cookie_rules_by_host_.find(host_key);
+    DCHECK(host_patterns != brave_cookie_rules_by_host_.end());
+    host_patterns->second.erase(patterns);
+    if (host_patterns->second.empty())
+      brave_cookie_rules_by_host_.erase(host_patterns);
+    return;
+  }
+
+  brave_cookie_rules_.erase(patterns);
+  brave_cookie_rules_.emplace(
+      patterns, BraveCookieRule(ReverseRule(*rule),
+                                IsActive(patterns.first, patterns.second)));
+  brave_cookie_rules_by_host_[host_key].insert(patterns);
+}
+
+bool BraveCookieRuleStore::IsActive(
+    const ContentSettingsPattern& primary_pattern,
+    const ContentSettingsPattern& secondary_pattern) const {
+  // don't include default rules in the iterator
+  if (primary_pattern == ContentSettingsPattern::Wildcard() &&
+      (secondary_pattern == ContentSettingsPattern::Wildcard() ||
+       secondary_pattern ==
+           ContentSettingsPattern::FromString(kFirstPartyPattern))) {
+    return false;
+  }
+
+  // The first shield pattern, in precedence order, that is identical to or a
+  // successor of |primary_pattern| decides. Only patterns for its host or one
+  // of its parent domains can be, so just those are compared.
+  // TODO(bridiver) - verify that SUCCESSOR is correct and not PREDECESSOR
+  const ContentSettingsPattern* match = nullptr;
+  std::string domain = primary_pattern.GetHost();
+  while (true) {
+    auto patterns = shield_patterns_by_host_.find(domain);
+    if (patterns != shield_patterns_by_host_.end()) {
+      for (const auto& shield_pattern : patterns->second) {
+        if (match && !(shield_pattern > *match))
+          break;
+        auto primary_compare = shield_pattern.Compare(primary_pattern);
+        if (primary_compare == ContentSettingsPattern::IDENTITY ||
+            primary_compare == ContentSettingsPattern::SUCCESSOR) {
+          match = &shield_pattern;
+          break;
+        }
+      }
+    }
+    if (domain.empty())
+      break;
+    const size_t dot = domain.find('.');
+    domain = dot == std::string::npos ? std::string() : domain.substr(dot + 1);
+  }
+
+  // TODO(bridiver) - move this logic into shields_util for allow/block
+  return !match || shield_settings_.at(*match) != CONTENT_SETTING_BLOCK;
+}
+
+void BraveCookieRuleStore::UpdateActiveBraveCookieRules(
+    const ContentSettingsPattern& shield_pattern) {
+  // Only the rules for the shield pattern's host and its subdomains can
+  // change, and those are one range of the reversed host index.
+  const std::string domain_key = GetReversedHostKey(shield_pattern.GetHost());
+  for (auto host_patterns = brave_cookie_rules_by_host_.lower_bound(domain_key);
+       host_patterns != brave_cookie_rules_by_host_.end() &&
+       base::StartsWith(host_patterns->first, domain_key,
+                        base::CompareCase::SENSITIVE);
+       ++host_patterns) {
+    for (const auto& patterns : host_patterns->second) {
+      auto brave_cookie_rule = brave_cookie_rules_.find(patterns);
+      DCHECK(brave_cookie_rule != brave_cookie_rules_.end());
+      const bool active = IsActive(patterns.first, patterns.second);
+      if (active == brave_cookie_rule->second.active)
+        continue;
+      brave_cookie_rule->second.active = active;
+      const Rule& rule = brave_cookie_rule->second.rule;
+      changed_brave_rules_.insert(
+          {rule.primary_pattern, rule.secondary_pattern});
+    }
+  }
+}
+
+std::map<BraveCookieRuleStore::PatternPair, ContentSetting>
+BraveCookieRuleStore::GetBraveRuleSettings() const {
+  std::map<PatternPair, ContentSetting> settings;
+  if (google_auth_rules_enabled_) {
+    settings.emplace(
+        PatternPair(ContentSettingsPattern::FromString(kGoogleAuthPattern),
+                    ContentSettingsPattern::Wildcard()),
+        CONTENT_SETTING_ALLOW);
+    settings.emplace(
+        PatternPair(ContentSettingsPattern::FromString(kFirebasePattern),
+                    ContentSettingsPattern::Wildcard()),
+        CONTENT_SETTING_ALLOW);
+  }
+  for (const auto& brave_cookie_rule : brave_cookie_rules_) {
+    if (!brave_cookie_rule.second.active)
+      continue;
+    const Rule& rule = brave_cookie_rule.second.rule;
+    settings.emplace(PatternPair(rule.primary_pattern, rule.secondary_pattern),
+                     ValueToContentSetting(&rule.value));
+  }
+  for (const auto& shield_setting : shield_settings_) {
+    if (shield_setting.second == CONTENT_SETTING_BLOCK) {
+      settings.emplace(
+          PatternPair(ContentSettingsPattern::Wildcard(), shield_setting.first),
+          CONTENT_SETTING_ALLOW);
+    }
+  }
+  return settings;
+}
+
+}  // namespace content_settings
@@ -0,0 +1,120 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_CONTENT_SETTINGS_CORE_BROWSER_BRAVE_COOKIE_RULE_STORE_H_
+#define BRAVE_COMPONENTS_CONTENT_SETTINGS_CORE_BROWSER_BRAVE_COOKIE_RULE_STORE_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/optional.h"
+#include "components/content_settings/core/browser/content_settings_rule.h"
+#include "components/content_settings/core/common/content_settings.h"
+#include "components/content_settings/core/common/content_settings_pattern.h"
+#include "components/content_settings/core/common/content_settings_types.h"
+
+namespace content_settings {
+
+// The rules BravePrefProvider returns for ContentSettingsType::COOKIES, which
+// combine chromium cookie settings, brave cookie settings of sites that have
+// shields up and shields down overrides. The rules each one is built from are
+// indexed by pattern so a change to one site's settings only re-evaluates the
+// rules it can affect instead of all of them.
+class BraveCookieRuleStore {
+ public:
+  using PatternPair = std::pair<ContentSettingsPattern, ContentSettingsPattern>;
+  using Rules = base::RefCountedData<std::vector<Rule>>;
+
+  BraveCookieRuleStore();
+  BraveCookieRuleStore(const BraveCookieRuleStore&) = delete;
+  BraveCookieRuleStore& operator=(const BraveCookieRuleStore&) = delete;
+  ~BraveCookieRuleStore();
+
+  // Replaces every rule of |content_type|, which is one of COOKIES,
+  // BRAVE_COOKIES or BRAVE_SHIELDS.
+  void ResetRules(ContentSettingsType content_type,
+                  std::unique_ptr<RuleIterator> rules);
+  // Replaces the BRAVE_COOKIES or BRAVE_SHIELDS rule for |primary_pattern| and
+  // |secondary_pattern| with |rule|, or removes it if |rule| is null.
+  void UpdateRule(ContentSettingsType content_type,
+                  const ContentSettingsPattern& primary_pattern,
+                  const ContentSettingsPattern& secondary_pattern,
+                  const Rule* rule);
+  void SetGoogleAuthRulesEnabled(bool enabled);
+
+  // Returns the setting of the brave rule that maps to the COOKIES rule for
+  // |primary_pattern| and |secondary_pattern|, if there is one.
+  base::Optional<ContentSetting> GetBraveRuleSetting(
+      const ContentSettingsPattern& primary_pattern,
+      const ContentSettingsPattern& secondary_pattern) const;
+
+  // Returns the patterns of the brave rules, as COOKIES rules, that were
+  // added, changed or removed since the last call.
+  std::vector<PatternPair> TakeChangedBraveRules();
+
+  // Builds the COOKIES rules in precedence order. The result is never
+  // modified, so it can be shared by every iterator handed out until the next
+  // change.
+  scoped_refptr<const Rules> BuildRules() const;
+
+ private:
+  // Brave cookie rules are keyed by their patterns as stored in prefs, which
+  // puts the first party in the primary pattern.
+  struct BraveCookieRule {
+    BraveCookieRule(Rule rule, bool active);
+    BraveCookieRule(BraveCookieRule&&);
+    BraveCookieRule& operator=(BraveCookieRule&&);
+    ~BraveCookieRule();
+
+    // The rule as a COOKIES rule, with its patterns swapped.
+    Rule rule;
+    // Whether shields are up for its site.
+    bool active;
+  };
+
+  // Sorted with the highest precedence first, the order PrefProvider iterates
+  // rules in.
+  using ShieldSettings = std::map<ContentSettingsPattern,
+                                  ContentSetting,
+                                  std::greater<ContentSettingsPattern>>;
+  using ShieldPatterns =
+      std::set<ContentSettingsPattern, std::greater<ContentSettingsPattern>>;
+  using BraveCookieRules =
+      std::map<PatternPair, BraveCookieRule, std::greater<PatternPair>>;
+
+  void SetShieldSetting(const ContentSettingsPattern& primary_pattern,
+                        base::Optional<ContentSetting> setting);
+  void SetBraveCookieRule(const PatternPair& patterns, const Rule* rule);
+  bool IsActive(const ContentSettingsPattern& primary_pattern,
+                const ContentSettingsPattern& secondary_pattern) const;
+  // Re-evaluates the brave cookie rules a change to the shield setting for
+  // |shield_pattern| can affect.
+  void UpdateActiveBraveCookieRules(
+      const ContentSettingsPattern& shield_pattern);
+  // Every brave rule as a COOKIES rule, used to diff full reloads.
+  std::map<PatternPair, ContentSetting> GetBraveRuleSettings() const;
+
+  bool google_auth_rules_enabled_ = false;
+  std::vector<Rule> chromium_rules_;
+  BraveCookieRules brave_cookie_rules_;
+  // The brave cookie rule patterns by the reversed host of their primary
+  // pattern, so the rules for a domain and its subdomains are one range.
+  std::map<std::string, std::set<PatternPair>> brave_cookie_rules_by_host_;
+  // Shield settings by primary pattern, and the primary patterns by host so
+  // the ones that can apply to a cookie rule are found without a full scan.
+  ShieldSettings shield_settings_;
+  std::map<std::string, ShieldPatterns> shield_patterns_by_host_;
+  std::set<PatternPair> changed_brave_rules_;
+};
+
+}  // namespace content_settings
+
+#endif  // BRAVE_COMPONENTS_CONTENT_SETTINGS_CORE_BROWSER_BRAVE_COOKIE_RULE_STORE_H_
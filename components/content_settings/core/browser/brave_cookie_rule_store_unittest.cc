@@ -0,0 +1,190 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/content_settings/core/browser/brave_cookie_rule_store.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/rand_util.h"
+#include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "components/content_settings/core/common/content_settings_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace content_settings {
+
+namespace {
+
+constexpr size_t kRandomUpdates = 2000;
+
+// Hosts that are parent domains of each other, so shields changes reach
+// rules of subdomains, and one that only shares a suffix with them.
+const char* const kHosts[] = {"a.com", "b.a.com", "c.b.a.com", "ba.com",
+                              "d.org"};
+
+using PatternPair = BraveCookieRuleStore::PatternPair;
+// The rules of one content type as they would be stored in prefs.
+using RuleMap = std::map<PatternPair, ContentSetting>;
+
+class VectorRuleIterator : public RuleIterator {
+ public:
+  explicit VectorRuleIterator(const RuleMap& rules) {
+    for (const auto& rule : rules) {
+      rules_.emplace_back(rule.first.first, rule.first.second,
+                          base::Value::FromUniquePtrValue(
+                              ContentSettingToValue(rule.second)),
+                          base::Time(), SessionModel::Durable);
+    }
+    iterator_ = rules_.begin();
+  }
+
+  bool HasNext() const override { return iterator_ != rules_.end(); }
+
+  Rule Next() override { return std::move(*(iterator_++)); }
+
+ private:
+  std::vector<Rule> rules_;
+  std::vector<Rule>::iterator iterator_;
+
+  DISALLOW_COPY_AND_ASSIGN(VectorRuleIterator);
+};
+
+ContentSettingsPattern SitePattern(const std::string& host) {
+  return ContentSettingsPattern::FromString("[*.]" + host);
+}
+
+ContentSettingsPattern RandomSitePattern() {
+  return SitePattern(
+      kHosts[base::RandInt(0, static_cast<int>(base::size(kHosts)) - 1)]);
+}
+
+base::Optional<ContentSetting> RandomSetting() {
+  switch (base::RandInt(0, 2)) {
+    case 0:
+      return CONTENT_SETTING_ALLOW;
+    case 1:
+      return CONTENT_SETTING_BLOCK;
+    default:
+      return base::nullopt;
+  }
+}
+
+std::vector<std::string> Describe(
+    const scoped_refptr<const BraveCookieRuleStore::Rules>& rules) {
+  std::vector<std::string> descriptions;
+  for (const auto& rule : rules->data) {
+    descriptions.push_back(base::StringPrintf(
+        "%s %s %d", rule.primary_pattern.ToString().c_str(),
+        rule.secondary_pattern.ToString().c_str(),
+        ValueToContentSetting(&rule.value)));
+  }
+  return descriptions;
+}
+
+std::vector<PatternPair> TakeSortedChanges(BraveCookieRuleStore* store) {
+  auto changes = store->TakeChangedBraveRules();
+  std::sort(changes.begin(), changes.end());
+  return changes;
+}
+
+}  // namespace
+
+// Applying changes one at a time has to give the same rules, and report the
+// same changed rules, as reading every rule of the changed type again.
+TEST(BraveCookieRuleStoreTest, UpdateRuleMatchesResetRules) {
+  BraveCookieRuleStore updated_store;
+  BraveCookieRuleStore reset_store;
+  std::map<ContentSettingsType, RuleMap> prefs;
+
+  for (size_t i = 0; i < kRandomUpdates; ++i) {
+    const ContentSettingsType content_type =
+        base::RandInt(0, 1) ? ContentSettingsType::BRAVE_COOKIES
+                            : ContentSettingsType::BRAVE_SHIELDS;
+    // There is no global shields rule.
+    ContentSettingsPattern primary_pattern = RandomSitePattern();
+    ContentSettingsPattern secondary_pattern =
+        ContentSettingsPattern::Wildcard();
+    if (content_type == ContentSettingsType::BRAVE_COOKIES) {
+      if (base::RandInt(0, 4) == 0)
+        primary_pattern = ContentSettingsPattern::Wildcard();
+      if (base::RandInt(0, 1)) {
+        secondary_pattern =
+            ContentSettingsPattern::FromString("https://firstParty/*");
+      }
+    }
+    const base::Optional<ContentSetting> setting = RandomSetting();
+    SCOPED_TRACE(base::StringPrintf(
+        "update %zu: type %d %s %s %d", i, static_cast<int>(content_type),
+        primary_pattern.ToString().c_str(),
+        secondary_pattern.ToString().c_str(),
+        setting.value_or(CONTENT_SETTING_DEFAULT)));
+
+    const PatternPair patterns(primary_pattern, secondary_pattern);
+    RuleMap& rules = prefs[content_type];
+    if (setting) {
+      rules[patterns] = *setting;
+      const Rule rule(
+          primary_pattern, secondary_pattern,
+          base::Value::FromUniquePtrValue(ContentSettingToValue(*setting)),
+          base::Time(), SessionModel::Durable);
+      updated_store.UpdateRule(content_type, primary_pattern,
+                               secondary_pattern, &rule);
+    } else {
+      rules.erase(patterns);
+      updated_store.UpdateRule(content_type, primary_pattern,
+                               secondary_pattern, nullptr);
+    }
+    reset_store.ResetRules(content_type,
+                           std::make_unique<VectorRuleIterator>(rules));
+
+    ASSERT_EQ(Describe(reset_store.BuildRules()),
+              Describe(updated_store.BuildRules()));
+    ASSERT_EQ(TakeSortedChanges(&reset_store),
+              TakeSortedChanges(&updated_store));
+  }
+}
+
+TEST(BraveCookieRuleStoreTest, ShieldsDownAppliesToSubdomainRules) {
+  BraveCookieRuleStore store;
+  const Rule block_rule(
+      SitePattern("b.a.com"), ContentSettingsPattern::Wildcard(),
+      base::Value::FromUniquePtrValue(
+          ContentSettingToValue(CONTENT_SETTING_BLOCK)),
+      base::Time(), SessionModel::Durable);
+  store.UpdateRule(ContentSettingsType::BRAVE_COOKIES,
+                   block_rule.primary_pattern, block_rule.secondary_pattern,
+                   &block_rule);
+  EXPECT_EQ(CONTENT_SETTING_BLOCK,
+            store.GetBraveRuleSetting(ContentSettingsPattern::Wildcard(),
+                                      SitePattern("b.a.com")));
+  store.TakeChangedBraveRules();
+
+  // Shields down for the parent domain deactivates the subdomain's rule.
+  const Rule shields_down_rule(
+      SitePattern("a.com"), ContentSettingsPattern::Wildcard(),
+      base::Value::FromUniquePtrValue(
+          ContentSettingToValue(CONTENT_SETTING_BLOCK)),
+      base::Time(), SessionModel::Durable);
+  store.UpdateRule(ContentSettingsType::BRAVE_SHIELDS,
+                   shields_down_rule.primary_pattern,
+                   shields_down_rule.secondary_pattern, &shields_down_rule);
+  EXPECT_EQ(base::nullopt,
+            store.GetBraveRuleSetting(ContentSettingsPattern::Wildcard(),
+                                      SitePattern("b.a.com")));
+  std::vector<PatternPair> expected_changes = {
+      {ContentSettingsPattern::Wildcard(), SitePattern("a.com")},
+      {ContentSettingsPattern::Wildcard(), SitePattern("b.a.com")}};
+  std::sort(expected_changes.begin(), expected_changes.end());
+  EXPECT_EQ(expected_changes, TakeSortedChanges(&store));
+}
+
+}  // namespace content_settings
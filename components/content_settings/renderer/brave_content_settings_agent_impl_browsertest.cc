@@ -3,8 +3,12 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this file,
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <vector>
+
 #include "base/feature_list.h"
 #include "base/path_service.h"
+#include "base/strings/string_piece.h"
+#include "base/timer/elapsed_timer.h"
 #include "brave/browser/brave_content_browser_client.h"
 #include "brave/common/brave_paths.h"
 #include "brave/components/brave_shields/browser/brave_shields_util.h"
@@ -24,12 +28,15 @@
 #include "content/public/test/browser_test.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
+#include "crypto/hmac.h"
 #include "net/base/features.h"
 #include "net/dns/mock_host_resolver.h"
 #include "net/http/http_request_headers.h"
 #include "net/test/embedded_test_server/default_handlers.h"
 #include "net/test/embedded_test_server/http_request.h"
 #include "testing/gmock/include/gmock/gmock.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/boringssl/src/include/openssl/siphash.h"
 
 using brave_shields::ControlType;
 
@@ -55,6 +62,50 @@ const char kGetImageDataScript[] =
     "domAutomationController.send(ctx.getImageData(0, 0, canvas.width, "
     "canvas.height).data.reduce(adder));";
 
+// Average milliseconds per getImageData() of an unchanged 4K canvas.
+const char kGetImageData4KPerfScript[] = R"((function() {
+  const iterations = 10;
+  const canvas = document.createElement('canvas');
+  canvas.width = 3840;
+  canvas.height = 2160;
+  const ctx = canvas.getContext('2d');
+  ctx.fillStyle = '#808080';
+  ctx.fillRect(0, 0, canvas.width, canvas.height);
+  ctx.fillText('Brave', 10, 50);
+  const start = performance.now();
+  for (let i = 0; i < iterations; i++)
+    ctx.getImageData(0, 0, canvas.width, canvas.height);
+  return (performance.now() - start) / iterations;
+})())";
+
+// Whether changing one pixel of a canvas too large to be HMACed whole moves
+// the farbling noise everywhere else in it. Pixel (1, 0) is skipped when
+// comparing, since it differs by construction.
+const char kLargeCanvasNoiseScript[] = R"((function() {
+  function noise(changePixel) {
+    const canvas = document.createElement('canvas');
+    canvas.width = 512;
+    canvas.height = 512;
+    const ctx = canvas.getContext('2d');
+    ctx.fillStyle = '#808080';
+    ctx.fillRect(0, 0, canvas.width, canvas.height);
+    if (changePixel) {
+      ctx.fillStyle = '#000000';
+      ctx.fillRect(1, 0, 1, 1);
+    }
+    const data = ctx.getImageData(0, 0, canvas.width, canvas.height).data;
+    const flipped = [];
+    for (let i = 0; i < data.length; i++) {
+      if ((i < 4 || i >= 8) && i % 4 != 3 && data[i] != 0x80)
+        flipped.push(i);
+    }
+    return flipped.join(',');
+  }
+  const unchanged = noise(false);
+  return unchanged != '' && unchanged == noise(false) &&
+      unchanged != noise(true);
+})())";
+
 const int kExpectedImageDataHashFarblingBalanced = 204;
 const int kExpectedImageDataHashFarblingOff = 0;
 const int kExpectedImageDataHashFarblingMaximum =
@@ -471,6 +522,74 @@ IN_PROC_BROWSER_TEST_F(BraveContentSettingsAgentImplBrowserTest,
   EXPECT_EQ(kExpectedImageDataHashFarblingOff, hash);
 }
 
+IN_PROC_BROWSER_TEST_F(BraveContentSettingsAgentImplBrowserTest,
+                       FarbleGetImageDataLargeCanvasUsesEveryPixel) {
+  NavigateToPageWithIframe();
+  EXPECT_EQ(true, EvalJs(contents(), kLargeCanvasNoiseScript));
+}
+
+IN_PROC_BROWSER_TEST_F(BraveContentSettingsAgentImplBrowserTest,
+                       FarbleGetImageData4KPerf) {
+  perf_test::PerfResultReporter reporter("CanvasFarbling", "4K");
+  reporter.RegisterImportantMetric(".getImageData.off", "ms");
+  reporter.RegisterImportantMetric(".getImageData.balanced", "ms");
+
+  NavigateToPageWithIframe();
+  auto balanced = EvalJs(contents(), kGetImageData4KPerfScript);
+  ASSERT_TRUE(balanced.error.empty());
+  reporter.AddResult(".getImageData.balanced", balanced.value.GetDouble());
+
+  AllowFingerprinting();
+  NavigateToPageWithIframe();
+  auto off = EvalJs(contents(), kGetImageData4KPerfScript);
+  ASSERT_TRUE(off.error.empty());
+  reporter.AddResult(".getImageData.off", off.value.GetDouble());
+}
+
+// Cost of deriving the farbling key of a 4K canvas. It used to be an
+// HMAC-SHA256 over every pixel, and is now an HMAC over a SipHash digest of
+// them. Only the key derivation is timed, as in BraveSessionCache.
+TEST(CanvasFarblingKeyPerfTest, SipHashAgainstHmacSha256) {
+  constexpr int kIterations = 10;
+  const std::vector<uint8_t> pixels(3840 * 2160 * 4, 0x80);
+  const uint64_t hmac_key = 0x0123456789abcdef;
+  const uint64_t siphash_key[2] = {0x0123456789abcdef, 0xfedcba9876543210};
+  uint8_t canvas_key[32];
+
+  base::ElapsedTimer hmac_sha256_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    crypto::HMAC h(crypto::HMAC::SHA256);
+    ASSERT_TRUE(h.Init(reinterpret_cast<const unsigned char*>(&hmac_key),
+                       sizeof hmac_key));
+    ASSERT_TRUE(h.Sign(
+        base::StringPiece(reinterpret_cast<const char*>(pixels.data()),
+                          pixels.size()),
+        canvas_key, sizeof canvas_key));
+  }
+  const double hmac_sha256_ms =
+      hmac_sha256_timer.Elapsed().InMillisecondsF() / kIterations;
+
+  base::ElapsedTimer siphash_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    crypto::HMAC h(crypto::HMAC::SHA256);
+    ASSERT_TRUE(h.Init(reinterpret_cast<const unsigned char*>(&hmac_key),
+                       sizeof hmac_key));
+    const uint64_t message[] = {
+        pixels.size(), SIPHASH_24(siphash_key, pixels.data(), pixels.size())};
+    ASSERT_TRUE(h.Sign(base::StringPiece(reinterpret_cast<const char*>(message),
+                                         sizeof message),
+                       canvas_key, sizeof canvas_key));
+  }
+  const double siphash_ms =
+      siphash_timer.Elapsed().InMillisecondsF() / kIterations;
+
+  perf_test::PerfResultReporter reporter("CanvasFarbling", "4K");
+  reporter.RegisterImportantMetric(".canvas_key.hmac_sha256", "ms");
+  reporter.RegisterImportantMetric(".canvas_key.siphash", "ms");
+  reporter.AddResult(".canvas_key.hmac_sha256", hmac_sha256_ms);
+  reporter.AddResult(".canvas_key.siphash", siphash_ms);
+}
+
 class BraveContentSettingsAgentImplV2BrowserTest
     : public BraveContentSettingsAgentImplBrowserTest {
  public:
@@ -7,7 +7,6 @@
 
 #include <utility>
 
-#include "base/json/json_reader.h"
 #include "base/optional.h"
 #include "base/values.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
@@ -16,6 +15,69 @@
 
 namespace cosmetic_filters {
 
+namespace {
+
+// The ad block engine answers in JSON, which AdBlockService has already
+// parsed. Everything past this point uses the typed mojom results.
+std::vector<std::string> StringsFromList(const base::Value* list) {
+  std::vector<std::string> strings;
+  if (!list || !list->is_list())
+    return strings;
+  for (const auto& item : list->GetList()) {
+    if (item.is_string())
+      strings.push_back(item.GetString());
+  }
+  return strings;
+}
+
+// Returns the selectors along with the engine generation they were computed
+// against.
+std::pair<std::vector<std::string>, uint64_t>
+HiddenClassIdSelectorsOnTaskRunner(
+    brave_shields::AdBlockService* ad_block_service,
+    const std::vector<std::string>& classes,
+    const std::vector<std::string>& ids,
+    const std::vector<std::string>& exceptions) {
+  // Engines only change on this task runner, so the generation can't move on
+  // while they are queried.
+  const uint64_t generation =
+      brave_shields::AdBlockBaseService::GetEngineGeneration();
+  base::Optional<base::Value> selectors =
+      ad_block_service->HiddenClassIdSelectors(classes, ids, exceptions);
+  return std::make_pair(StringsFromList(selectors ? &*selectors : nullptr),
+                        generation);
+}
+
+mojom::UrlCosmeticResourcesPtr UrlCosmeticResourcesOnTaskRunner(
+    brave_shields::AdBlockService* ad_block_service,
+    const std::string& url) {
+  base::Optional<base::Value> resources =
+      ad_block_service->UrlCosmeticResources(url);
+  if (!resources || !resources->is_dict())
+    return nullptr;
+
+  auto result = mojom::UrlCosmeticResources::New();
+  result->hide_selectors =
+      StringsFromList(resources->FindListKey("hide_selectors"));
+  result->force_hide_selectors =
+      StringsFromList(resources->FindListKey("force_hide_selectors"));
+  const base::Value* style_selectors =
+      resources->FindDictKey("style_selectors");
+  if (style_selectors) {
+    for (const auto& item : style_selectors->DictItems())
+      result->style_selectors[item.first] = StringsFromList(&item.second);
+  }
+  result->exceptions = StringsFromList(resources->FindListKey("exceptions"));
+  const std::string* injected_script =
+      resources->FindStringKey("injected_script");
+  if (injected_script)
+    result->injected_script = *injected_script;
+  result->generichide = resources->FindBoolKey("generichide").value_or(false);
+  return result;
+}
+
+}  // namespace
+
 CosmeticFiltersResources::CosmeticFiltersResources(
     HostContentSettingsMap* settings_map,
     brave_shields::AdBlockService* ad_block_service)
@@ -26,46 +88,13 @@ CosmeticFiltersResources::CosmeticFiltersResources(
 CosmeticFiltersResources::~CosmeticFiltersResources() {}
 
 void CosmeticFiltersResources::HiddenClassIdSelectors(
-    const std::string& input,
+    const std::vector<std::string>& classes,
+    const std::vector<std::string>& ids,
     const std::vector<std::string>& exceptions,
     HiddenClassIdSelectorsCallback callback) {
-  base::Optional<base::Value> input_value = base::JSONReader::Read(input);
-  if (!input_value || !input_value->is_dict()) {
-    // Nothing to work with
-    std::move(callback).Run(base::Value());
-
-    return;
-  }
-  base::DictionaryValue* input_dict;
-  if (!input_value->GetAsDictionary(&input_dict)) {
-    std::move(callback).Run(base::Value());
-
-    return;
-  }
-  std::vector<std::string> classes;
-  base::ListValue* classes_list;
-  if (input_dict->GetList("classes", &classes_list)) {
-    for (size_t i = 0; i < classes_list->GetSize(); i++) {
-      if (!classes_list->GetList()[i].is_string()) {
-        continue;
-      }
-      classes.push_back(classes_list->GetList()[i].GetString());
-    }
-  }
-  std::vector<std::string> ids;
-  base::ListValue* ids_list;
-  if (input_dict->GetList("ids", &ids_list)) {
-    for (size_t i = 0; i < ids_list->GetSize(); i++) {
-      if (!ids_list->GetList()[i].is_string()) {
-        continue;
-      }
-      ids.push_back(ids_list->GetList()[i].GetString());
-    }
-  }
-
   ad_block_service_->GetTaskRunner()->PostTaskAndReplyWithResult(
       FROM_HERE,
-      base::BindOnce(&brave_shields::AdBlockService::HiddenClassIdSelectors,
+      base::BindOnce(&HiddenClassIdSelectorsOnTaskRunner,
                      base::Unretained(ad_block_service_), classes, ids,
                      exceptions),
       base::BindOnce(&CosmeticFiltersResources::HiddenClassIdSelectorsOnUI,
@@ -74,16 +103,14 @@ void CosmeticFiltersResources::HiddenClassIdSelectors(
 
 void CosmeticFiltersResources::HiddenClassIdSelectorsOnUI(
     HiddenClassIdSelectorsCallback callback,
-    base::Optional<base::Value> resources) {
-  std::move(callback).Run(resources ? std::move(resources.value())
-                                    : base::Value());
+    std::pair<std::vector<std::string>, uint64_t> result) {
+  std::move(callback).Run(std::move(result.first), result.second);
 }
 
 void CosmeticFiltersResources::UrlCosmeticResourcesOnUI(
     UrlCosmeticResourcesCallback callback,
-    base::Optional<base::Value> resources) {
-  std::move(callback).Run(resources ? std::move(resources.value())
-                                    : base::Value());
+    mojom::UrlCosmeticResourcesPtr resources) {
+  std::move(callback).Run(std::move(resources));
 }
 
 void CosmeticFiltersResources::ShouldDoCosmeticFiltering(
@@ -102,7 +129,7 @@ void CosmeticFiltersResources::UrlCosmeticResources(
     UrlCosmeticResourcesCallback callback) {
   ad_block_service_->GetTaskRunner()->PostTaskAndReplyWithResult(
       FROM_HERE,
-      base::BindOnce(&brave_shields::AdBlockService::UrlCosmeticResources,
+      base::BindOnce(&UrlCosmeticResourcesOnTaskRunner,
                      base::Unretained(ad_block_service_), url),
       base::BindOnce(&CosmeticFiltersResources::UrlCosmeticResourcesOnUI,
                      weak_factory_.GetWeakPtr(), std::move(callback)));
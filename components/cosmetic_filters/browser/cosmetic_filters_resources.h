@@ -6,13 +6,14 @@
 #ifndef BRAVE_COMPONENTS_COSMETIC_FILTERS_BROWSER_COSMETIC_FILTERS_RESOURCES_H_
 #define BRAVE_COMPONENTS_COSMETIC_FILTERS_BROWSER_COSMETIC_FILTERS_RESOURCES_H_
 
+#include <stdint.h>
+
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/memory/weak_ptr.h"
-#include "base/optional.h"
-#include "base/values.h"
 #include "brave/components/cosmetic_filters/common/cosmetic_filters.mojom.h"
 
 class HostContentSettingsMap;
@@ -43,7 +44,8 @@ class CosmeticFiltersResources final
 
   // Sends back to renderer a response about rules that has to be applied
   // for the specified selectors.
-  void HiddenClassIdSelectors(const std::string& input,
+  void HiddenClassIdSelectors(const std::vector<std::string>& classes,
+                              const std::vector<std::string>& ids,
                               const std::vector<std::string>& exceptions,
                               HiddenClassIdSelectorsCallback callback) override;
 
@@ -53,11 +55,12 @@ class CosmeticFiltersResources final
                             UrlCosmeticResourcesCallback callback) override;
 
  private:
-  void HiddenClassIdSelectorsOnUI(HiddenClassIdSelectorsCallback callback,
-                                  base::Optional<base::Value> resources);
+  void HiddenClassIdSelectorsOnUI(
+      HiddenClassIdSelectorsCallback callback,
+      std::pair<std::vector<std::string>, uint64_t> result);
 
   void UrlCosmeticResourcesOnUI(UrlCosmeticResourcesCallback callback,
-                                base::Optional<base::Value> resources);
+                                mojom::UrlCosmeticResourcesPtr resources);
 
   HostContentSettingsMap* settings_map_;             // Not owned
   brave_shields::AdBlockService* ad_block_service_;  // Not owned
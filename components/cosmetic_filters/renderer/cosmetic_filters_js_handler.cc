@@ -8,7 +8,9 @@
 #include <utility>
 
 #include "base/bind.h"
-#include "base/json/json_writer.h"
+#include "base/containers/flat_map.h"
+#include "base/json/string_escape.h"
+#include "base/metrics/histogram_macros.h"
 #include "base/no_destructor.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
@@ -153,6 +155,15 @@ const char kStyleSelectorsInjectScript[] =
           };
         })();)";
 
+// content_cosmetic.ts only sends names it hasn't asked about before, so it
+// has to forget them when the answers may have changed.
+const char kResetQueriedIdentifiersScript[] =
+    R"((function() {
+          if (window.content_cosmetic.resetQueriedIdentifiers) {
+            window.content_cosmetic.resetQueriedIdentifiers();
+          }
+        })();)";
+
 std::string LoadDataResource(const int id) {
   auto& resource_bundle = ui::ResourceBundle::GetSharedInstance();
   if (resource_bundle.IsGzipped(id)) {
@@ -162,6 +173,32 @@ std::string LoadDataResource(const int id) {
   return resource_bundle.GetRawDataResource(id).as_string();
 }
 
+// Selectors are embedded in the injected scripts as JS literals.
+std::string ToJSArray(const std::vector<std::string>& strings) {
+  std::string result = "[";
+  for (size_t i = 0; i < strings.size(); ++i) {
+    if (i > 0)
+      result += ",";
+    base::EscapeJSONString(strings[i], true, &result);
+  }
+  result += "]";
+  return result;
+}
+
+std::string ToJSObject(
+    const base::flat_map<std::string, std::vector<std::string>>& map) {
+  std::string result = "{";
+  for (const auto& item : map) {
+    if (result.size() > 1)
+      result += ",";
+    base::EscapeJSONString(item.first, true, &result);
+    result += ":";
+    result += ToJSArray(item.second);
+  }
+  result += "}";
+  return result;
+}
+
 bool IsVettedSearchEngine(const GURL& url) {
   std::string domain_and_registry =
       net::registry_controlled_domains::GetDomainAndRegistry(
@@ -197,15 +234,22 @@ CosmeticFiltersJSHandler::CosmeticFiltersJSHandler(
   EnsureConnected();
 }
 
-CosmeticFiltersJSHandler::~CosmeticFiltersJSHandler() = default;
+CosmeticFiltersJSHandler::~CosmeticFiltersJSHandler() {
+  ResetQueriedIdentifiers();
+}
 
 void CosmeticFiltersJSHandler::HiddenClassIdSelectors(
-    const std::string& input) {
-  if (!EnsureConnected())
+    const std::vector<std::string>& classes,
+    const std::vector<std::string>& ids,
+    int deduplicated_count) {
+  if (deduplicated_count > 0)
+    deduplicated_identifiers_count_ += deduplicated_count;
+  if ((classes.empty() && ids.empty()) || !EnsureConnected())
     return;
+  queried_identifiers_count_ += classes.size() + ids.size();
 
   cosmetic_filters_resources_->HiddenClassIdSelectors(
-      input, exceptions_,
+      classes, ids, exceptions_,
       base::BindOnce(&CosmeticFiltersJSHandler::OnHiddenClassIdSelectors,
                      base::Unretained(this)));
 }
@@ -276,8 +320,10 @@ bool CosmeticFiltersJSHandler::EnsureConnected() {
 
 void CosmeticFiltersJSHandler::ProcessURL(const GURL& url,
                                           base::OnceClosure callback) {
-  resources_dict_.reset();
+  resources_.reset();
+  ResetQueriedIdentifiers();
   url_ = url;
+  process_url_time_ = base::TimeTicks::Now();
   // Trivially, don't make exceptions for malformed URLs.
   if (!EnsureConnected() || url_.is_empty() || !url_.is_valid())
     return;
@@ -304,25 +350,20 @@ void CosmeticFiltersJSHandler::OnShouldDoCosmeticFiltering(
 
 void CosmeticFiltersJSHandler::OnUrlCosmeticResources(
     base::OnceClosure callback,
-    base::Value result) {
-  resources_dict_ = base::DictionaryValue::From(
-      base::Value::ToUniquePtrValue(std::move(result)));
+    mojom::UrlCosmeticResourcesPtr resources) {
+  resources_ = std::move(resources);
   std::move(callback).Run();
 }
 
 void CosmeticFiltersJSHandler::ApplyRules() {
   blink::WebLocalFrame* web_frame = render_frame_->GetWebFrame();
-  if (!resources_dict_ || web_frame->IsProvisional())
+  if (!resources_ || web_frame->IsProvisional())
     return;
 
-  std::string scriptlet_script;
-  base::Value* injected_script = resources_dict_->FindPath("injected_script");
-  if (injected_script &&
-      base::JSONWriter::Write(*injected_script, &scriptlet_script)) {
-    scriptlet_script =
-        base::StringPrintf(kScriptletInitScript, scriptlet_script.c_str());
-  }
-  if (!scriptlet_script.empty()) {
+  if (!resources_->injected_script.empty()) {
+    const std::string scriptlet_script = base::StringPrintf(
+        kScriptletInitScript,
+        base::GetQuotedJSONString(resources_->injected_script).c_str());
     web_frame->ExecuteScriptInIsolatedWorld(
         isolated_world_id_, blink::WebString::FromUTF8(scriptlet_script));
   }
@@ -330,11 +371,9 @@ void CosmeticFiltersJSHandler::ApplyRules() {
     return;
 
   // Working on css rules, we do that on a main frame only
-  bool generichide = false;
-  resources_dict_->GetBoolean("generichide", &generichide);
   std::string cosmetic_filtering_init_script = base::StringPrintf(
       kCosmeticFilteringInitScript, enabled_1st_party_cf_ ? "true" : "false",
-      generichide ? "true" : "false");
+      resources_->generichide ? "true" : "false");
   std::string pre_init_script = base::StringPrintf(
       kPreInitScript, cosmetic_filtering_init_script.c_str());
 
@@ -343,74 +382,46 @@ void CosmeticFiltersJSHandler::ApplyRules() {
   web_frame->ExecuteScriptInIsolatedWorld(
       isolated_world_id_, blink::WebString::FromUTF8(*g_observing_script));
 
-  CSSRulesRoutine(resources_dict_.get());
+  CSSRulesRoutine(*resources_);
+  UMA_HISTOGRAM_TIMES("Brave.CosmeticFilters.CommitToStylesheetInjection",
+                      base::TimeTicks::Now() - process_url_time_);
 }
 
 void CosmeticFiltersJSHandler::CSSRulesRoutine(
-    base::DictionaryValue* resources_dict) {
+    const mojom::UrlCosmeticResources& resources) {
   // Otherwise, if its a vetted engine AND we're not in aggressive
   // mode, also don't do cosmetic filtering.
   if (!enabled_1st_party_cf_ && IsVettedSearchEngine(url_))
     return;
 
   blink::WebLocalFrame* web_frame = render_frame_->GetWebFrame();
-  base::ListValue* cf_exceptions_list;
-  if (resources_dict->GetList("exceptions", &cf_exceptions_list)) {
-    for (size_t i = 0; i < cf_exceptions_list->GetSize(); i++) {
-      exceptions_.push_back(cf_exceptions_list->GetList()[i].GetString());
-    }
-  }
-  base::ListValue* hide_selectors_list;
-  if (!resources_dict->GetList("hide_selectors", &hide_selectors_list)) {
-    hide_selectors_list = nullptr;
-  }
-  base::ListValue* force_hide_selectors_list;
-  if (!resources_dict->GetList("force_hide_selectors",
-                               &force_hide_selectors_list)) {
-    force_hide_selectors_list = nullptr;
-  }
+  exceptions_.insert(exceptions_.end(), resources.exceptions.begin(),
+                     resources.exceptions.end());
 
-  if (hide_selectors_list && hide_selectors_list->GetSize() != 0) {
-    std::string json_selectors;
-    if (!base::JSONWriter::Write(*hide_selectors_list, &json_selectors) ||
-        json_selectors.empty()) {
-      json_selectors = "[]";
-    }
+  if (!resources.hide_selectors.empty()) {
     // Building a script for stylesheet modifications
     std::string new_selectors_script =
-        base::StringPrintf(kHideSelectorsInjectScript, json_selectors.c_str());
+        base::StringPrintf(kHideSelectorsInjectScript,
+                           ToJSArray(resources.hide_selectors).c_str());
     web_frame->ExecuteScriptInIsolatedWorld(
         isolated_world_id_, blink::WebString::FromUTF8(new_selectors_script));
   }
 
-  if (force_hide_selectors_list && force_hide_selectors_list->GetSize() != 0) {
-    std::string json_selectors;
-    if (!base::JSONWriter::Write(*force_hide_selectors_list, &json_selectors) ||
-        json_selectors.empty()) {
-      json_selectors = "[]";
-    }
+  if (!resources.force_hide_selectors.empty()) {
     // Building a script for stylesheet modifications
-    std::string new_selectors_script = base::StringPrintf(
-        kForceHideSelectorsInjectScript, json_selectors.c_str());
+    std::string new_selectors_script =
+        base::StringPrintf(kForceHideSelectorsInjectScript,
+                           ToJSArray(resources.force_hide_selectors).c_str());
     web_frame->ExecuteScriptInIsolatedWorld(
         isolated_world_id_, blink::WebString::FromUTF8(new_selectors_script));
   }
 
-  base::DictionaryValue* style_selectors_dictionary = nullptr;
-  if (resources_dict->GetDictionary("style_selectors",
-                                    &style_selectors_dictionary)) {
-    std::string json_selectors;
-    if (!base::JSONWriter::Write(*style_selectors_dictionary,
-                                 &json_selectors) ||
-        json_selectors.empty()) {
-      json_selectors = "[]";
-    }
+  if (!resources.style_selectors.empty()) {
     std::string new_selectors_script =
-        base::StringPrintf(kStyleSelectorsInjectScript, json_selectors.c_str());
-    if (!json_selectors.empty()) {
-      web_frame->ExecuteScriptInIsolatedWorld(
-          isolated_world_id_, blink::WebString::FromUTF8(new_selectors_script));
-    }
+        base::StringPrintf(kStyleSelectorsInjectScript,
+                           ToJSObject(resources.style_selectors).c_str());
+    web_frame->ExecuteScriptInIsolatedWorld(
+        isolated_world_id_, blink::WebString::FromUTF8(new_selectors_script));
   }
 
   if (!enabled_1st_party_cf_) {
@@ -419,33 +430,47 @@ void CosmeticFiltersJSHandler::CSSRulesRoutine(
   }
 }
 
-void CosmeticFiltersJSHandler::OnHiddenClassIdSelectors(base::Value result) {
+void CosmeticFiltersJSHandler::ResetQueriedIdentifiers() {
+  if (queried_identifiers_count_ > 0 || deduplicated_identifiers_count_ > 0) {
+    UMA_HISTOGRAM_COUNTS_100000("Brave.CosmeticFilters.ClassIdQueried",
+                                queried_identifiers_count_);
+    UMA_HISTOGRAM_COUNTS_100000("Brave.CosmeticFilters.ClassIdDeduplicated",
+                                deduplicated_identifiers_count_);
+  }
+  engine_generation_.reset();
+  queried_identifiers_count_ = 0;
+  deduplicated_identifiers_count_ = 0;
+}
+
+void CosmeticFiltersJSHandler::OnHiddenClassIdSelectors(
+    const std::vector<std::string>& selectors,
+    uint64_t engine_generation) {
+  const bool engine_changed =
+      engine_generation_ && *engine_generation_ != engine_generation;
+  engine_generation_ = engine_generation;
+
   // If its a vetted engine AND we're not in aggressive
   // mode, don't do cosmetic filtering.
   if (!enabled_1st_party_cf_ && IsVettedSearchEngine(url_))
     return;
 
-  // We expect a List value from adblock service. That is
-  // an extra check to be sure that adblock file exist and gives us
-  // rules that we expect
-  base::ListValue* selectors_list;
-  if (!result.GetAsList(&selectors_list))
-    return;
-
   blink::WebLocalFrame* web_frame = render_frame_->GetWebFrame();
-  std::string json_selectors;
-  if (!base::JSONWriter::Write(*selectors_list, &json_selectors) ||
-      json_selectors.empty()) {
-    json_selectors = "[]";
-  }
-  // Building a script for stylesheet modifications
-  std::string new_selectors_script =
-      base::StringPrintf(kHideSelectorsInjectScript, json_selectors.c_str());
-  if (selectors_list->GetSize() != 0) {
+  if (!selectors.empty()) {
+    // Building a script for stylesheet modifications
+    std::string new_selectors_script = base::StringPrintf(
+        kHideSelectorsInjectScript, ToJSArray(selectors).c_str());
     web_frame->ExecuteScriptInIsolatedWorld(
         isolated_world_id_, blink::WebString::FromUTF8(new_selectors_script));
   }
 
+  // Names answered by older ad block rules may have new selectors now, so
+  // they have to be asked about again.
+  if (engine_changed) {
+    web_frame->ExecuteScriptInIsolatedWorld(
+        isolated_world_id_,
+        blink::WebString::FromUTF8(kResetQueriedIdentifiersScript));
+  }
+
   if (!enabled_1st_party_cf_) {
     web_frame->ExecuteScriptInIsolatedWorld(
         isolated_world_id_, blink::WebString::FromUTF8(*g_observing_script));
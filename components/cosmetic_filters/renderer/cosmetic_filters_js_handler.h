@@ -6,10 +6,13 @@
 #ifndef BRAVE_COMPONENTS_COSMETIC_FILTERS_RENDERER_COSMETIC_FILTERS_JS_HANDLER_H_
 #define BRAVE_COMPONENTS_COSMETIC_FILTERS_RENDERER_COSMETIC_FILTERS_JS_HANDLER_H_
 
-#include <memory>
+#include <stdint.h>
+
 #include <string>
 #include <vector>
 
+#include "base/optional.h"
+#include "base/time/time.h"
 #include "brave/components/cosmetic_filters/common/cosmetic_filters.mojom.h"
 #include "content/public/renderer/render_frame.h"
 #include "content/public/renderer/render_frame_observer.h"
@@ -49,15 +52,23 @@ class CosmeticFiltersJSHandler {
 
   void CreateWorkerObject(v8::Isolate* isolate, v8::Local<v8::Context> context);
 
-  // A function to be called from JS
-  void HiddenClassIdSelectors(const std::string& input);
+  // A function to be called from JS. |deduplicated_count| is how many names
+  // the script skipped because this document had already asked about them.
+  void HiddenClassIdSelectors(const std::vector<std::string>& classes,
+                              const std::vector<std::string>& ids,
+                              int deduplicated_count);
 
   void OnShouldDoCosmeticFiltering(base::OnceClosure callback,
                                    bool enabled,
                                    bool first_party_enabled);
-  void OnUrlCosmeticResources(base::OnceClosure callback, base::Value result);
-  void CSSRulesRoutine(base::DictionaryValue* resources_dict);
-  void OnHiddenClassIdSelectors(base::Value result);
+  void OnUrlCosmeticResources(base::OnceClosure callback,
+                              mojom::UrlCosmeticResourcesPtr resources);
+  void CSSRulesRoutine(const mojom::UrlCosmeticResources& resources);
+  void OnHiddenClassIdSelectors(const std::vector<std::string>& selectors,
+                                uint64_t engine_generation);
+  // Reports how many class and id names the current document asked about,
+  // and resets the per-document state.
+  void ResetQueriedIdentifiers();
 
   content::RenderFrame* render_frame_;
   mojo::Remote<cosmetic_filters::mojom::CosmeticFiltersResources>
@@ -66,7 +77,14 @@ class CosmeticFiltersJSHandler {
   bool enabled_1st_party_cf_;
   std::vector<std::string> exceptions_;
   GURL url_;
-  std::unique_ptr<base::DictionaryValue> resources_dict_;
+  // When the navigation to |url_| was ready to commit.
+  base::TimeTicks process_url_time_;
+  mojom::UrlCosmeticResourcesPtr resources_;
+  // The ad block rules that answered the current document's class and id
+  // names so far.
+  base::Optional<uint64_t> engine_generation_;
+  size_t queried_identifiers_count_ = 0;
+  size_t deduplicated_identifiers_count_ = 0;
 };
 
 // static
@@ -27,6 +27,8 @@ const queriedClasses = new Set<string>()
 // Each of these get setup once the mutation observer starts running.
 let notYetQueriedClasses: string[]
 let notYetQueriedIds: string[]
+// Names skipped since the last query because they were already queried.
+let alreadyQueriedCount = 0
 let cosmeticObserver: MutationObserver | undefined = undefined
 
 window.content_cosmetic = window.content_cosmetic || {}
@@ -96,17 +98,17 @@ const asHTMLElement = (node: Node): HTMLElement | null => {
 
 const fetchNewClassIdRules = () => {
   if ((!notYetQueriedClasses || notYetQueriedClasses.length === 0) &&
-    (!notYetQueriedIds || notYetQueriedIds.length === 0)) {
+    (!notYetQueriedIds || notYetQueriedIds.length === 0) &&
+    alreadyQueriedCount === 0) {
     return
   }
   // Callback to c++ renderer process
   // @ts-ignore
-  cf_worker.hiddenClassIdSelectors(
-      JSON.stringify({
-        classes: notYetQueriedClasses, ids: notYetQueriedIds
-      }))
+  cf_worker.hiddenClassIdSelectors(notYetQueriedClasses || [],
+    notYetQueriedIds || [], alreadyQueriedCount)
   notYetQueriedClasses = []
   notYetQueriedIds = []
+  alreadyQueriedCount = 0
 }
 
 const handleMutations: MutationCallback = (mutations: MutationRecord[]) => {
@@ -121,6 +123,8 @@ const handleMutations: MutationCallback = (mutations: MutationRecord[]) => {
             if (queriedClasses.has(aClassName) === false) {
               notYetQueriedClasses.push(aClassName)
               queriedClasses.add(aClassName)
+            } else {
+              alreadyQueriedCount++
             }
           }
           break
@@ -130,6 +134,8 @@ const handleMutations: MutationCallback = (mutations: MutationRecord[]) => {
           if (queriedIds.has(mutatedId) === false) {
             notYetQueriedIds.push(mutatedId)
             queriedIds.add(mutatedId)
+          } else {
+            alreadyQueriedCount++
           }
           break
       }
@@ -140,16 +146,25 @@ const handleMutations: MutationCallback = (mutations: MutationRecord[]) => {
           continue
         }
         const id = element.id
-        if (id && !queriedIds.has(id)) {
-          notYetQueriedIds.push(id)
-          queriedIds.add(id)
+        if (id) {
+          if (!queriedIds.has(id)) {
+            notYetQueriedIds.push(id)
+            queriedIds.add(id)
+          } else {
+            alreadyQueriedCount++
+          }
         }
         const classList = element.classList
         if (classList) {
           for (const className of classList.values()) {
-            if (className && !queriedClasses.has(className)) {
+            if (!className) {
+              continue
+            }
+            if (!queriedClasses.has(className)) {
               notYetQueriedClasses.push(className)
               queriedClasses.add(className)
+            } else {
+              alreadyQueriedCount++
             }
           }
         }
@@ -510,9 +525,7 @@ const pumpCosmeticFilterQueuesOnIdle = idleize(
   pumpIntervalMaxMs
 )
 
-const startObserving = () => {
-  // First queue up any classes and ids that exist before the mutation observer
-  // starts running.
+const queryExistingClassesAndIds = () => {
   const elmWithClassOrId = document.querySelectorAll('[class],[id]')
   for (const elm of elmWithClassOrId) {
     for (const aClassName of elm.classList.values()) {
@@ -527,6 +540,12 @@ const startObserving = () => {
   notYetQueriedClasses = Array.from(queriedClasses)
   notYetQueriedIds = Array.from(queriedIds)
   fetchNewClassIdRules()
+}
+
+const startObserving = () => {
+  // First queue up any classes and ids that exist before the mutation observer
+  // starts running.
+  queryExistingClassesAndIds()
 
   // Second, set up a mutation observer to handle any new ids or classes
   // that are added to the document.
@@ -539,6 +558,18 @@ const startObserving = () => {
   cosmeticObserver.observe(document.documentElement, observerConfig)
 }
 
+// Called from the renderer once the ad block rules changed, since the
+// selectors for names queried before may have changed with them. Only the
+// instance of this script that started observing has names to forget.
+CC.resetQueriedIdentifiers = CC.resetQueriedIdentifiers || (() => {
+  if (cosmeticObserver === undefined) {
+    return
+  }
+  queriedClasses.clear()
+  queriedIds.clear()
+  queryExistingClassesAndIds()
+})
+
 const scheduleQueuePump = (hide1pContent: boolean, genericHide: boolean) => {
   // Three states possible here.  First, the delay has already occurred.  If so,
   // pass through to pumpCosmeticFilterQueues immediately.
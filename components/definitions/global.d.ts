@@ -90,6 +90,7 @@ declare global {
       alreadyKnownFirstPartySubtrees: WeakSet
       _hasDelayOcurred: boolean
       _startCheckingId: number | undefined
+      resetQueriedIdentifiers: () => void
     }
   }
 }
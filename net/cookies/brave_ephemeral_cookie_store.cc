@@ -0,0 +1,422 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/net/cookies/brave_ephemeral_cookie_store.h"
+
+#include <algorithm>
+
+#include "base/metrics/histogram_macros.h"
+#include "base/stl_util.h"
+#include "net/cookies/cookie_monster.h"
+#include "net/cookies/cookie_util.h"
+
+namespace net {
+
+namespace {
+
+CookieAccessParams MakeCookieAccessParams(const CanonicalCookie& cookie,
+                                          const CookieOptions& options) {
+  // Ephemeral cookies never had a CookieAccessDelegate.
+  return CookieAccessParams(CookieAccessSemantics::UNKNOWN,
+                            false /* delegate_treats_url_as_trustworthy */,
+                            cookie_util::GetSamePartyStatus(cookie, options));
+}
+
+// Same order CookieMonster returns cookies in: longest path first, then
+// oldest first.
+bool CookieSorter(const CookieWithAccessResult& a,
+                  const CookieWithAccessResult& b) {
+  if (a.cookie.Path().length() != b.cookie.Path().length())
+    return a.cookie.Path().length() > b.cookie.Path().length();
+  return a.cookie.CreationDate() < b.cookie.CreationDate();
+}
+
+}  // namespace
+
+EphemeralCookieStore::EphemeralCookieStore()
+    : EphemeralCookieStore(kMaxCookies, kPurgeCookies, kMaxTotalCookies) {}
+
+EphemeralCookieStore::EphemeralCookieStore(size_t max_cookies,
+                                           size_t purge_cookies,
+                                           size_t max_total_cookies)
+    : max_cookies_(max_cookies),
+      purge_cookies_(purge_cookies),
+      max_total_cookies_(max_total_cookies),
+      cookieable_schemes_(CookieMonster::kDefaultCookieableSchemes,
+                          CookieMonster::kDefaultCookieableSchemes +
+                              CookieMonster::kDefaultCookieableSchemesCount) {
+  DCHECK_LT(purge_cookies_, max_cookies_);
+  DCHECK_LE(max_cookies_, max_total_cookies_);
+}
+
+EphemeralCookieStore::~EphemeralCookieStore() = default;
+
+template <typename Predicate>
+uint32_t EphemeralCookieStore::EraseIf(Predicate predicate) {
+  uint32_t num_deleted = 0;
+  for (auto it = cookies_.begin(); it != cookies_.end();) {
+    auto cur = it++;
+    if (predicate(*cur->second)) {
+      EraseCookie(cur);
+      ++num_deleted;
+    }
+  }
+  return num_deleted;
+}
+
+void EphemeralCookieStore::GetCookieListWithOptions(
+    const std::string& partition,
+    const GURL& url,
+    const CookieOptions& options,
+    CookieAccessResultList* included_cookies,
+    CookieAccessResultList* excluded_cookies) {
+  if (!HasCookieableScheme(url))
+    return;
+  if (partitions_.contains(partition))
+    TouchPartition(partition);
+
+  const base::Time now = base::Time::Now();
+  auto range =
+      cookies_.equal_range(Key(partition, CookieMonster::GetKey(url.host())));
+  for (auto it = range.first; it != range.second;) {
+    auto cur = it++;
+    CanonicalCookie* cookie = cur->second.get();
+    if (cookie->IsExpired(now)) {
+      EraseCookie(cur);
+      continue;
+    }
+    CookieAccessResult access_result = cookie->IncludeForRequestURL(
+        url, options, MakeCookieAccessParams(*cookie, options));
+    if (!access_result.status.IsInclude()) {
+      excluded_cookies->push_back({*cookie, access_result});
+      continue;
+    }
+    if (options.update_access_time())
+      cookie->SetLastAccessDate(now);
+    included_cookies->push_back({*cookie, access_result});
+  }
+  std::sort(included_cookies->begin(), included_cookies->end(), CookieSorter);
+}
+
+CookieAccessResult EphemeralCookieStore::SetCanonicalCookie(
+    const std::string& partition,
+    std::unique_ptr<CanonicalCookie> cookie,
+    const GURL& source_url,
+    const CookieOptions& options) {
+  DCHECK(cookie->IsCanonical());
+  CookieAccessResult access_result = cookie->IsSetPermittedInContext(
+      source_url, options, MakeCookieAccessParams(*cookie, options),
+      cookieable_schemes_);
+  if (!access_result.status.IsInclude())
+    return access_result;
+
+  // Mirrors CookieMonster::MaybeDeleteEquivalentCookieAndUpdateStatus: an
+  // insecure origin can't shadow a secure cookie, and script can't replace an
+  // HttpOnly one.
+  const Key key(partition, CookieMonster::GetKey(cookie->Domain()));
+  auto range = cookies_.equal_range(key);
+  std::vector<CookieIt> equivalent_cookies;
+  for (auto it = range.first; it != range.second; ++it) {
+    const CanonicalCookie& existing = *it->second;
+    if (!source_url.SchemeIsCryptographic() && existing.IsSecure() &&
+        cookie->IsEquivalentForSecureCookieMatching(existing)) {
+      access_result.status.AddExclusionReason(
+          CookieInclusionStatus::EXCLUDE_OVERWRITE_SECURE);
+    } else if (cookie->IsEquivalent(existing)) {
+      if (existing.IsHttpOnly() && options.exclude_httponly()) {
+        access_result.status.AddExclusionReason(
+            CookieInclusionStatus::EXCLUDE_OVERWRITE_HTTP_ONLY);
+      } else {
+        // Like CookieMonster, rewriting a cookie with the same value keeps
+        // its creation date.
+        if (existing.Value() == cookie->Value())
+          cookie->SetCreationDate(existing.CreationDate());
+        equivalent_cookies.push_back(it);
+      }
+    }
+  }
+  if (!access_result.status.IsInclude())
+    return access_result;
+
+  for (CookieIt it : equivalent_cookies)
+    EraseCookie(it);
+
+  // Setting an already expired cookie only deletes the one it replaces.
+  if (!cookie->IsExpired(base::Time::Now())) {
+    InsertCookie(partition, std::move(cookie));
+    GarbageCollect(key);
+  }
+  return access_result;
+}
+
+uint32_t EphemeralCookieStore::DeleteCanonicalCookie(
+    const CanonicalCookie& cookie) {
+  const std::string cookie_key = CookieMonster::GetKey(cookie.Domain());
+  std::vector<CookieIt> matching_cookies;
+  for (const auto& partition : partitions_) {
+    auto range = cookies_.equal_range(Key(partition.first, cookie_key));
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second->IsEquivalent(cookie) &&
+          it->second->Value() == cookie.Value()) {
+        matching_cookies.push_back(it);
+      }
+    }
+  }
+  for (CookieIt it : matching_cookies)
+    EraseCookie(it);
+  return matching_cookies.size();
+}
+
+uint32_t EphemeralCookieStore::DeleteAllCreatedInTimeRange(
+    const CookieDeletionInfo::TimeRange& creation_range) {
+  return EraseIf([&creation_range](const CanonicalCookie& cookie) {
+    return creation_range.Contains(cookie.CreationDate());
+  });
+}
+
+uint32_t EphemeralCookieStore::DeleteAllMatchingInfo(
+    const CookieDeletionInfo& delete_info) {
+  return EraseIf([&delete_info](const CanonicalCookie& cookie) {
+    return delete_info.Matches(
+        cookie,
+        CookieAccessParams(CookieAccessSemantics::UNKNOWN,
+                           false /* delegate_treats_url_as_trustworthy */,
+                           CookieSamePartyStatus::kNoSamePartyEnforcement));
+  });
+}
+
+uint32_t EphemeralCookieStore::DeleteSessionCookies() {
+  return EraseIf(
+      [](const CanonicalCookie& cookie) { return !cookie.IsPersistent(); });
+}
+
+uint32_t EphemeralCookieStore::DeletePartition(const std::string& partition) {
+  auto range = PartitionRange(partition);
+  uint32_t num_deleted = std::distance(range.first, range.second);
+  cookies_.erase(range.first, range.second);
+  partitions_.erase(partition);
+  return num_deleted;
+}
+
+void EphemeralCookieStore::SetCookieableSchemes(
+    const std::vector<std::string>& schemes) {
+  cookieable_schemes_ = schemes;
+}
+
+EphemeralCookieStore::CookieIt EphemeralCookieStore::InsertCookie(
+    const std::string& partition,
+    std::unique_ptr<CanonicalCookie> cookie) {
+  const size_t num_partitions = partitions_.size();
+  ++partitions_[partition].cookie_count;
+  if (partitions_.size() != num_partitions) {
+    UMA_HISTOGRAM_COUNTS_1000("Brave.EphemeralCookieStore.Partitions",
+                              partitions_.size());
+  }
+  TouchPartition(partition);
+  std::string cookie_key = CookieMonster::GetKey(cookie->Domain());
+  return cookies_.emplace(Key(partition, std::move(cookie_key)),
+                          std::move(cookie));
+}
+
+void EphemeralCookieStore::EraseCookie(CookieIt it) {
+  auto partition = partitions_.find(it->first.first);
+  DCHECK(partition != partitions_.end());
+  if (--partition->second.cookie_count == 0)
+    partitions_.erase(partition);
+  cookies_.erase(it);
+}
+
+std::pair<EphemeralCookieStore::CookieIt, EphemeralCookieStore::CookieIt>
+EphemeralCookieStore::PartitionRange(const std::string& partition) {
+  // The empty cookie key sorts first, so this is the start of the partition.
+  auto begin = cookies_.lower_bound(Key(partition, std::string()));
+  auto end = begin;
+  while (end != cookies_.end() && end->first.first == partition)
+    ++end;
+  return {begin, end};
+}
+
+void EphemeralCookieStore::TouchPartition(const std::string& partition) {
+  // A counter rather than a time, so no two partitions tie.
+  partitions_[partition].last_access = ++partition_access_count_;
+}
+
+std::vector<EphemeralCookieStore::CookieIt>
+EphemeralCookieStore::EraseExpiredAndSortByAccess(CookieIt begin,
+                                                  CookieIt end,
+                                                  size_t* num_erased) {
+  const base::Time now = base::Time::Now();
+  std::vector<CookieIt> cookies;
+  for (auto it = begin; it != end;) {
+    auto cur = it++;
+    if (cur->second->IsExpired(now)) {
+      EraseCookie(cur);
+      ++*num_erased;
+    } else {
+      cookies.push_back(cur);
+    }
+  }
+  // CookieMonster's LRACookieSorter. Sorting stably leaves cookies accessed
+  // and created at the same time in index order instead of an unspecified
+  // one.
+  std::stable_sort(cookies.begin(), cookies.end(), [](CookieIt a, CookieIt b) {
+    if (a->second->LastAccessDate() != b->second->LastAccessDate())
+      return a->second->LastAccessDate() < b->second->LastAccessDate();
+    return a->second->CreationDate() < b->second->CreationDate();
+  });
+  return cookies;
+}
+
+size_t EphemeralCookieStore::PurgeLeastRecentMatches(
+    std::vector<CookieIt>* cookies,
+    CookiePriority priority,
+    size_t to_protect,
+    size_t purge_goal,
+    bool protect_secure_cookies) {
+  size_t num_at_priority = 0;
+  size_t num_secure_at_priority = 0;
+  for (CookieIt it : *cookies) {
+    if (it->second->Priority() != priority)
+      continue;
+    ++num_at_priority;
+    if (it->second->IsSecure())
+      ++num_secure_at_priority;
+  }
+  if (num_at_priority <= to_protect)
+    return 0;
+  size_t num_deletable =
+      num_at_priority -
+      (protect_secure_cookies ? std::max(num_secure_at_priority, to_protect)
+                              : to_protect);
+
+  size_t num_removed = 0;
+  for (auto it = cookies->begin();
+       it != cookies->end() && num_removed < purge_goal && num_deletable > 0;) {
+    const CanonicalCookie& cookie = *(*it)->second;
+    if (cookie.Priority() == priority &&
+        !(protect_secure_cookies && cookie.IsSecure())) {
+      EraseCookie(*it);
+      it = cookies->erase(it);
+      ++num_removed;
+      --num_deletable;
+    } else {
+      ++it;
+    }
+  }
+  return num_removed;
+}
+
+size_t EphemeralCookieStore::GarbageCollectDomain(CookieIt begin,
+                                                  CookieIt end) {
+  if (static_cast<size_t>(std::distance(begin, end)) <= kDomainMaxCookies)
+    return 0;
+
+  size_t num_deleted = 0;
+  std::vector<CookieIt> cookies =
+      EraseExpiredAndSortByAccess(begin, end, &num_deleted);
+  if (cookies.size() <= kDomainMaxCookies)
+    return num_deleted;
+
+  // Same rounds as CookieMonster::GarbageCollect: non-secure cookies of each
+  // priority go before secure ones, and each priority keeps its quota.
+  static constexpr struct {
+    CookiePriority priority;
+    bool protect_secure_cookies;
+  } kPurgeRounds[] = {
+      {COOKIE_PRIORITY_LOW, true},     {COOKIE_PRIORITY_LOW, false},
+      {COOKIE_PRIORITY_MEDIUM, true},  {COOKIE_PRIORITY_HIGH, true},
+      {COOKIE_PRIORITY_MEDIUM, false}, {COOKIE_PRIORITY_HIGH, false},
+  };
+  size_t purge_goal =
+      cookies.size() - (kDomainMaxCookies - kDomainPurgeCookies);
+  for (const auto& round : kPurgeRounds) {
+    if (purge_goal == 0)
+      break;
+    size_t quota = 0;
+    switch (round.priority) {
+      case COOKIE_PRIORITY_LOW:
+        quota = kDomainCookiesQuotaLow;
+        break;
+      case COOKIE_PRIORITY_MEDIUM:
+        quota = kDomainCookiesQuotaMedium;
+        break;
+      case COOKIE_PRIORITY_HIGH:
+        quota = kDomainCookiesQuotaHigh;
+        break;
+    }
+    const size_t num_removed = PurgeLeastRecentMatches(
+        &cookies, round.priority, quota, purge_goal,
+        round.protect_secure_cookies);
+    purge_goal -= num_removed;
+    num_deleted += num_removed;
+  }
+  return num_deleted;
+}
+
+size_t EphemeralCookieStore::GarbageCollectPartition(
+    const std::string& partition) {
+  auto info = partitions_.find(partition);
+  if (info == partitions_.end() || info->second.cookie_count <= max_cookies_)
+    return 0;
+
+  auto range = PartitionRange(partition);
+  size_t num_deleted = 0;
+  std::vector<CookieIt> cookies =
+      EraseExpiredAndSortByAccess(range.first, range.second, &num_deleted);
+  if (cookies.size() <= max_cookies_)
+    return num_deleted;
+
+  // CookieMonster evicts the least recently accessed non-secure cookies and
+  // then secure ones, but only cookies older than its 30 day safe date. Every
+  // cookie here is from this session, so there's no safe date.
+  std::stable_partition(cookies.begin(), cookies.end(), [](CookieIt it) {
+    return !it->second->IsSecure();
+  });
+  const size_t purge_goal = cookies.size() - (max_cookies_ - purge_cookies_);
+  for (size_t i = 0; i < purge_goal; ++i)
+    EraseCookie(cookies[i]);
+  return num_deleted + purge_goal;
+}
+
+void EphemeralCookieStore::EvictPartitions(const std::string& partition) {
+  size_t num_evicted = 0;
+  while (cookies_.size() > max_total_cookies_) {
+    auto lru = partitions_.end();
+    for (auto it = partitions_.begin(); it != partitions_.end(); ++it) {
+      if (it->first != partition &&
+          (lru == partitions_.end() ||
+           it->second.last_access < lru->second.last_access)) {
+        lru = it;
+      }
+    }
+    if (lru == partitions_.end())
+      break;
+    // DeletePartition() erases the entry the name is in.
+    const std::string lru_partition = lru->first;
+    DeletePartition(lru_partition);
+    ++num_evicted;
+  }
+  if (num_evicted > 0) {
+    UMA_HISTOGRAM_COUNTS_100("Brave.EphemeralCookieStore.EvictedPartitions",
+                             num_evicted);
+  }
+}
+
+void EphemeralCookieStore::GarbageCollect(const Key& key) {
+  auto range = cookies_.equal_range(key);
+  size_t num_evicted = GarbageCollectDomain(range.first, range.second);
+  num_evicted += GarbageCollectPartition(key.first);
+  if (num_evicted > 0) {
+    UMA_HISTOGRAM_COUNTS_1000("Brave.EphemeralCookieStore.EvictedCookies",
+                              num_evicted);
+  }
+  EvictPartitions(key.first);
+}
+
+bool EphemeralCookieStore::HasCookieableScheme(const GURL& url) const {
+  return base::Contains(cookieable_schemes_, url.scheme());
+}
+
+}  // namespace net
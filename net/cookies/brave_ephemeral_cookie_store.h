@@ -0,0 +1,145 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_NET_COOKIES_BRAVE_EPHEMERAL_COOKIE_STORE_H_
+#define BRAVE_NET_COOKIES_BRAVE_EPHEMERAL_COOKIE_STORE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "net/base/net_export.h"
+#include "net/cookies/canonical_cookie.h"
+#include "net/cookies/cookie_access_result.h"
+#include "net/cookies/cookie_constants.h"
+#include "net/cookies/cookie_deletion_info.h"
+#include "net/cookies/cookie_options.h"
+#include "url/gurl.h"
+
+namespace net {
+
+// In-memory cookies for ephemeral storage, partitioned by the ephemeral
+// storage domain of the top frame. All partitions share one index ordered by
+// (partition, cookie key), so a partition is a contiguous range: lookups and
+// teardown only touch that partition, and deletions that apply to every
+// partition are a single pass instead of one per store.
+//
+// Each partition is garbage collected like a CookieMonster of its own, except
+// that recently accessed cookies aren't safe from the partition-wide purge,
+// since no ephemeral cookie outlives the session. The store as a whole is
+// bounded by dropping the least recently used partitions.
+class NET_EXPORT EphemeralCookieStore {
+ public:
+  // Same limits CookieMonster applies to a single store, applied per
+  // partition.
+  static constexpr size_t kMaxCookies = 3300;
+  static constexpr size_t kPurgeCookies = 300;
+  static constexpr size_t kDomainMaxCookies = 180;
+  static constexpr size_t kDomainPurgeCookies = 30;
+  // CookieMonster's per-domain quotas, by cookie priority.
+  static constexpr size_t kDomainCookiesQuotaLow = 30;
+  static constexpr size_t kDomainCookiesQuotaMedium = 50;
+  static constexpr size_t kDomainCookiesQuotaHigh =
+      kDomainMaxCookies - kDomainPurgeCookies - kDomainCookiesQuotaLow -
+      kDomainCookiesQuotaMedium;
+  // Bound on the cookies of all partitions together.
+  static constexpr size_t kMaxTotalCookies = 10000;
+
+  EphemeralCookieStore();
+  EphemeralCookieStore(size_t max_cookies,
+                       size_t purge_cookies,
+                       size_t max_total_cookies);
+  EphemeralCookieStore(const EphemeralCookieStore&) = delete;
+  EphemeralCookieStore& operator=(const EphemeralCookieStore&) = delete;
+  ~EphemeralCookieStore();
+
+  void GetCookieListWithOptions(const std::string& partition,
+                                const GURL& url,
+                                const CookieOptions& options,
+                                CookieAccessResultList* included_cookies,
+                                CookieAccessResultList* excluded_cookies);
+  CookieAccessResult SetCanonicalCookie(const std::string& partition,
+                                        std::unique_ptr<CanonicalCookie> cookie,
+                                        const GURL& source_url,
+                                        const CookieOptions& options);
+
+  // These apply to every partition and return the number of cookies deleted.
+  uint32_t DeleteCanonicalCookie(const CanonicalCookie& cookie);
+  uint32_t DeleteAllCreatedInTimeRange(
+      const CookieDeletionInfo::TimeRange& creation_range);
+  uint32_t DeleteAllMatchingInfo(const CookieDeletionInfo& delete_info);
+  uint32_t DeleteSessionCookies();
+
+  // Drops every cookie of |partition|.
+  uint32_t DeletePartition(const std::string& partition);
+
+  void SetCookieableSchemes(const std::vector<std::string>& schemes);
+
+  size_t cookie_count() const { return cookies_.size(); }
+  size_t partition_count() const { return partitions_.size(); }
+
+ private:
+  // (partition, CookieMonster::GetKey(cookie domain)).
+  using Key = std::pair<std::string, std::string>;
+  using CookieMap =
+      std::multimap<Key, std::unique_ptr<CanonicalCookie>, std::less<>>;
+  using CookieIt = CookieMap::iterator;
+
+  struct Partition {
+    size_t cookie_count = 0;
+    // Value of |partition_access_count_| when the partition was last used.
+    uint64_t last_access = 0;
+  };
+
+  CookieIt InsertCookie(const std::string& partition,
+                        std::unique_ptr<CanonicalCookie> cookie);
+  void EraseCookie(CookieIt it);
+  std::pair<CookieIt, CookieIt> PartitionRange(const std::string& partition);
+  void TouchPartition(const std::string& partition);
+
+  // Erases the expired cookies in [begin, end) and returns the others, least
+  // recently accessed first. Ties are broken by creation date and then by
+  // index order, so the eviction order is always defined.
+  std::vector<CookieIt> EraseExpiredAndSortByAccess(CookieIt begin,
+                                                    CookieIt end,
+                                                    size_t* num_erased);
+  // CookieMonster::PurgeLeastRecentMatches for a sorted |cookies|.
+  size_t PurgeLeastRecentMatches(std::vector<CookieIt>* cookies,
+                                 CookiePriority priority,
+                                 size_t to_protect,
+                                 size_t purge_goal,
+                                 bool protect_secure_cookies);
+  // Evict the cookies of one domain range or one partition once they are over
+  // their limit, and return the number of cookies deleted.
+  size_t GarbageCollectDomain(CookieIt begin, CookieIt end);
+  size_t GarbageCollectPartition(const std::string& partition);
+  // Drops whole partitions, least recently used first, other than
+  // |partition| until the store is within |max_total_cookies_|.
+  void EvictPartitions(const std::string& partition);
+  void GarbageCollect(const Key& key);
+
+  // Deletes the cookies of every partition |predicate| returns true for.
+  template <typename Predicate>
+  uint32_t EraseIf(Predicate predicate);
+
+  bool HasCookieableScheme(const GURL& url) const;
+
+  const size_t max_cookies_;
+  const size_t purge_cookies_;
+  const size_t max_total_cookies_;
+  CookieMap cookies_;
+  base::flat_map<std::string, Partition> partitions_;
+  uint64_t partition_access_count_ = 0;
+  std::vector<std::string> cookieable_schemes_;
+};
+
+}  // namespace net
+
+#endif  // BRAVE_NET_COOKIES_BRAVE_EPHEMERAL_COOKIE_STORE_H_
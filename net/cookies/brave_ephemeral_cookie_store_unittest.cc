@@ -0,0 +1,362 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/net/cookies/brave_ephemeral_cookie_store.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/metrics/histogram_tester.h"
+#include "base/test/task_environment.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/cookies/cookie_monster.h"
+#include "net/cookies/cookie_store.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace net {
+
+namespace {
+
+constexpr size_t kPerfPartitions = 500;
+constexpr size_t kPerfCookiesPerPartition = 10;
+
+std::unique_ptr<CanonicalCookie> MakeCookie(
+    const GURL& url,
+    const std::string& line,
+    base::Time creation_time = base::Time::Now()) {
+  return CanonicalCookie::Create(url, line, creation_time, base::nullopt);
+}
+
+std::string PartitionName(size_t i) {
+  return base::StringPrintf("site%zu.com", i);
+}
+
+GURL ThirdPartyURL(size_t i) {
+  return GURL(base::StringPrintf("https://tracker%zu.com/", i));
+}
+
+}  // namespace
+
+class EphemeralCookieStoreTest : public testing::Test {
+ protected:
+  CookieAccessResult Set(const std::string& partition,
+                         const GURL& url,
+                         const std::string& line) {
+    return store_.SetCanonicalCookie(partition, MakeCookie(url, line), url,
+                                     CookieOptions::MakeAllInclusive());
+  }
+
+  std::vector<std::string> Get(const std::string& partition, const GURL& url) {
+    CookieAccessResultList included;
+    CookieAccessResultList excluded;
+    store_.GetCookieListWithOptions(partition, url,
+                                    CookieOptions::MakeAllInclusive(),
+                                    &included, &excluded);
+    std::vector<std::string> lines;
+    for (const auto& cookie : included)
+      lines.push_back(cookie.cookie.Name() + "=" + cookie.cookie.Value());
+    return lines;
+  }
+
+  size_t CountWithPrefix(const std::string& partition,
+                         const GURL& url,
+                         const std::string& prefix) {
+    const std::vector<std::string> lines = Get(partition, url);
+    return std::count_if(lines.begin(), lines.end(),
+                         [&prefix](const std::string& line) {
+                           return base::StartsWith(line, prefix);
+                         });
+  }
+
+  base::test::TaskEnvironment task_environment_;
+  EphemeralCookieStore store_;
+};
+
+TEST_F(EphemeralCookieStoreTest, PartitionsAreIsolated) {
+  const GURL url("https://tracker.com/");
+  EXPECT_TRUE(Set("a.com", url, "id=a").status.IsInclude());
+  EXPECT_TRUE(Set("b.com", url, "id=b").status.IsInclude());
+
+  EXPECT_EQ(std::vector<std::string>{"id=a"}, Get("a.com", url));
+  EXPECT_EQ(std::vector<std::string>{"id=b"}, Get("b.com", url));
+  EXPECT_TRUE(Get("c.com", url).empty());
+  EXPECT_EQ(2u, store_.partition_count());
+}
+
+TEST_F(EphemeralCookieStoreTest, ReplacesEquivalentCookie) {
+  const GURL url("https://tracker.com/");
+  Set("a.com", url, "id=1");
+  Set("a.com", url, "id=2");
+  EXPECT_EQ(std::vector<std::string>{"id=2"}, Get("a.com", url));
+  EXPECT_EQ(1u, store_.cookie_count());
+
+  // An already expired cookie just deletes the one it matches.
+  Set("a.com", url, "id=3; max-age=-1");
+  EXPECT_TRUE(Get("a.com", url).empty());
+  EXPECT_EQ(0u, store_.partition_count());
+}
+
+TEST_F(EphemeralCookieStoreTest, DeletePartition) {
+  const GURL url("https://tracker.com/");
+  Set("a.com", url, "id=a");
+  Set("a.com", GURL("https://other.com/"), "id=a");
+  Set("b.com", url, "id=b");
+
+  EXPECT_EQ(2u, store_.DeletePartition("a.com"));
+  EXPECT_TRUE(Get("a.com", url).empty());
+  EXPECT_EQ(std::vector<std::string>{"id=b"}, Get("b.com", url));
+  EXPECT_EQ(0u, store_.DeletePartition("a.com"));
+}
+
+TEST_F(EphemeralCookieStoreTest, DeletionsApplyToEveryPartition) {
+  const GURL url("https://tracker.com/");
+  Set("a.com", url, "id=1");
+  Set("b.com", url, "id=1");
+  Set("c.com", url, "id=2");
+
+  EXPECT_EQ(2u, store_.DeleteCanonicalCookie(*MakeCookie(url, "id=1")));
+  EXPECT_EQ(std::vector<std::string>{"id=2"}, Get("c.com", url));
+
+  Set("c.com", url, "persistent=1; max-age=3600");
+  EXPECT_EQ(1u, store_.DeleteSessionCookies());
+  EXPECT_EQ(std::vector<std::string>{"persistent=1"}, Get("c.com", url));
+}
+
+TEST_F(EphemeralCookieStoreTest, EvictsLeastRecentlyAccessed) {
+  base::HistogramTester histograms;
+  EphemeralCookieStore store(10, 3, 100);
+  const CookieOptions options = CookieOptions::MakeAllInclusive();
+  const base::Time start = base::Time::Now();
+  // The other partition is older but isn't over the cap, so it's untouched.
+  store.SetCanonicalCookie(
+      PartitionName(1),
+      MakeCookie(ThirdPartyURL(0), "id=1",
+                 start - base::TimeDelta::FromDays(1)),
+      ThirdPartyURL(0), options);
+  for (size_t i = 0; i < 11; ++i) {
+    // Distinct creation (and so last access) times keep the order stable.
+    store.SetCanonicalCookie(
+        PartitionName(0),
+        MakeCookie(ThirdPartyURL(i), "id=1",
+                   start + base::TimeDelta::FromSeconds(i)),
+        ThirdPartyURL(i), options);
+  }
+  EXPECT_EQ(8u, store.cookie_count());
+  histograms.ExpectUniqueSample("Brave.EphemeralCookieStore.EvictedCookies", 4,
+                                1);
+
+  // The newest cookies of the full partition survive.
+  CookieAccessResultList included;
+  CookieAccessResultList excluded;
+  CookieOptions no_access_update = options;
+  no_access_update.set_do_not_update_access_time();
+  store.GetCookieListWithOptions(PartitionName(0), ThirdPartyURL(10),
+                                 no_access_update, &included, &excluded);
+  EXPECT_EQ(1u, included.size());
+  included.clear();
+  store.GetCookieListWithOptions(PartitionName(0), ThirdPartyURL(0),
+                                 no_access_update, &included, &excluded);
+  EXPECT_TRUE(included.empty());
+  store.GetCookieListWithOptions(PartitionName(1), ThirdPartyURL(0),
+                                 no_access_update, &included, &excluded);
+  EXPECT_EQ(1u, included.size());
+}
+
+// A domain over its limit is trimmed in CookieMonster's priority and
+// secure-cookie rounds, not by access time alone.
+TEST_F(EphemeralCookieStoreTest, DomainEvictionFollowsPriority) {
+  const GURL url("https://tracker.com/");
+  const CookieOptions options = CookieOptions::MakeAllInclusive();
+  const base::Time start = base::Time::Now() - base::TimeDelta::FromHours(1);
+  // The secure medium priority cookies are all older than the low priority
+  // ones, so plain LRU would evict only them.
+  for (size_t i = 0; i < 150; ++i) {
+    store_.SetCanonicalCookie(
+        "a.com",
+        MakeCookie(url, base::StringPrintf("medium%zu=1; Secure", i),
+                   start + base::TimeDelta::FromSeconds(i)),
+        url, options);
+  }
+  for (size_t i = 0; i < 31; ++i) {
+    store_.SetCanonicalCookie(
+        "a.com",
+        MakeCookie(url, base::StringPrintf("low%zu=1; Priority=Low", i),
+                   start + base::TimeDelta::FromSeconds(200 + i)),
+        url, options);
+  }
+
+  // One low priority cookie goes to get the low ones down to their quota,
+  // the other 30 are the oldest secure medium priority ones.
+  EXPECT_EQ(150u, store_.cookie_count());
+  EXPECT_EQ(30u, CountWithPrefix("a.com", url, "low"));
+  EXPECT_EQ(0u, CountWithPrefix("a.com", url, "low0="));
+  EXPECT_EQ(120u, CountWithPrefix("a.com", url, "medium"));
+  EXPECT_EQ(0u, CountWithPrefix("a.com", url, "medium29="));
+  EXPECT_EQ(1u, CountWithPrefix("a.com", url, "medium30="));
+}
+
+// Unlike CookieMonster, the partition-wide purge doesn't spare cookies
+// accessed in the last 30 days, as every ephemeral cookie is. Non-secure
+// cookies still go first.
+TEST_F(EphemeralCookieStoreTest, PartitionEvictionHasNoSafeDate) {
+  EphemeralCookieStore store(10, 3, 100);
+  const CookieOptions options = CookieOptions::MakeAllInclusive();
+  const base::Time start = base::Time::Now();
+  for (size_t i = 0; i < 11; ++i) {
+    store.SetCanonicalCookie(
+        "a.com",
+        MakeCookie(ThirdPartyURL(i), i < 5 ? "id=1; Secure" : "id=1",
+                   start + base::TimeDelta::FromSeconds(i)),
+        ThirdPartyURL(i), options);
+  }
+  EXPECT_EQ(7u, store.cookie_count());
+
+  CookieOptions no_access_update = options;
+  no_access_update.set_do_not_update_access_time();
+  for (size_t i = 0; i < 11; ++i) {
+    SCOPED_TRACE(i);
+    CookieAccessResultList included;
+    CookieAccessResultList excluded;
+    store.GetCookieListWithOptions("a.com", ThirdPartyURL(i),
+                                   no_access_update, &included, &excluded);
+    EXPECT_EQ(i < 5 || i > 8 ? 1u : 0u, included.size());
+  }
+}
+
+// Cookies accessed and created at the same time are evicted in index order,
+// so the result doesn't depend on the sort implementation.
+TEST_F(EphemeralCookieStoreTest, EvictionTiesFollowIndexOrder) {
+  EphemeralCookieStore store(10, 3, 100);
+  const CookieOptions options = CookieOptions::MakeAllInclusive();
+  const base::Time start = base::Time::Now();
+  for (size_t i = 0; i < 11; ++i) {
+    store.SetCanonicalCookie("a.com",
+                             MakeCookie(ThirdPartyURL(i), "id=1", start),
+                             ThirdPartyURL(i), options);
+  }
+
+  // tracker0, tracker1, tracker10 and tracker2 sort first.
+  CookieOptions no_access_update = options;
+  no_access_update.set_do_not_update_access_time();
+  for (size_t i = 0; i < 11; ++i) {
+    SCOPED_TRACE(i);
+    CookieAccessResultList included;
+    CookieAccessResultList excluded;
+    store.GetCookieListWithOptions("a.com", ThirdPartyURL(i),
+                                   no_access_update, &included, &excluded);
+    EXPECT_EQ(i < 3 || i == 10 ? 0u : 1u, included.size());
+  }
+}
+
+TEST_F(EphemeralCookieStoreTest, SameValueKeepsCreationDate) {
+  const GURL url("https://tracker.com/");
+  const CookieOptions options = CookieOptions::MakeAllInclusive();
+  const base::Time created = base::Time::Now() - base::TimeDelta::FromHours(1);
+  store_.SetCanonicalCookie("a.com", MakeCookie(url, "id=1", created), url,
+                            options);
+  auto get_creation_date = [&]() {
+    CookieAccessResultList included;
+    CookieAccessResultList excluded;
+    store_.GetCookieListWithOptions("a.com", url, options, &included,
+                                    &excluded);
+    EXPECT_EQ(1u, included.size());
+    return included.empty() ? base::Time() : included[0].cookie.CreationDate();
+  };
+
+  Set("a.com", url, "id=1");
+  EXPECT_EQ(created, get_creation_date());
+  Set("a.com", url, "id=2");
+  EXPECT_LT(created, get_creation_date());
+}
+
+// Past the store-wide limit, whole partitions go, least recently used first.
+TEST_F(EphemeralCookieStoreTest, EvictsLeastRecentlyUsedPartitions) {
+  base::HistogramTester histograms;
+  EphemeralCookieStore store(10, 3, 20);
+  const CookieOptions options = CookieOptions::MakeAllInclusive();
+  auto fill = [&](size_t partition) {
+    for (size_t i = 0; i < 8; ++i) {
+      store.SetCanonicalCookie(PartitionName(partition),
+                               MakeCookie(ThirdPartyURL(i), "id=1"),
+                               ThirdPartyURL(i), options);
+    }
+  };
+  fill(0);
+  fill(1);
+  // Reading partition 0 makes partition 1 the least recently used.
+  CookieAccessResultList included;
+  CookieAccessResultList excluded;
+  store.GetCookieListWithOptions(PartitionName(0), ThirdPartyURL(0), options,
+                                 &included, &excluded);
+  EXPECT_EQ(1u, included.size());
+  fill(2);
+
+  EXPECT_EQ(2u, store.partition_count());
+  EXPECT_EQ(16u, store.cookie_count());
+  EXPECT_EQ(0u, store.DeletePartition(PartitionName(1)));
+  histograms.ExpectUniqueSample("Brave.EphemeralCookieStore.EvictedPartitions",
+                                1, 1);
+  histograms.ExpectTotalCount("Brave.EphemeralCookieStore.EvictedCookies", 0);
+  histograms.ExpectTotalCount("Brave.EphemeralCookieStore.Partitions", 3);
+}
+
+// Compares one shared store with a CookieMonster per partition, which is how
+// ephemeral cookies used to be kept.
+TEST_F(EphemeralCookieStoreTest, PartitionsPerf) {
+  const CookieOptions options = CookieOptions::MakeAllInclusive();
+  CookieDeletionInfo::TimeRange everything;
+
+  base::ElapsedTimer monsters_timer;
+  {
+    std::vector<std::unique_ptr<ChromiumCookieMonster>> monsters;
+    for (size_t i = 0; i < kPerfPartitions; ++i) {
+      monsters.push_back(
+          std::make_unique<ChromiumCookieMonster>(nullptr, nullptr));
+      for (size_t j = 0; j < kPerfCookiesPerPartition; ++j) {
+        monsters.back()->SetCanonicalCookieAsync(
+            MakeCookie(ThirdPartyURL(j), "id=1"), ThirdPartyURL(j), options,
+            CookieStore::SetCookiesCallback());
+      }
+    }
+    for (auto& monster : monsters) {
+      monster->DeleteAllCreatedInTimeRangeAsync(everything,
+                                                CookieStore::DeleteCallback());
+    }
+  }
+  const double monsters_ms = monsters_timer.Elapsed().InMillisecondsF();
+
+  base::ElapsedTimer store_timer;
+  {
+    EphemeralCookieStore store;
+    for (size_t i = 0; i < kPerfPartitions; ++i) {
+      for (size_t j = 0; j < kPerfCookiesPerPartition; ++j) {
+        store.SetCanonicalCookie(PartitionName(i),
+                                 MakeCookie(ThirdPartyURL(j), "id=1"),
+                                 ThirdPartyURL(j), options);
+      }
+    }
+    EXPECT_EQ(kPerfPartitions, store.partition_count());
+    EXPECT_EQ(kPerfPartitions * kPerfCookiesPerPartition,
+              store.cookie_count());
+    store.DeleteAllCreatedInTimeRange(everything);
+    EXPECT_EQ(0u, store.cookie_count());
+  }
+  const double store_ms = store_timer.Elapsed().InMillisecondsF();
+
+  perf_test::PerfResultReporter reporter("EphemeralCookieStore",
+                                         "500_partitions");
+  reporter.RegisterImportantMetric(".per_partition_monsters", "ms");
+  reporter.RegisterImportantMetric(".partitioned_store", "ms");
+  reporter.AddResult(".per_partition_monsters", monsters_ms);
+  reporter.AddResult(".partitioned_store", store_ms);
+}
+
+}  // namespace net
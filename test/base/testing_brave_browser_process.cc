@@ -88,6 +88,12 @@ TestingBraveBrowserProcess::local_data_files_service() {
   return nullptr;
 }
 
+brave_shields::QueryStringTrackersService*
+TestingBraveBrowserProcess::query_string_trackers_service() {
+  NOTREACHED();
+  return nullptr;
+}
+
 #if BUILDFLAG(ENABLE_TOR)
 tor::BraveTorClientUpdater* TestingBraveBrowserProcess::tor_client_updater() {
   return nullptr;
@@ -56,6 +56,8 @@ class TestingBraveBrowserProcess : public BraveBrowserProcess {
   brave_shields::HTTPSEverywhereService* https_everywhere_service() override;
   brave_component_updater::LocalDataFilesService* local_data_files_service()
       override;
+  brave_shields::QueryStringTrackersService* query_string_trackers_service()
+      override;
 #if BUILDFLAG(ENABLE_TOR)
   tor::BraveTorClientUpdater* tor_client_updater() override;
 #endif